@@ -213,11 +213,11 @@ private:
 		qs0.addPrefix("rdf", PREFIX_RDF);
 		qs0.addPrefix("pp", PREFIX_PP);
 		qs0.setVariables("?nameComponent");
-		qs0.addCondition(string("<") + _node + "> pp:nodeName [ ?li ?nameComponent ]");
+		qs0.addCondition("$node pp:nodeName [ ?li ?nameComponent ]");
 		qs0.addCondition("FILTER( ?li != rdf:type )");
 			
-		Query q0(world, qs0);
-		QueryResults qr0 = q0->execute( model );
+		Query q0 = world->preparedQuery( qs0 );
+		QueryResults qr0 = q0->execute( model, Bindings{ { "node", world->intern( _node ) } } );
 
 		// while(qr0->success())
 		for( auto &qi0 : *qr0 )
@@ -232,12 +232,12 @@ private:
 			{
 				QueryString qs1;
 				qs1.setVariables("?propertyValue");
-				qs1.addCondition(string("<") + fileProjection.getUri()
-					+ "> <" + nameComponent->toURI()->toString() 
-					+ "> ?propertyValue");
+				qs1.addCondition("$file $property ?propertyValue");
 
-				Query q1(world, qs1);
-				QueryResults qr1 = q1->execute( model );
+				Query q1 = world->preparedQuery( qs1 );
+				QueryResults qr1 = q1->execute( model, Bindings{
+					{ "file", world->intern( fileProjection.getUri() ) },
+					{ "property", nameComponent } } );
 
 				// NOTE: Improve error handling.
 				// while(qr1->success())
@@ -259,11 +259,13 @@ private:
 			QueryString qs2;
 			qs2.addPrefix("nfo", PREFIX_NFO);
 			qs2.setVariables("?node");
-			qs2.addCondition(string("?node nfo:belongsToContainer <") +  _node + ">");
-			qs2.addCondition(string("?node a <") + _containerType + ">");
+			qs2.addCondition("?node nfo:belongsToContainer $container");
+			qs2.addCondition("?node a $type");
 
-			Query q2(world, qs2);
-			QueryResults qr2 = q2->execute( model );
+			Query q2 = world->preparedQuery( qs2 );
+			QueryResults qr2 = q2->execute( model, Bindings{
+				{ "container", world->intern( _node ) },
+				{ "type", world->intern( _containerType ) } } );
 
 			// while(qr2->success())
 			for( auto &qi2 : *qr2 )
@@ -0,0 +1,186 @@
+/* RDF C++ API 
+ *
+ * 			columnar.hpp
+ *
+ * 	Copyright 2017		Brenton Ross
+ *
+ * -----------------------------------------------------------------------------
+ * LICENSE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef RDFXX_COLUMNAR_HPP
+#define RDFXX_COLUMNAR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <librdf.h>
+
+namespace rdf
+{
+
+// ============================================================================
+//! Native triple store, registered with librdf as the "rdfxx-columnar"
+//! storage type.
+//
+// Terms are encoded as 32 bit ids through a dictionary. Each triple is held
+// three times, in SPO, POS and OSP order, in sorted contiguous arrays so that
+// any pattern is answered by a binary search on one of them. New triples go
+// to an unsorted pending buffer which is merged in before the next read.
+// Removed triples are marked and dropped from the indexes in one pass once
+// enough have gathered, or before the next read.
+//
+// A store may instead be opened on a snapshot file, which is mapped read
+// only: the dictionary is searched in place and nodes are only made for the
+// terms that are used. The first change to such a store copies the snapshot
+// into memory.
+//
+// As with the librdf stores, adding or removing statements while a stream
+// or iterator over the store is open gives undefined (but safe) results.
+// ============================================================================
+
+class _ColumnarStore
+{
+public:
+	using TermId = uint32_t;		// 0 is never a valid id
+
+	// a triple of ids, in the column order of one index
+	struct Key
+	{
+		TermId a, b, c;
+
+		bool operator < ( const Key & k ) const
+		{
+			return a != k.a ? a < k.a : ( b != k.b ? b < k.b : c < k.c );
+		}
+		bool operator == ( const Key & k ) const
+		{
+			return a == k.a && b == k.b && c == k.c;
+		}
+	};
+
+	enum Order { SPO = 0, POS = 1, OSP = 2 };
+
+	// a run of rows in one index
+	struct Range
+	{
+		Order order;
+		size_t begin, end;
+	};
+
+	// the rows of one index, in memory or in a mapped snapshot
+	struct Rows
+	{
+		const Key *data;
+		size_t count;
+
+		size_t size() const { return count; }
+		const Key & operator [] ( size_t i ) const { return data[i]; }
+	};
+
+	static const char *StorageName;
+
+	// make the storage type known to a librdf world
+	static void registerFactory( librdf_world * );
+
+	// the dictionary key for a term
+	static void termKey( librdf_node *, std::string & key );
+
+	// make a new node from a dictionary key
+	static librdf_node *keyToNode( librdf_world *, const char *key, size_t len );
+
+	// throw if a file is not a usable snapshot
+	static void checkSnapshot( const std::string & path );
+
+	static Key permute( Order, TermId s, TermId p, TermId o );
+	static void unpermute( Order, const Key &, TermId & s, TermId & p, TermId & o );
+
+private:
+	librdf_world *world;
+	std::unordered_map< std::string, TermId > ids;
+	std::vector< librdf_node * > terms;	// owned, indexed by id - 1
+	std::vector< Key > index[3];		// sorted
+	std::vector< Key > pending;		// SPO order, unsorted, may repeat
+	std::vector< Key > removed;		// SPO order, unsorted, still in the indexes
+	std::string scratch;			// reused to build dictionary keys
+
+	// the mapped snapshot, if any
+	void *mapBase;
+	size_t mapSize;
+	size_t mappedTerms;
+	size_t mappedTriples;
+	const uint64_t *keyOffsets;		// mappedTerms + 1 entries
+	const char *keyBytes;			// keys in id order, which is key order
+	const Key *mapped[3];
+	std::unordered_map< TermId, librdf_node * > decoded;	// owned
+
+	void mergeInto( Order, std::vector< Key > & );
+	void compact();			// drop the removed triples from the indexes
+	librdf_node *decode( TermId );
+	void materialise();		// copy a mapped snapshot into memory
+	void unmap();
+
+public:
+	explicit _ColumnarStore( librdf_world * );
+	~_ColumnarStore();
+
+	_ColumnarStore( const _ColumnarStore & ) = delete;
+	_ColumnarStore & operator = ( const _ColumnarStore & ) = delete;
+
+	librdf_world *getWorld() const { return world; }
+
+	// id of a term, 0 if it is not in the dictionary
+	TermId lookup( librdf_node * );
+
+	// id of a term, adding it to the dictionary if needed
+	TermId encode( librdf_node * );
+
+	// the term for an id, owned by the store
+	librdf_node *term( TermId id )
+	{
+		return mapBase ? decode( id ) : terms[ id - 1 ];
+	}
+
+	void add( TermId s, TermId p, TermId o );
+	bool remove( TermId s, TermId p, TermId o );
+	bool contains( TermId s, TermId p, TermId o );
+	size_t size();
+
+	// drop the removed triples and sort the pending ones into the indexes
+	void merge();
+
+	// find the rows that match a pattern, 0 is a wildcard
+	Range match( TermId s, TermId p, TermId o );
+
+	Rows rows( Order ord ) const
+	{
+		if ( mapBase )
+			return Rows{ mapped[ ord ], mappedTriples };
+		return Rows{ index[ ord ].data(), index[ ord ].size() };
+	}
+
+	// map a snapshot file, replacing the contents of the store
+	void openSnapshot( const std::string & path );
+
+	// write the store as a snapshot file
+	void saveSnapshot( const std::string & path );
+};
+
+} // namespace rdf
+#endif
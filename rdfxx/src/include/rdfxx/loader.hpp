@@ -0,0 +1,264 @@
+/* RDF C++ API
+ *
+ * 			loader.hpp
+ *
+ * 	Copyright 2017		Brenton Ross
+ *
+ * -----------------------------------------------------------------------------
+ * LICENSE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef RDFXX_LOADER_HPP
+#define RDFXX_LOADER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <librdf.h>
+
+#include <rdfxx/rdfxx.h>
+#include <rdfxx/columnar.hpp>
+
+namespace rdf
+{
+
+class _Model;
+class _Skolemiser;
+
+// ============================================================================
+//! A batch of statements that does not belong to any librdf world.
+//
+// Terms are held as the dictionary keys of the columnar store, numbered
+// from 1 within the batch, so a batch made by a parser in one world can be
+// added to a model in another.
+// ============================================================================
+
+class StatementBatch
+{
+public:
+	using TermId = _ColumnarStore::TermId;
+	using Key = _ColumnarStore::Key;
+
+	static const size_t Capacity = 65536;	// statements in a full batch
+
+private:
+	std::unordered_map< std::string, TermId > ids;
+	std::vector< std::string > keys;	// indexed by id - 1
+	std::vector< Key > rows;		// SPO order
+
+public:
+	TermId encode( const std::string & key );
+	void add( TermId s, TermId p, TermId o ) { rows.push_back( Key{ s, p, o } ); }
+
+	size_t size() const { return rows.size(); }
+	bool full() const { return rows.size() >= Capacity; }
+	void clear();
+
+	const std::vector< std::string > & terms() const { return keys; }
+	const std::vector< Key > & triples() const { return rows; }
+};
+
+// ============================================================================
+//! Parallel loader for the line based syntaxes, N-Triples and N-Quads.
+//
+// The file is mapped and cut into chunks at line boundaries. Worker threads
+// each have their own librdf world and parser, since a librdf world must not
+// be shared between threads, and parse whole chunks into statement batches.
+// The calling thread adds the batches to the model as they arrive; workers
+// wait when it falls behind.
+//
+// Blank node labels are scoped to the file rather than to a chunk, so they
+// are rewritten as IRIs in a private scheme before a chunk is parsed and
+// turned back into blank nodes, with a label unique to the load, when the
+// statements are encoded, or into skolem IRIs. Skolem IRIs number blank
+// nodes by their first appearance in the file, as a parser reading it from
+// the start would, so the chunks are scanned for labels before parsing.
+// Graph names in N-Quads are dropped.
+// ============================================================================
+
+class _ParallelLoader
+{
+private:
+	World world;
+	std::string parserName;
+	std::string parserMime;
+	std::string path;
+	std::string source;		// the URI of the file
+	std::string base;
+
+	std::string blankScheme;	// IRI prefix standing in for "_:"
+	std::string blankKey;		// blank node key prefix for this load
+	std::string skolem;		// IRI prefix for blank nodes, if not empty
+	std::unordered_map< std::string, size_t > blankOrder;	// label, from 1
+
+	// the input
+	const char *data;
+	std::vector< size_t > cuts;	// chunk boundaries, first 0, last the size
+	std::atomic< size_t > nextChunk;
+
+	// batches ready to add to the model
+	std::mutex lock;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	std::deque< StatementBatch > ready;
+	size_t readyLimit;
+	unsigned running;		// workers still parsing
+	std::atomic< bool > stopping;	// stop early, after an error
+	std::exception_ptr failure;	// the first worker exception
+	std::vector< std::string > errors;	// from the worker worlds
+	std::vector< std::string > warnings;
+
+	void split( size_t size, unsigned chunks );
+	void orderBlanks( unsigned threads );
+	void work();
+	void encode( StatementBatch &, librdf_statement *, std::string & key );
+	bool push( StatementBatch & );
+	bool pop( StatementBatch & );
+	void finished( std::exception_ptr, const std::vector< std::string > & errs,
+			const std::vector< std::string > & warns );
+	void stop();
+
+public:
+	_ParallelLoader( World, const std::string & name, const std::string & mime,
+			const std::string & skolem = "" );
+
+	_ParallelLoader( const _ParallelLoader & ) = delete;
+	_ParallelLoader & operator = ( const _ParallelLoader & ) = delete;
+
+	// true if the parser reads one of the syntaxes that can be split
+	static bool lineBased( const std::string & name, const std::string & mime );
+
+	// load a file, named by source_uri, with the given base URI, using up
+	// to threads workers
+	AddCounts load( _Model &, const std::string & file, const std::string & source_uri,
+			const std::string & base_uri, unsigned threads );
+};
+
+// ============================================================================
+//! A bounded ring of slots between one producer and one consumer.
+//
+// Only the producer moves the head and only the consumer the tail, so no
+// lock is needed. Items are swapped in and out, so the consumer hands back
+// its drained batch and the producer reuses its buffers.
+// ============================================================================
+
+template < class T >
+class BatchRing
+{
+private:
+	std::vector< T > slots;
+	std::atomic< size_t > head;	// next slot to fill
+	std::atomic< size_t > tail;	// next slot to drain
+
+public:
+	explicit BatchRing( size_t capacity )
+		: slots( capacity ), head( 0 ), tail( 0 )
+	{}
+
+	BatchRing( const BatchRing & ) = delete;
+	BatchRing & operator = ( const BatchRing & ) = delete;
+
+	// producer only, false if full
+	bool tryPush( T & item )
+	{
+		size_t h = head.load( std::memory_order_relaxed );
+		if ( h - tail.load( std::memory_order_acquire ) == slots.size() )
+			return false;
+		std::swap( item, slots[ h % slots.size() ] );
+		head.store( h + 1, std::memory_order_release );
+		return true;
+	}
+
+	// consumer only, false if empty
+	bool tryPop( T & item )
+	{
+		size_t t = tail.load( std::memory_order_relaxed );
+		if ( head.load( std::memory_order_acquire ) == t )
+			return false;
+		std::swap( item, slots[ t % slots.size() ] );
+		tail.store( t + 1, std::memory_order_release );
+		return true;
+	}
+};
+
+// ============================================================================
+//! Pipelined loader for any syntax.
+//
+// A producer thread, with its own librdf world and a parser made like the
+// caller's, parses the source into statement batches and passes them
+// through a ring to the calling thread, which adds them to the model.
+// Parsing and insertion so overlap, and the parser waits when the model
+// falls behind. Blank node labels are given a prefix unique to the load so
+// that they cannot meet the labels of the model's own world, or are made
+// into skolem IRIs by the producer.
+// ============================================================================
+
+class _PipelinedLoader
+{
+private:
+	using Clock = std::chrono::steady_clock;
+
+	World world;
+	std::string parserName;
+	std::string parserMime;
+	std::string parserSyntax;
+	std::string source;
+	std::string base;
+	std::string blankKey;		// replaces the 'B' of the parsed blank keys
+	std::string skolem;		// IRI prefix for blank nodes, if not empty
+
+	BatchRing< StatementBatch > ring;
+	std::atomic< bool > done;	// set by the producer when it has finished
+	std::atomic< bool > stopping;	// set by the consumer to abandon the parse
+	std::exception_ptr failure;	// from the producer, read after the join
+	double stalled;			// producer wait, read after the join
+	std::vector< std::string > errors;	// from the producer world
+	std::vector< std::string > warnings;
+
+	// the namespaces the parser saw
+	struct Namespace
+	{
+		bool named;
+		std::string prefix;
+		std::string uri;
+	};
+	std::vector< Namespace > namespaces;
+
+	void produce();
+	void encode( StatementBatch &, librdf_statement *, std::string & key,
+			_Skolemiser * );
+	bool push( StatementBatch & );
+
+public:
+	_PipelinedLoader( World, const std::string & name, const std::string & mime,
+			const std::string & syntax, const std::string & skolem = "" );
+
+	_PipelinedLoader( const _PipelinedLoader & ) = delete;
+	_PipelinedLoader & operator = ( const _PipelinedLoader & ) = delete;
+
+	IngestStats load( _Model &, const std::string & uri, const std::string & base_uri );
+};
+
+} // namespace rdf
+#endif
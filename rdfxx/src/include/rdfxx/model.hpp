@@ -27,16 +27,20 @@
 #ifndef RDFXX_MODEL_HPP
 #define RDFXX_MODEL_HPP
 
+#include <exception>
 #include <iostream>
 #include <librdf.h>
 
 #include <rdfxx/rdfxx.h>
 #include <rdfxx/stream.hpp>
 #include <rdfxx/statement.hpp>
+#include <rdfxx/node_iterator.hpp>
 
 namespace rdf
 {
 
+class StatementBatch;
+
 // =============================================================================
 //! RDF C++ Model.
 // =============================================================================
@@ -51,6 +55,9 @@ class _Model : public Model_
 
 	void nodeIteratorToVector( librdf_iterator *, std::vector< Node > & );
 	void savePrefixes();	// ensure all prefixes are recorded as statements in the model
+	// bulk add, consumes and frees the stream, failing if the stream
+	// recorded an error
+	bool addStatements( librdf_stream *, const std::exception_ptr *error = nullptr );
  
     // -------------------------------------------------------------------------
     public:
@@ -98,6 +105,13 @@ class _Model : public Model_
 	
 	void updatePrefixes();	// update Prefixes from statements in the model
 
+    //! Write the model to a snapshot file.
+    /*! The statements are dictionary encoded and sorted into the
+     *  rdfxx-columnar layout, which is then written as a single file.
+     *  Throws Error if the file cannot be written.
+     */
+    void saveSnapshot( const std::string & path );
+
     //! Serialise the model to a Stream.
     /*!
      *  @return A RDF C++ Stream object.
@@ -122,6 +136,23 @@ class _Model : public Model_
      */
     bool add(Statement statement);
 
+    //! Add a batch of statements to the model.
+    /*! The statements are handed to the storage in a single call to
+     *  librdf_model_add_statements, inside a transaction if the storage
+     *  supports them, rather than one call per statement.
+     *
+     *  @return The counts of statements offered, inserted and duplicated.
+     */
+    AddCounts addAll( Stream );
+    AddCounts addAll( const std::vector< Triple > & );
+    AddCounts addAll( StatementSource );
+    using Model_::addAll;
+
+    // add a batch made by one of the loaders
+    AddCounts addBatch( const StatementBatch & );
+
+    IngestStats ingest( Parser, URI uri, URI base_uri );
+
     //! Add a statement* to the storage.
     /*! Expects a pointer to a dynamically allocated object.
      * 
@@ -153,12 +184,32 @@ class _Model : public Model_
      */
     bool contains(Statement statement) const;
 
+    //! Find the statements matching a pattern.
+    /*! A null node is a wildcard. The statements are fetched from the
+     *  storage with librdf_model_find_statements as the range is iterated.
+     *
+     *  @return A lazy range of statement views.
+     */
+    StatementRange find( Node subject, Node predicate, Node object );
+
 	virtual std::vector< Node > predicates( Node subject, Node object );
 	virtual std::vector< Node > objects( Node subject, Node predicate );
 	virtual std::vector< Node > subjects( Node predicate, Node object );
 
 	virtual std::vector< Node > arcsIn( Node object );
 	virtual std::vector< Node > arcsOut( Node subject );
+
+    //! Lazy versions of the navigation methods.
+    /*! These wrap the librdf iterator instead of copying every node
+     *  into a vector, so callers that only need the first node or a
+     *  count avoid creating nodes for the rest.
+     */
+	virtual NodeRange predicatesRange( Node subject, Node object );
+	virtual NodeRange objectsRange( Node subject, Node predicate );
+	virtual NodeRange subjectsRange( Node predicate, Node object );
+
+	virtual NodeRange arcsInRange( Node object );
+	virtual NodeRange arcsOutRange( Node subject );
  
     // This is used internally for the C API.
     operator librdf_model*() const;
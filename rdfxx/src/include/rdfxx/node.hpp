@@ -31,6 +31,7 @@
 
 #include <new>
 #include <iostream>
+#include <unordered_map>
 #include <librdf.h>
 #include <rdfxx/uri.hpp>
 #include <rdfxx/world.hpp>
@@ -50,18 +51,53 @@ protected:
 	World world;
 	librdf_node* node;		// owned except when free is false
 	bool free;
+	mutable size_t hashValue;	// valid when hashed is set
+	mutable bool hashed;
 
 	_NodeBase( World w, librdf_node *n, bool f)
-		: world(w), node(n), free(f) {}
+		: world(w), node(n), free(f), hashValue(0), hashed(false) {}
 public:
 	// Node copy() const;
 	std::string toString() const;
 
+	// the N-Triples form, written as librdf_node_write does but
+	// without a raptor iostream and its string
+	void appendTo( std::string & ) const;
+	void writeTo( std::ostream & ) const;
+	static void appendTo( librdf_node *, std::string & );
+
+	// value hash, computed on first use
+	size_t hash() const;
+
+	// hash and order librdf nodes by value; equal nodes, as
+	// librdf_node_equals sees them, hash and compare the same
+	static size_t hash( librdf_node * );
+	static int compare( librdf_node *, librdf_node * );
+
+	// Get a librdf node for a statement to own, leaving the Node null.
+	// The node's own librdf node is handed over if no other Node shares
+	// it and it owns it, otherwise a copy is made.
+	static librdf_node* release( Node && );
+
+	// a view of a librdf node owned elsewhere
+	static TermView view( librdf_node * );
+
+	// the _NodeBase part of a node, or null
+	static _NodeBase * base( const Node & );
+
 	// This is used internally for the C API.
 	operator librdf_node*() const;
 
 	static librdf_node* derefNode( Node );
 
+	// point a node created with freeOnDelete false at another librdf_node
+	// of the same kind, so that a single Node can serve as a view
+	static void rebind( Node, librdf_node * );
+
+	// make a node that is a view own a copy of its librdf_node, so that
+	// it outlives what it viewed
+	static void detach( Node );
+
 	// construct _ResourceNode, _LiteralNode, or _BlankNode
 	// from librdf_node
 	static Node make( World, librdf_node*, bool freeOnDelete );
@@ -82,6 +118,9 @@ public:
 	_ResourceNode( World w, librdf_node *n, bool f) : _NodeBase( w, n, f) {}
 
 	virtual std::string toString() const { return _NodeBase::toString(); }
+	virtual size_t hash() const { return _NodeBase::hash(); }
+	virtual void appendTo( std::string &s ) const { _NodeBase::appendTo( s ); }
+	virtual void writeTo( std::ostream &os ) const { _NodeBase::writeTo( os ); }
 	virtual std::string toString(const Format &) const;
 	virtual URI toURI() const;
 	virtual int listItemOrdinal() const;
@@ -103,6 +142,9 @@ public:
 	_LiteralNode( World w, librdf_node *n, bool f) : _NodeBase( w, n, f) {}
 
 	virtual std::string toString() const { return _NodeBase::toString(); }
+	virtual size_t hash() const { return _NodeBase::hash(); }
+	virtual void appendTo( std::string &s ) const { _NodeBase::appendTo( s ); }
+	virtual void writeTo( std::ostream &os ) const { _NodeBase::writeTo( os ); }
 	virtual std::string toString(const Format &) const;
 
 	// this will be removed when _Node is removed.
@@ -123,6 +165,9 @@ public:
 	_BlankNode( World w, librdf_node *n, bool f) : _NodeBase( w, n, f) {}
 
 	virtual std::string toString() const { return _NodeBase::toString(); }
+	virtual size_t hash() const { return _NodeBase::hash(); }
+	virtual void appendTo( std::string &s ) const { _NodeBase::appendTo( s ); }
+	virtual void writeTo( std::ostream &os ) const { _NodeBase::writeTo( os ); }
 	virtual std::string toString(const Format &) const;
 
 	// these will be removed when _Node is removed.
@@ -136,6 +181,32 @@ public:
 
 // ------------------------------------------------------------------------
 
+//! Gives blank nodes stable IRIs, derived from a hash of the document URI
+//! and the order in which each blank node first appears in it, so that
+//! loading the same document twice, by any path, gives the same IRIs and
+//! different documents give different ones.
+class _Skolemiser
+{
+private:
+	std::string prefix;
+	std::string source;
+	std::unordered_map< std::string, std::string > seen;
+
+public:
+	_Skolemiser( const std::string & _prefix, const std::string & _source )
+		: prefix(_prefix), source(_source) {}
+
+	//! The IRI for a blank node id, by the order in which ids are first
+	//! asked for. Parsers may relabel blank nodes, but not reorder them.
+	const std::string & iri( const char *id, size_t len );
+
+	//! Append the IRI for the n'th blank node of a source, counting from 1.
+	static void ordinalIRI( const std::string & prefix, const std::string & source,
+			size_t n, std::string & out );
+};
+
+// ------------------------------------------------------------------------
+
 
 } // namespace rdf
 #endif
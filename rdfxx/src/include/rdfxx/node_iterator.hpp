@@ -0,0 +1,75 @@
+/* RDF C++ API 
+ *
+ * 			node_iterator.hpp
+ *
+ * 	Copyright 2017		Brenton Ross
+ *
+ * -----------------------------------------------------------------------------
+ * LICENSE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef RDFXX_NODE_ITERATOR_HPP
+#define RDFXX_NODE_ITERATOR_HPP
+
+#include <librdf.h>
+
+#include <rdfxx/rdfxx.h>
+#include <rdfxx/node.hpp>
+
+namespace rdf
+{
+
+// ============================================================================
+//! RDF C++ _NodeIterator
+// ============================================================================
+
+class _NodeIterator : public NodeIterator_
+{
+private:
+	World world;
+	librdf_iterator *iter;	// owned
+
+	// one reusable view for each kind of node: resource, literal, blank
+	Node views[3];
+
+	void releaseViews();
+
+public:
+	//! Wrap a librdf iterator whose objects are nodes.
+	/*! Takes ownership of the iterator.
+	 */
+	_NodeIterator( World, librdf_iterator * );
+
+	//! Deletes the librdf iterator.
+	~_NodeIterator();
+
+	_NodeIterator( const _NodeIterator & ) = delete;
+	_NodeIterator & operator = ( const _NodeIterator & ) = delete;
+
+	bool end();
+	bool next();
+
+	//! Copy the current node so that it outlives the iterator.
+	Node current();
+
+	//! Rebind a view to the current node without copying it.
+	Node view();
+};
+
+} // namespace rdf
+#endif
@@ -39,12 +39,21 @@
 namespace rdf
 {
 
+class _Model;
+
 //! RDF C++ Parser.
 class _Parser : public Parser_
 {
  private:
     World world;
     librdf_parser* parser;
+    // as created, so that loaders can make the same parser in their own worlds
+    std::string name;
+    std::string mime;
+    std::string syntax;
+    std::string skolem;		// IRI prefix for blank nodes, empty to keep them
+
+    bool skolemiseIntoModel( _Model *, _URI *file, _URI *base );
  
  public:
     //! RDF C++ Parser constructor.
@@ -67,6 +76,16 @@ class _Parser : public Parser_
 
 	bool parseIntoModel(Model model, URI uri, URI base_uri);
 
+	AddCounts parseIntoModelParallel( Model model, URI uri, URI base_uri,
+					unsigned threads = 0 );
+
+	const std::string & syntaxName() const { return name; }
+	const std::string & syntaxMime() const { return mime; }
+	const std::string & syntaxURI() const { return syntax; }
+
+	void skolemise( const std::string & prefix ) { skolem = prefix; }
+	const std::string & skolemPrefix() const { return skolem; }
+
     //! RDF C++ Statement destructor.
 	/*! Deletes the internally stored librdf_parser object.
      */
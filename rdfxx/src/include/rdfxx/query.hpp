@@ -30,6 +30,10 @@
 #define RDFXX_QUERY_HPP
 
 #include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
 #include <librdf.h>
 
 #include <rdfxx/world.hpp>
@@ -44,13 +48,30 @@ namespace rdf
 //! RDF C++ _Query
 // ============================================================================
 
-class _Query : public Query_
+class _Query : public Query_, public std::enable_shared_from_this< _Query >
 {
     // ------------------------------------------------------------------------
     private:
     World world;
     librdf_query* query;
 
+    // as created, so that it can be run with parameters in place
+    std::string text;
+    std::string lang;
+    URI base;
+    std::vector< std::string > params;	// parameter names, no '$'
+    Bindings bound;
+
+    // the queries last run with values in place, most recent first,
+    // keyed by their text
+    static const size_t BoundQueryCacheSize = 16;
+    std::list< std::pair< std::string, Query > > boundQueries;
+
+    void findParameters();
+    void checkParameter( const std::string & name ) const;
+    void substitute( const Bindings &, std::string & out ) const;
+    void appendValues( const std::vector< Bindings > &, std::string & out ) const;
+
     // ------------------------------------------------------------------------
     public:
     //! RDF C++ Query constructor.
@@ -96,6 +117,12 @@ class _Query : public Query_
     QueryResults execute( Model );
     QueryResults execute( librdf_model* );
 
+    void bind( const std::string & name, Node value );
+    void clearBindings() { bound.clear(); }
+    QueryResults execute( Model, const Bindings & );
+    QueryResults executeBatch( Model, const std::vector< Bindings > & );
+    std::future< ResultTable > executeAsync( Model, CancelToken, Deadline );
+
     // This is used internally for the C API.
     operator librdf_query*();
 };
@@ -29,8 +29,10 @@
 #ifndef RDFXX_QUERYRESULTS_HPP
 #define RDFXX_QUERYRESULTS_HPP
 
+#include <functional>
 #include <iostream>
 #include <queue>
+#include <vector>
 #include <librdf.h>
 
 #include <rdfxx/world.hpp>
@@ -50,15 +52,30 @@ private:
 	World world;
 	librdf_query_results* query_results;
 	mutable int numberBound;
+
+	// the values of the current result, fetched together for the views
+	// and owned until the iterator moves on
+	mutable std::vector< librdf_node * > values;
+	mutable bool fetched;
+
+	void freeValues() const;
+	void fetchValues() const;
+
 public:
-	_QueryResult() : query_results(nullptr), numberBound(-1) {}
+	_QueryResult() : query_results(nullptr), numberBound(-1), fetched(false) {}
 	_QueryResult( World w, librdf_query_results *qr ) 
-		: world(w), query_results(qr), numberBound(-1) {}
+		: world(w), query_results(qr), numberBound(-1), fetched(false) {}
+	~_QueryResult();
+
+	_QueryResult( const _QueryResult & ) = delete;
+	_QueryResult & operator = ( const _QueryResult & ) = delete;
 
 	virtual int  count() const;
 	virtual std::string getBoundName(int offset) const;
 	virtual Node getBoundValue(int offset) const;
 	virtual Node getBoundValue( const std::string & name ) const;
+	virtual TermView boundView( int offset ) const;
+	virtual TermView boundView( const std::string & name ) const;
 	virtual std::string toString() const;
 
 	librdf_query_results* ptr()const { return query_results; }
@@ -71,13 +88,15 @@ using QueryResult = std::shared_ptr< _QueryResult >;
 //! RDF C++ _QueryResults
 // ============================================================================
 
-class _QueryResults : public QueryResults_
+class _QueryResults : public QueryResults_, public std::enable_shared_from_this< _QueryResults >
 {
     QueryResult currIter;
     World world;
 
     // ------------------------------------------------------------------------
     private:
+    // the results belong to the query, so keep it while they are read
+    std::shared_ptr< _Query > query;
     librdf_query_results* query_results;
 
     // ------------------------------------------------------------------------
@@ -127,6 +146,24 @@ class _QueryResults : public QueryResults_
      *  @return True if there are bindings. 
      */
     bool success() const;
+
+    ResultTable toTable();
+
+    //! As for toTable, calling check before each result so that it can
+    //! stop the drain by throwing.
+    ResultTable toTable( const std::function< void () > & check );
+    void writeTo( std::ostream &, ResultFormat );
+    void writeTo( int fd, ResultFormat );
+
+    bool isBindings() const;
+    bool isGraph() const;
+    bool isBoolean() const;
+    Stream asStream();
+    AddCounts intoModel( Model );
+    bool asBoolean() const;
+
+    private:
+    void writeRows( ResultFormat, const std::function< void ( const std::string & ) > & out );
 };
 
 } // nmamespace rdf
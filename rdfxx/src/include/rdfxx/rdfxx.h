@@ -37,6 +37,16 @@
 #include <memory>
 #include <string>
 #include <map>
+#include <vector>
+#include <cstring>
+#include <functional>
+#include <iosfwd>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include <rdfxx/except.h>
 
@@ -68,7 +78,11 @@ class Stream_;
 class URI_;
 
 class QueryString;
+class ResultTable;
 class Literal;
+class StatementRange;
+class NodeRange;
+class TripleView;
 
 //
 // Shared pointers for use by the client applications
@@ -173,13 +187,21 @@ public:
 	// 	    It is not documented as to what they are or how they are used.
 	//
 	// storage_type - name of storage factory
-	// 		"file", "memory", "hashes", "sqlite"
+	// 		"file", "memory", "hashes", "sqlite", or "rdfxx-columnar"
+	// 		for the native dictionary encoded in-memory store
 	// storage_name - an identifier, eg filename or database name
 	// options - whatever needed for initialisation
 	Model( World, const std::string & storage_type,
 		  const std::string & storage_name = "",
 		  const std::string & storage_options = "",
 		  const std::string & model_options = "" );
+
+	//! Open a model on a snapshot written by Model_::saveSnapshot.
+	//
+	// The file is mapped read only, so opening is quick and the pages
+	// are shared with other processes using the same snapshot. The
+	// first change to the model copies the snapshot into memory.
+	static Model openSnapshot( World, const std::string & path );
 };
 
 // ---------------------------------------------------------------
@@ -248,9 +270,16 @@ public:
 	//! Create an empty statement
 	Statement(World);
 
-	//! Create a statement with subject, predicate and object nodes.
+	//! Create a statement with copies of the subject, predicate and object nodes.
 	Statement(World, Node subject, Node predicate, Node object);
 
+	//! Create a statement that takes the subject, predicate and object nodes.
+
+	//! A node held by no other Node gives its librdf node to the statement
+	//! rather than having it copied; a shared node is copied. The nodes
+	//! are left null either way.
+	static Statement build( World, Node &&subject, Node &&predicate, Node &&object );
+
 	//! Replicate the shared_ptr<> constructor
 	Statement( Statement_* );
 
@@ -258,6 +287,78 @@ public:
 	Statement( StatementRef );
 };
 
+//! \struct Triple rdfxx.h rdfxx/rdfxx.h
+//! \brief The nodes of a statement, used when loading statements in bulk.
+
+struct Triple
+{
+	Node subject;		//!< The subject node
+	Node predicate;		//!< The predicate node
+	Node object;		//!< The object node
+};
+
+//! A function that supplies statements one at a time, returning a null
+//! statement when there are no more.
+using StatementSource = std::function< Statement () >;
+
+//! Values for the parameters of a query, keyed by name without the '$'.
+using Bindings = std::map< std::string, Node >;
+
+//! The time by which an asynchronous query must finish.
+using Deadline = std::chrono::steady_clock::time_point;
+
+// ---------------------------------------------------------------
+
+//! \class CancelToken rdfxx.h rdfxx/rdfxx.h
+//! \brief A flag for asking a running query to stop.
+
+//!
+//! Copies of a token share the flag, so a token passed to
+//! Query_::executeAsync can be cancelled from any thread. The running
+//! query checks the token once before it starts and once per result.
+//!
+
+class CancelToken
+{
+private:
+	struct State
+	{
+		std::atomic< bool > cancelled;
+		std::atomic< unsigned long > checks;
+		std::function< void ( unsigned long ) > onCheck;
+
+		State() : cancelled( false ), checks( 0 ) {}
+	};
+	std::shared_ptr< State > state;
+
+public:
+	//! Construct a token that has not been cancelled.
+	CancelToken() : state( std::make_shared< State >()) {}
+
+	//! Ask the query to stop.
+	void cancel() { state->cancelled.store( true ); }
+
+	//! Check if the query has been asked to stop.
+	bool cancelled() const { return state->cancelled.load(); }
+
+	//! The number of times the query has checked the token so far.
+	unsigned long checks() const { return state->checks.load(); }
+
+	//! Call a function, on the thread running the query, each time it
+	//! checks the token, with the number of checks so far. Set it before
+	//! the query starts; it suits progress reports.
+	void onCheck( std::function< void ( unsigned long ) > f ) { state->onCheck = std::move( f ); }
+
+	//! Count a check by the running query, and tell if it should stop.
+	bool check() const
+	{
+		unsigned long n = ++state->checks;
+		if ( state->onCheck )
+			state->onCheck( n );
+		return cancelled();
+	}
+};
+
 // ---------------------------------------------------------------
 
 //! \class Parser rdfxx.h rdfxx/rdfxx.h
@@ -366,13 +467,73 @@ public:
 
 // ---------------------------------------------------------------
 
+//! \class WorldPool rdfxx.h rdfxx/rdfxx.h
+//! \brief A set of World objects, one for each thread that asks.
+
+//!
+//! A World, and everything made from it, must only be used by one thread
+//! at a time. A pool gives each thread its own World, so independent work
+//! can proceed in parallel without a lock around it. A world is kept until
+//! its thread releases it, or for the life of the pool, which suits worker
+//! threads that last as long as the pool. A thread that ends without
+//! releasing its world leaves it to any later thread given the same id, so
+//! threads that come and go should release their worlds before they end.
+//!
+//! Prefixes shared through the pool are added to every world, including
+//! those made later, so that all threads present nodes the same way.
+//!
+class WorldPool
+{
+	// see world.cpp for the implementation
+private:
+	struct Member
+	{
+		World world;
+		size_t applied;		// shared prefixes added to the world
+	};
+
+	std::string pool_name;
+	size_t made;		// worlds made so far, to number their names
+	mutable std::mutex lock;
+	std::unordered_map< std::thread::id, Member > members;
+	std::vector< std::pair< std::string, std::string > > shared;	// prefix, namespace
+
+public:
+	//! Constructor. The worlds are named after the pool.
+	explicit WorldPool( const std::string & name );
+
+	WorldPool( const WorldPool & ) = delete;
+	WorldPool & operator = ( const WorldPool & ) = delete;
+
+	//! Get the world for the calling thread, making it on first use.
+	World world();
+
+	//! Forget the world of the calling thread. It closes once the thread
+	//! lets go of everything made from it, and the next call to world()
+	//! makes a new one.
+	void release();
+
+	//! Add a prefix to every world in the pool.
+	void sharePrefix( const std::string & prefix, const std::string & ns );
+
+	//! Add all the prefixes of a world to every world in the pool.
+	void sharePrefixes( World );
+
+	//! The number of worlds held for threads.
+	size_t size() const;
+};
+
+// ---------------------------------------------------------------
+
 //! \class Universe rdfxx.h rdfxx/rdfxx.h
 //! \brief A singleton class responsible for managing the World objects.
 
 //!
 //! The Universe object allows the using program to access a World
-//! object by name. Access will be protected by a mutex so that different
-//! threads can each use RDF processing.
+//! object by name. Access is protected by a mutex so that different
+//! threads can each use RDF processing, but a World itself must only
+//! be used by one thread at a time. Threads that work independently
+//! should each take their World from a WorldPool.
 //!
 class Universe
 {
@@ -380,14 +541,18 @@ class Universe
 private:
 	Universe(){}
 
-	// TODO - protect with mutex
+	std::mutex lock;
 	std::map< std::string, World > worlds;
+	std::map< std::string, std::unique_ptr< WorldPool > > pools;
 public:
 	//! Get a reference to the universe object.
 	static Universe& instance();
 
 	//! Create, or return an existing world object.
 	World world( const std::string & name );
+
+	//! Create, or return an existing pool of worlds.
+	WorldPool & pool( const std::string & name );
 };
 
 // ---------------------------------------------------------------
@@ -418,6 +583,46 @@ struct Format
 
 // ---------------------------------------------------------------
 
+//! \struct AddCounts rdfxx.h rdfxx/rdfxx.h
+//! \brief The outcome of adding a batch of statements to a model.
+
+//!
+//! If the storage cannot report its size every statement offered is
+//! counted as inserted.
+//!
+
+struct AddCounts
+{
+	long offered;		//!< Statements taken from the source
+	long inserted;		//!< Statements that were new to the model
+	long duplicates;	//!< Statements that were already in the model
+	bool ok;		//!< False if the storage reported a failure
+};
+
+// ---------------------------------------------------------------
+
+//! \struct IngestStats rdfxx.h rdfxx/rdfxx.h
+//! \brief The outcome of Model_::ingest.
+
+//!
+//! The stall times show which side limits the rate: the parser stalls
+//! when the model cannot keep up, the inserter when the parser cannot.
+//!
+
+struct IngestStats
+{
+	AddCounts counts;	//!< As for Model_::addAll
+	long batches;		//!< Batches passed from the parser to the inserter
+	double seconds;		//!< Elapsed time
+	double parserStalled;	//!< Seconds the parser waited for space
+	double inserterStalled;	//!< Seconds the inserter waited for statements
+
+	//! Statements parsed per second.
+	double rate() const { return seconds > 0 ? counts.offered / seconds : 0; }
+};
+
+// ---------------------------------------------------------------
+
 //! \class Prefixes rdfxx.h rdfxx/rdfxx.h
 //! \brief Manages the prefixes and namespaces for a World.
 
@@ -428,9 +633,23 @@ class Prefixes
 private:
 	WorldRef world;
 	URI base_uri;
+	std::string base_string;
 	std::map< std::string, URI > uriForPrefix;
-	std::map< std::string, std::string > prefixForURI;
-	static int anonCounter;
+
+	// Tables for the conversions, sorted by namespace and by prefix so
+	// that a name can be looked up in place with a binary search.
+	struct Namespace
+	{
+		std::string ns;
+		std::string prefix;
+	};
+	std::vector< Namespace > byNamespace;
+	std::vector< Namespace > byPrefix;
+
+	const Namespace *findNamespace( const char *ns, size_t len ) const;
+	const Namespace *findPrefix( const char *prefix, size_t len ) const;
+
+	static std::atomic< int > anonCounter;
 public:
 	//! Constructor
 	Prefixes( World );
@@ -439,7 +658,7 @@ public:
 	// file.
 
 	//! Set the base URI
-	void base( URI uri ) { base_uri = uri; }
+	void base( URI uri );
 	
 	//! insert an anonymous namespace
 	void anonymous( URI uri );
@@ -481,6 +700,19 @@ public:
 	//! Convert a URI and fragment to its prefix and fragment.
 	std::string prefixForm( URI );
 
+	//! Append the prefix form of a URI string to out.
+	/*! The local name follows the last '#', or failing that the last '/'.
+	 *  A URI in the base namespace is reduced to its local name, and one
+	 *  with no known prefix is appended unchanged.
+	 */
+	void prefixForm( const char *uri, size_t len, std::string & out ) const;
+
+	//! Append the URI for a prefixed name, a name in the base namespace,
+	//! or a URI in angle brackets to out.
+	/*! @return False, appending nothing, if the prefix is not known.
+	 */
+	bool uriForm( const char *name, size_t len, std::string & out ) const;
+
 	//! Get an iterator for the saved prefixes.
 	std::map< std::string, URI >::iterator begin() { return uriForPrefix.begin(); }
 
@@ -520,11 +752,97 @@ enum class DataType
 	HexBinary, Base64Binary,
 
 	// Miscellaneous
-	AnyURI, Language, NormalizedString, Token, NMTOKEN, Name, NCName
+	AnyURI, Language, NormalizedString, Token, NMTOKEN, Name, NCName,
+
+	// Added later, kept last so that the values above do not change
+	UnsignedInt
 };
 
 // ---------------------------------------------------------------
 
+//! \struct DecimalValue rdfxx.h rdfxx/rdfxx.h
+//! \brief An exact xsd:decimal, held as an integer scaled by a power of ten.
+
+struct DecimalValue
+{
+	long long digits;	//!< The value times ten to the power of scale
+	int scale;		//!< The number of digits after the decimal point
+
+	//! Get the nearest double.
+	double toDouble() const;
+};
+
+//! \struct DateTimeValue rdfxx.h rdfxx/rdfxx.h
+//! \brief The fields of any of the XSD date and time types.
+
+//!
+//! Fields that the data type does not have are zero, so an xsd:gYear has
+//! only a year and an xsd:time has no date.
+//!
+
+struct DateTimeValue
+{
+	int year;		//!< Negative for years BCE
+	int month;		//!< 1 to 12
+	int day;		//!< 1 to 31
+	int hour;		//!< 0 to 23
+	int minute;		//!< 0 to 59
+	double second;		//!< 0 to less than 60, with any fraction
+	bool hasTimezone;	//!< Set when a timezone was given
+	int timezone;		//!< The offset from UTC in minutes
+};
+
+//! \struct DurationValue rdfxx.h rdfxx/rdfxx.h
+//! \brief An XSD duration, as months and seconds.
+
+//!
+//! Both parts have the sign of the duration.
+//!
+
+struct DurationValue
+{
+	long long months;	//!< Years and months
+	double seconds;		//!< Days, hours, minutes and seconds
+};
+
+//! \struct TypedValue rdfxx.h rdfxx/rdfxx.h
+//! \brief The native value of a literal, parsed from its lexical form.
+
+struct TypedValue
+{
+	//! Which member holds the value.
+	enum class Kind
+	{
+		None,		//!< The data type has no native value, such as a string
+		Invalid,	//!< The lexical form is not valid for the data type
+		Boolean, Integer, Unsigned, Decimal, Real, DateTime, Duration
+	};
+
+	Kind kind;		//!< Which member holds the value
+
+	//! The value
+	union
+	{
+		bool boolean;			//!< xsd:boolean
+		long long integer;		//!< The integer types, when they fit
+		unsigned long long unsignedInteger;	//!< Larger non-negative integers
+		DecimalValue decimal;		//!< xsd:decimal, when it fits
+		double real;			//!< xsd:double, xsd:float and longer decimals
+		DateTimeValue dateTime;		//!< The date and time types
+		DurationValue duration;		//!< The duration types
+	};
+
+	//! Construct with no value.
+	TypedValue() : kind( Kind::None ), integer( 0 ) {}
+
+	//! Check if the value is one of the numeric kinds.
+	bool isNumeric() const
+	{
+		return kind == Kind::Integer || kind == Kind::Unsigned
+			|| kind == Kind::Decimal || kind == Kind::Real;
+	}
+};
+
 // 
 // This object holds the various components of an RDF or XML literal
 // value. This includes the value, the language, and the data type.
@@ -536,10 +854,8 @@ enum class DataType
 
 class Literal
 {
-	// see node.cpp for the implementation
-	static std::map< DataType, std::string > xsd_types;
-	static std::map< DataType, std::string > names;
-	static void initXSDtypes();
+	// see node.cpp for the implementation, and literal.cpp for typed
+	// values and data types
 private:
 
 	std::string mLanguage;		// eg "en" for English
@@ -547,6 +863,12 @@ private:
 
 	std::string mValue;
 
+	// the value parsed according to the data type, on first use
+	mutable TypedValue mTyped;
+	mutable bool mParsed;
+
+	void typed( const TypedValue & ) const;
+
 public:
 	//! Default constructor.
 	Literal();	// empty
@@ -566,9 +888,27 @@ public:
 	//! Create a literal with some type of integral value
 	Literal( int, DataType );
 
+	//! Create a literal with some type of integral value
+	Literal( long long, DataType );
+
+	//! Create a literal with some type of non-negative integral value
+	Literal( unsigned long long, DataType );
+
 	//! Create a literal with some type of real number value.
+
+	//! The value is written with the fewest digits that read back as the
+	//! same double, or float for DataType::Float.
 	Literal( double, DataType );
 
+	//! Create an xsd:decimal literal.
+	explicit Literal( const DecimalValue & );
+
+	//! Create a literal of one of the date and time types.
+	Literal( const DateTimeValue &, DataType );
+
+	//! Create a literal of one of the duration types.
+	Literal( const DurationValue &, DataType );
+
 	//! Create a literal with a boolean value
 	explicit Literal( bool );
 
@@ -576,10 +916,10 @@ public:
 	void language( const std::string & lang ) { mLanguage = lang; }
 
 	//! Set the data type
-	void dataType( DataType t ) { mDataType = t; }
+	void dataType( DataType t ) { mDataType = t; mParsed = false; }
 
 	//! Set the value
-	void value( const std::string & v ) { mValue = v; }
+	void value( const std::string & v ) { mValue = v; mParsed = false; }
 
 	//! Default conversion to a string.
 	std::string toString() const;
@@ -599,15 +939,51 @@ public:
 	//! Get the value as a string.
 	std::string asString() const { return mValue; }
 
+	//! Get the value parsed according to the data type.
+
+	//! The value is parsed on first use and kept, so later calls and the
+	//! typed accessors below do not parse again. As the value is kept in
+	//! the literal, a literal shared between threads should be parsed
+	//! before it is shared.
+	const TypedValue & typedValue() const;
+
+	//! Check that the value is valid for the data type.
+	bool isValid() const;
+
 	//! Get the value as an integer.
 	int asInteger() const;
 
+	//! Get the value as a 64 bit integer.
+	long long asLong() const;
+
+	//! Get the value as an unsigned 64 bit integer.
+	unsigned long long asUnsignedLong() const;
+
+	//! Get the value as an exact decimal.
+	DecimalValue asDecimal() const;
+
 	//! Get the value as a double.
 	double asDouble() const;
 
 	//! Get the value as a boolean.
 	bool asBoolean() const;
-	// TODO - more conversions as required
+
+	//! Get the value of a date or time.
+	DateTimeValue asDateTime() const;
+
+	//! Get the value of a duration.
+	DurationValue asDuration() const;
+
+	//! Get the bytes of an xsd:hexBinary or xsd:base64Binary.
+	std::string asBinary() const;
+
+	//! Compare by value.
+
+	//! Numbers compare by value whatever their types, as do dates and
+	//! times of the same type and durations. Anything else compares by data
+	//! type, then lexical form, then language.
+	//! @return less than, equal to or greater than zero.
+	int compare( const Literal & ) const;
 
 	//! Convert a data type into an xsd form,
 	static std::string toXSD( DataType );
@@ -615,6 +991,9 @@ public:
 
 	//! Convert an xsd form into a data type
 	static DataType toDataType( const std::string & xsd_type );
+
+	//! Get the data type for a full data type URI, in constant time.
+	static DataType fromURI( const char *uri, size_t len );
 	static DataType asDataType( const std::string & type_name );
 
 	static std::vector< std::string > getDataTypeNames();
@@ -628,6 +1007,34 @@ public:
 
 // ---------------------------------------------------------------
 
+//! \struct InternStats rdfxx.h rdfxx/rdfxx.h
+//! \brief Counters for sizing a world's node interning cache.
+
+struct InternStats
+{
+	unsigned long hits;	//!< Lookups satisfied from the cache
+	unsigned long misses;	//!< Lookups that created a new node
+	size_t size;		//!< Number of nodes in the cache
+};
+
+// ---------------------------------------------------------------
+
+//! \struct QueryCacheStats rdfxx.h rdfxx/rdfxx.h
+//! \brief Counters for sizing a world's prepared query cache.
+
+struct QueryCacheStats
+{
+	unsigned long hits;	//!< Lookups satisfied from the cache
+	unsigned long misses;	//!< Lookups that parsed the query
+	size_t size;		//!< Number of queries in the cache
+	double parseSeconds;	//!< Time spent parsing on the misses
+
+	//! The fraction of lookups satisfied from the cache.
+	double hitRate() const { return hits + misses > 0 ? double( hits ) / ( hits + misses ) : 0; }
+};
+
+// ---------------------------------------------------------------
+
 //! \class World_ rdfxx.h rdfxx/rdfxx.h
 //! \brief An abstract class defining the methods for an RDF World.
 
@@ -649,6 +1056,33 @@ public:
 
 	//! Get a reference to the saved prefixes.
 	virtual Prefixes & prefixes() = 0;
+
+	//! Get the shared resource node for an IRI, creating it on first use.
+	//! Repeated lookups of the same IRI return the same node without
+	//! allocating. The node must not be modified, and, like the world,
+	//! must only be used by one thread at a time.
+	virtual ResourceNode intern( const std::string & iri ) = 0;
+
+	//! Get the hit and miss counts of the interning cache.
+	virtual InternStats internStats() const = 0;
+
+	//! Make a blank node with a new identifier.
+	//! Identifiers are taken from blocks reserved for each thread, so
+	//! threads making blank nodes in their own worlds do not contend,
+	//! and are unique within the process.
+	virtual BlankNode newBlankNode() = 0;
+
+	//! Get a parsed query for the text, parsing it only if it is not
+	//! in the cache of recently used queries. Texts that differ only in
+	//! spacing outside literals share an entry. A query that is still in
+	//! use, or whose results are, is not handed out again; a fresh one
+	//! is parsed instead. The query must not be modified, other than
+	//! by binding its parameters.
+	virtual Query preparedQuery( const std::string & text,
+				const std::string & lang = "sparql" ) = 0;
+
+	//! Get the hit and miss counts of the prepared query cache.
+	virtual QueryCacheStats queryCacheStats() const = 0;
 };
 
 // ---------------------------------------------------------------
@@ -673,6 +1107,10 @@ public:
 	//! Save the model to its storage
 	virtual bool sync() = 0;
 
+	//! Write the model, with its prefixes, to a binary snapshot file
+	//! that can be opened with Model::openSnapshot.
+	virtual void saveSnapshot( const std::string & path ) = 0;
+
 	//! Get a pointer to a stream. The user controls its lifetime.
 	virtual Stream toStream() = 0;
 
@@ -684,6 +1122,41 @@ public:
 	//! Add a statement to the model
 	virtual bool add( Statement ) = 0;
 
+	//! Add all the statements in a stream to the model. This consumes the stream.
+	/*! Throws at a statement without all three nodes. The statements
+	 *  before it are rolled back if the storage has transactions, and
+	 *  are kept if it does not.
+	 */
+	virtual AddCounts addAll( Stream ) = 0;
+
+	//! Add a batch of node triples to the model.
+	/*! Throws, adding nothing, if any triple lacks a node.
+	 */
+	virtual AddCounts addAll( const std::vector< Triple > & ) = 0;
+
+	//! Add the statements from a source until it returns a null statement.
+	/*! A statement without all three nodes is treated as for a Stream.
+	 */
+	virtual AddCounts addAll( StatementSource ) = 0;
+
+	//! Parse a data source into the model, parsing on a second thread
+	//! while the statements are inserted on this one.
+	virtual IngestStats ingest( Parser, URI uri, URI base_uri ) = 0;
+
+	//! Find the statements matching a pattern. A null node matches anything.
+	//! The statements are fetched lazily as the range is iterated.
+	virtual StatementRange find( Node subject, Node predicate, Node object ) = 0;
+
+	//! Add a range of statements to the model.
+	template < class Iter >
+	AddCounts addAll( Iter first, Iter last )
+	{
+		return addAll( StatementSource( [&first, last]() -> Statement
+			{
+				return ( first == last ) ? Statement() : Statement( *first++ );
+			} ));
+	}
+
 	//! Remove a statement from the model
 	virtual bool remove( Statement ) = 0;
 
@@ -709,6 +1182,21 @@ public:
 
 	//! Get a list of predicates connected to a ssubject.
 	virtual std::vector< Node > arcsOut( Node subject ) = 0;
+
+	//! Get a lazy range of the predicates that link a subject and object.
+	virtual NodeRange predicatesRange( Node subject, Node object ) = 0;
+
+	//! Get a lazy range of the objects linked to a subject by a predicate.
+	virtual NodeRange objectsRange( Node subject, Node predicate ) = 0;
+
+	//! Get a lazy range of the subjects linked to an object by a predicate.
+	virtual NodeRange subjectsRange( Node predicate, Node object ) = 0;
+
+	//! Get a lazy range of the predicates connected to an object.
+	virtual NodeRange arcsInRange( Node object ) = 0;
+
+	//! Get a lazy range of the predicates connected to a subject.
+	virtual NodeRange arcsOutRange( Node subject ) = 0;
 	
 	// TODO - add and remove sub-models
 };
@@ -743,10 +1231,320 @@ public:
 	//! Check if the node is a resource.
 	virtual bool isResource() const = 0;
 
-	// TODO operator ==
+	//! Get a hash of the node's value, computed once per node.
+	virtual size_t hash() const = 0;
+
+	//! Append the N-Triples form of the node to a string.
+
+	//! Reuse the string across calls to render many nodes without
+	//! allocating for each one.
+	virtual void appendTo( std::string & ) const = 0;
+
+	//! Write the N-Triples form of the node to a stream.
+	virtual void writeTo( std::ostream & ) const = 0;
+};
+
+//! Check if two nodes have the same value, as librdf does. Two null
+//! nodes are equal, as for URIs and statements.
+bool operator == ( const Node &, const Node & );
+
+//! Check if two nodes have different values.
+bool operator != ( const Node &, const Node & );
+
+//! Order nodes by value: resources, then blank nodes, then literals.
+bool operator < ( const Node &, const Node & );
+
+//! Write the N-Triples form of a node to a stream.
+std::ostream & operator << ( std::ostream &, const Node & );
+
+// ---------------------------------------------------------------
+
+//! \class StringRef rdfxx.h rdfxx/rdfxx.h
+//! \brief A reference to characters owned elsewhere.
+
+//!
+//! A StringRef is only valid for as long as whatever it refers to, and
+//! the characters need not be terminated by a null.
+//!
+
+class StringRef
+{
+private:
+	const char *ptr;
+	size_t len;
+
+public:
+	//! Construct an empty reference.
+	StringRef() : ptr(""), len(0) {}
+
+	//! Construct a reference to len characters at p.
+	StringRef( const char *p, size_t n ) : ptr(p), len(n) {}
+
+	//! Construct a reference to a null terminated string.
+	StringRef( const char *p ) : ptr( p ? p : "" ), len( p ? strlen(p) : 0 ) {}
+
+	//! Construct a reference to the characters of a string.
+	StringRef( const std::string &s ) : ptr( s.data() ), len( s.size() ) {}
+
+	//! Get a pointer to the first character.
+	const char *data() const { return ptr; }
+
+	//! Get the number of characters.
+	size_t size() const { return len; }
+
+	//! Check if there are no characters.
+	bool empty() const { return len == 0; }
+
+	//! Get the start of the characters.
+	const char *begin() const { return ptr; }
+
+	//! Get the end of the characters.
+	const char *end() const { return ptr + len; }
+
+	//! Get a character.
+	char operator [] ( size_t i ) const { return ptr[i]; }
+
+	//! Copy the characters into a string.
+	std::string str() const { return std::string( ptr, len ); }
+
+	//! Check if the characters are the same.
+	bool operator == ( StringRef x ) const
+		{ return len == x.len && memcmp( ptr, x.ptr, len ) == 0; }
+
+	//! Check if the characters differ.
+	bool operator != ( StringRef x ) const { return ! operator==( x ); }
+};
+
+//! Write the characters to a stream.
+std::ostream & operator << ( std::ostream &, StringRef );
+
+// ---------------------------------------------------------------
+
+//! The kinds of term.
+enum class TermKind
+{
+	None, Resource, Blank, Literal
+};
+
+//! \class TermView rdfxx.h rdfxx/rdfxx.h
+//! \brief A handle on a term of a statement or query result.
+
+//!
+//! A TermView does not own its term and is trivially copyable, so getting
+//! one does not allocate. It is only valid for as long as the term it
+//! refers to, typically until the stream, range or result moves on; use
+//! toNode() for a term that must be kept.
+//!
+
+class TermView
+{
+private:
+	TermKind mKind;
+	void *term;		// the librdf_node
+
+public:
+	//! Construct a view of no term.
+	TermView() : mKind( TermKind::None ), term( nullptr ) {}
+
+	//! Construct a view of a term. Used internally.
+	TermView( TermKind k, void *t ) : mKind( t ? k : TermKind::None ), term( t ) {}
+
+	//! Get the kind of term.
+	TermKind kind() const { return mKind; }
+
+	//! Check if there is a term.
+	explicit operator bool () const { return term != nullptr; }
+
+	//! Check if the term is a resource.
+	bool isResource() const { return mKind == TermKind::Resource; }
+
+	//! Check if the term is blank.
+	bool isBlank() const { return mKind == TermKind::Blank; }
+
+	//! Check if the term is a literal.
+	bool isLiteral() const { return mKind == TermKind::Literal; }
+
+	//! Get the IRI of a resource, the label of a blank node or the lexical form of a literal.
+	StringRef value() const;
+
+	//! Get the IRI of a resource, or nothing for other terms.
+	StringRef iri() const;
+
+	//! Get the language of a literal, or nothing.
+	StringRef language() const;
+
+	//! Get the datatype IRI of a literal, or nothing.
+	StringRef datatype() const;
+
+	//! Get the native value of a typed literal, see Literal::typedValue.
+	TypedValue typedValue() const;
+
+	//! Get the same hash as a Node with the same value.
+	size_t hash() const;
+
+	//! Append the N-Triples form of the term to a string.
+	void appendTo( std::string & ) const;
+
+	//! Make a Node with a copy of the term.
+	Node toNode( World ) const;
+
+	//! Get the underlying librdf_node. Used internally.
+	void *handle() const { return term; }
+
+	//! Check if two terms have the same value.
+	bool operator == ( const TermView & ) const;
+
+	//! Check if two terms have different values.
+	bool operator != ( const TermView &x ) const { return ! operator==( x ); }
+};
+
+//! Write the N-Triples form of a term to a stream.
+std::ostream & operator << ( std::ostream &, const TermView & );
+
+//! \class TripleView rdfxx.h rdfxx/rdfxx.h
+//! \brief Handles on the three terms of a statement.
+
+//!
+//! Like TermView, a TripleView does not own its terms and is only valid
+//! for as long as the statement it was taken from.
+//!
+
+class TripleView
+{
+private:
+	TermView s;
+	TermView p;
+	TermView o;
+
+public:
+	//! Construct a view of no statement.
+	TripleView() {}
+
+	//! Construct a view from the views of the terms.
+	TripleView( TermView _s, TermView _p, TermView _o ) : s(_s), p(_p), o(_o) {}
+
+	//! Get the subject.
+	TermView subject() const { return s; }
+
+	//! Get the predicate.
+	TermView predicate() const { return p; }
+
+	//! Get the object.
+	TermView object() const { return o; }
+
+	//! Check if the statement has a subject, predicate and object.
+	bool isComplete() const { return s && p && o; }
+
+	//! Append the statement to a string as its three N-Triples terms.
+	void appendTo( std::string & ) const;
+
+	//! Make a Statement with copies of the terms.
+	Statement toStatement( World ) const;
+
+	//! Check if two statements have the same terms.
+	bool operator == ( const TripleView &x ) const
+		{ return s == x.s && p == x.p && o == x.o; }
+
+	//! Check if two statements differ.
+	bool operator != ( const TripleView &x ) const { return ! operator==( x ); }
+};
+
+//! Write a statement to a stream as its three N-Triples terms.
+std::ostream & operator << ( std::ostream &, const TripleView & );
+
+// ---------------------------------------------------------------
+
+//! \class NodeIterator_ rdfxx.h rdfxx/rdfxx.h
+//! \brief An abstract class defining the methods for iterating over nodes.
+
+
+class NodeIterator_
+{
+public:
+	//! Virtual destructor
+	virtual ~NodeIterator_() {}
+
+	//! Check if at the end of the nodes.
+	virtual bool end() = 0;
+
+	//! Move to the next node.
+	virtual bool next() = 0;
+
+	//! Get a copy of the current node that the caller may keep.
+	virtual Node current() = 0;
+
+	//! Get a view of the current node. A view still held when the
+	//! iterator moves on is given its own copy of the node first.
+	virtual Node view() = 0;
+};
+
+// ---------------------------------------------------------------
+
+//! \class NodeRange rdfxx.h rdfxx/rdfxx.h
+//! \brief A single pass range over the nodes found in a model.
+
+//!
+//! Nodes are fetched from the storage as the range is iterated. The node
+//! an iterator refers to is a view that is reused as the iterator
+//! advances, unless the caller has kept a copy of it, which then keeps
+//! its value. The shortcuts stop as soon as they have their answer.
+//!
+
+class NodeRange
+{
+private:
+	std::shared_ptr< NodeIterator_ > source;
+
+public:
+	//! Construct a range, taking ownership of the node iterator.
+	explicit NodeRange( NodeIterator_ * );
+
+	//! Get a copy of the first node, or a null node if there are none.
+	Node first();
+
+	//! Check if there are any nodes.
+	bool any();
+
+	//! Count the nodes. This consumes the range.
+	long count();
+
+	//! \class iterator rdfxx.h rdfxx/rdfxx.h
+	//! \brief An input iterator over the nodes of a range.
+
+	class iterator : public std::iterator< std::input_iterator_tag, Node >
+	{
+	private:
+		NodeIterator_ *source;
+		Node node;
+	public:
+		//! Construct an iterator at the current position of a node iterator.
+		explicit iterator( NodeIterator_ * );
+
+		//! Default constructor, the end of every range.
+		iterator();
+
+		//! Dereference the iterator to get a view of the node.
+		const Node & operator *() const;
+
+		//! Access the members of the node.
+		Node_ * operator ->() const;
+
+		//! Move to the next node.
+		iterator & operator ++ ();
+
+		//! Check for equality
+		bool operator == ( const iterator & ) const;
+
+		//! Check for inequality
+		bool operator != ( const iterator & ) const;
+	};
+
+	//! Get an iterator at the start of the range.
+	iterator begin() const;
+
+	//! Get an iterator past the end of the range.
+	iterator end() const;
 };
-// TODO operator == (Node, Node)
-// TODO operator << ( ostream &, Node )
 
 //! \class ResourceNode_ rdfxx.h rdfxx/rdfxx.h
 //! \brief An abstract class defining the methods for an RDF Resource Node
@@ -799,6 +1597,37 @@ public:
 	virtual std::string toString(const Format &) const = 0;
 };
 
+//! Write the N-Triples form of a resource node to a stream.
+std::ostream & operator << ( std::ostream &, const ResourceNode & );
+
+//! Write the N-Triples form of a literal node to a stream.
+std::ostream & operator << ( std::ostream &, const LiteralNode & );
+
+//! Write the N-Triples form of a blank node to a stream.
+std::ostream & operator << ( std::ostream &, const BlankNode & );
+
+//! Compare typed node handles by value, as for Node. Without these the
+//! shared_ptr comparison would be chosen, which compares the pointers.
+//! Handles of two different kinds are never equal, unless both are null.
+bool operator == ( const ResourceNode &, const ResourceNode & );
+bool operator == ( const ResourceNode &, const Node & );
+bool operator == ( const Node &, const ResourceNode & );
+bool operator == ( const LiteralNode &, const LiteralNode & );
+bool operator == ( const LiteralNode &, const Node & );
+bool operator == ( const Node &, const LiteralNode & );
+bool operator == ( const BlankNode &, const BlankNode & );
+bool operator == ( const BlankNode &, const Node & );
+bool operator == ( const Node &, const BlankNode & );
+bool operator != ( const ResourceNode &, const ResourceNode & );
+bool operator != ( const ResourceNode &, const Node & );
+bool operator != ( const Node &, const ResourceNode & );
+bool operator != ( const LiteralNode &, const LiteralNode & );
+bool operator != ( const LiteralNode &, const Node & );
+bool operator != ( const Node &, const LiteralNode & );
+bool operator != ( const BlankNode &, const BlankNode & );
+bool operator != ( const BlankNode &, const Node & );
+bool operator != ( const Node &, const BlankNode & );
+
 // ---------------------------------------------------------------
 
 //! \class Parser_ rdfxx.h rdfxx/rdfxx.h
@@ -814,6 +1643,34 @@ public:
 	//! Parse a data source into a model.
 	virtual bool parseIntoModel( Model, URI uri, URI base_uri ) = 0;
 
+	//! Parse a local file into a model using several threads.
+	/*! For N-Triples and N-Quads the file is split at line boundaries
+	 *  and the pieces are parsed in parallel, the statements being added
+	 *  to the model in batches. N-Quads graph names are dropped.
+	 *  Other syntaxes are parsed by parseIntoModel, and then the
+	 *  duplicates count is not known.
+	 *
+	 *  @param uri A file: URI.
+	 *  @param base_uri The base URI, the file URI if null.
+	 *  @param threads The number of parsing threads, zero for one per core.
+	 */
+	virtual AddCounts parseIntoModelParallel( Model, URI uri, URI base_uri,
+						unsigned threads = 0 ) = 0;
+
+	//! Replace blank nodes with IRIs as they are parsed.
+	/*! Each blank node becomes the prefix followed by a hash of the
+	 *  document URI and the order in which the node first appears in
+	 *  the document. Parsing the same document again, by any of
+	 *  parseIntoModel, parseIntoModelParallel and Model_::ingest, gives
+	 *  the same IRIs, and other documents give other IRIs whatever
+	 *  their base URI.
+	 *
+	 *  @param prefix The IRI prefix, such as
+	 *  "http://example.com/.well-known/genid/", or empty to keep
+	 *  blank nodes.
+	 */
+	virtual void skolemise( const std::string & prefix ) = 0;
+
 	//! Get a list of parser names with their syntax URIs
 	static std::vector< std::string > listParsers( World );
 };
@@ -838,6 +1695,52 @@ public:
 
 	//! Run the query on a model.
 	virtual QueryResults execute( Model ) = 0;
+
+	//! Bind a parameter, written $name in the query pattern, to a value
+	//! for later runs. Throws if the query has no such parameter.
+	virtual void bind( const std::string & name, Node value ) = 0;
+
+	//! Remove all the values set by bind.
+	virtual void clearBindings() = 0;
+
+	//! Run the query on a model with the parameters bound to these
+	//! values instead of those set by bind.
+	/*! The values are put in the pattern in place of their parameters,
+	 *  so they narrow the search, and also joined as a SPARQL VALUES
+	 *  row, so that a selected parameter has its value. Parameters left
+	 *  unbound are free. The query must not have a VALUES clause of its
+	 *  own at the end.
+	 *
+	 *  Each distinct set of values is a new query text that librdf must
+	 *  parse. The query keeps the last 16 it parsed, so repeated values
+	 *  are parsed once; a loop over many different values pays for a
+	 *  parse on every call.
+	 */
+	virtual QueryResults execute( Model, const Bindings & ) = 0;
+
+	//! Run the query once for each set of values, as a single query.
+	/*! The sets are joined to the query in a SPARQL VALUES clause,
+	 *  so the query is parsed once for the whole batch. The parameters
+	 *  remain variables, and may be selected to tell the results of one
+	 *  set from another. The query must not have a VALUES clause of
+	 *  its own at the end.
+	 */
+	virtual QueryResults executeBatch( Model, const std::vector< Bindings > & ) = 0;
+
+	//! Run the query on a model on a library thread, and collect the
+	//! results into a table there.
+	/*! The token and the deadline are checked before the query starts
+	 *  and between results. If either stops the query, its results are
+	 *  freed at once and the future throws a Warning. librdf cannot be
+	 *  interrupted while it finds a result, so a slow pattern may run
+	 *  past the deadline until the next result is ready.
+	 *
+	 *  Queries on the same world are run one at a time. Neither the
+	 *  query nor the world of the model may be used by the calling
+	 *  thread until the future is ready.
+	 */
+	virtual std::future< ResultTable > executeAsync( Model, CancelToken = CancelToken(),
+			Deadline = Deadline::max() ) = 0;
 };
 
 // ---------------------------------------------------------------
@@ -861,12 +1764,88 @@ public:
 	//! Get a value for a variable name.
 	virtual Node getBoundValue( const std::string & name ) const = 0;
 
+	//! Get a view of the value at a position, valid until the next result.
+	virtual TermView boundView( int offset ) const = 0;
+
+	//! Get a view of the value for a variable name, valid until the next result.
+	virtual TermView boundView( const std::string & name ) const = 0;
+
 	//! Convert all the names and values to a string.
 	virtual std::string toString() const = 0;
 };
 
 // ---------------------------------------------------------------
 
+//! \class ResultTable rdfxx.h rdfxx/rdfxx.h
+//! \brief Query results held as a column of terms for each variable.
+
+//!
+//! The table owns its terms, so the views in its columns are valid for as
+//! long as the table. Unbound values are views of no term.
+//!
+
+class ResultTable
+{
+	// filled by _QueryResults::toTable, see query_results.cpp
+	friend class _QueryResults;
+private:
+	std::vector< std::string > names;
+	std::vector< std::vector< TermView > > columns;
+	mutable std::vector< std::vector< TypedValue > > decoded;
+	size_t nRows;
+
+	void release();
+
+public:
+	//! Construct an empty table.
+	ResultTable() : nRows( 0 ) {}
+
+	//! Free the terms.
+	~ResultTable();
+
+	ResultTable( const ResultTable & ) = delete;
+	ResultTable & operator = ( const ResultTable & ) = delete;
+	ResultTable( ResultTable && );
+	ResultTable & operator = ( ResultTable && );
+
+	//! Get the number of results.
+	size_t rows() const { return nRows; }
+
+	//! Get the number of variables.
+	size_t width() const { return names.size(); }
+
+	//! Get the name of the variable of a column.
+	const std::string & name( size_t col ) const { return names.at( col ); }
+
+	//! Get the column of a variable, or -1 if there is none.
+	int column( const std::string & name ) const;
+
+	//! Get the values of a column, one for each row.
+	const std::vector< TermView > & values( size_t col ) const { return columns.at( col ); }
+
+	//! Get a value.
+	TermView at( size_t row, size_t col ) const { return columns.at( col ).at( row ); }
+
+	//! Get the native values of the typed literals of a column.
+	/*! The values are parsed on the first call for a column. Other
+	 *  terms have values of kind None.
+	 */
+	const std::vector< TypedValue > & typedValues( size_t col ) const;
+};
+
+// ---------------------------------------------------------------
+
+//! The W3C formats for writing query results.
+enum class ResultFormat
+{
+	XML,	//!< SPARQL Query Results XML Format
+	JSON,	//!< SPARQL 1.1 Query Results JSON Format
+	CSV,	//!< SPARQL 1.1 Query Results CSV Format
+	TSV	//!< SPARQL 1.1 Query Results TSV Format
+};
+
+// ---------------------------------------------------------------
+
 //! \class QueryResults_ rdfxx.h rdfxx/rdfxx.h
 //! \brief An abstract class defining the methods for a set of Query Results.
 
@@ -925,6 +1904,43 @@ public:
 
 	//! Get iterator past the end of result set.
 	virtual iterator end() const = 0;
+
+	//! Move the remaining results into a table. This consumes the results.
+	/*! The variables are looked up once, and each result is fetched
+	 *  with one call, so this is the cheap way to read many results.
+	 */
+	virtual ResultTable toTable() = 0;
+
+	//! Write the remaining results to a stream. This consumes the results.
+	/*! The results are written as they are read, a buffer at a time,
+	 *  so the memory used does not grow with the number of results.
+	 *  Boolean results can only be written as XML or JSON.
+	 */
+	virtual void writeTo( std::ostream &, ResultFormat ) = 0;
+
+	//! Write the remaining results to a file descriptor, as for an ostream.
+	virtual void writeTo( int fd, ResultFormat ) = 0;
+
+	//! Check if the results are variable bindings, from SELECT.
+	virtual bool isBindings() const = 0;
+
+	//! Check if the results are a graph, from CONSTRUCT or DESCRIBE.
+	virtual bool isGraph() const = 0;
+
+	//! Check if the result is a boolean, from ASK.
+	virtual bool isBoolean() const = 0;
+
+	//! Get the statements of a graph result. This consumes the results.
+	/*! The stream keeps the results while it is read.
+	 */
+	virtual Stream asStream() = 0;
+
+	//! Add the statements of a graph result to a model. This consumes
+	//! the results.
+	virtual AddCounts intoModel( Model ) = 0;
+
+	//! Get the answer of a boolean result.
+	virtual bool asBoolean() const = 0;
 };
 
 // ---------------------------------------------------------------
@@ -932,6 +1948,10 @@ public:
 //! \class QueryString rdfxx.h rdfxx/rdfxx.h
 //! \brief A class for assistingin the preparation of a SPARQL query.
 
+//! Conditions may use parameters, written $name, in place of constant
+//! terms. They are given values when the query runs, see Query_::bind,
+//! so that one query text serves for every value.
+
 
 class QueryString
 {
@@ -1003,20 +2023,29 @@ public:
 	//! Clone the statement
 	virtual Statement copy() const = 0;
 
-	//! Set the subject node
-	virtual void subject( Node n ) = 0;
+	//! Set the subject node to a copy of a node.
+	virtual void subject( const Node &n ) = 0;
+
+	//! Set the subject node, moving the node into the statement if it is not shared.
+	virtual void subject( Node &&n ) = 0;
 
 	//! Get a reference to the subject node.
 	virtual NodeRef subject() const = 0;
 
-	//! Set the predicate node.
-	virtual void predicate( Node n ) = 0;
+	//! Set the predicate node to a copy of a node.
+	virtual void predicate( const Node &n ) = 0;
+
+	//! Set the predicate node, moving the node into the statement if it is not shared.
+	virtual void predicate( Node &&n ) = 0;
 
 	//! Get a reference to the predicate node.
 	virtual NodeRef predicate() const = 0;
 
-	//! Get the object node.
-	virtual void object( Node n ) = 0;
+	//! Set the object node to a copy of a node.
+	virtual void object( const Node &n ) = 0;
+
+	//! Set the object node, moving the node into the statement if it is not shared.
+	virtual void object( Node &&n ) = 0;
 
 	//! Get a reference to the object node.
 	virtual NodeRef object() const = 0;
@@ -1038,12 +2067,31 @@ public:
 
 	//! Compare with another statement.
 	virtual bool operator == ( Statement ) const = 0;
+
+	//! Get a hash of the statement from the hashes of its nodes.
+	virtual size_t hash() const = 0;
+
+	//! Append the statement to a string as its three N-Triples terms.
+
+	//! Reuse the string across calls to render many statements without
+	//! allocating for each one.
+	virtual void appendTo( std::string & ) const = 0;
+
+	//! Write the statement to a stream as its three N-Triples terms.
+	virtual void writeTo( std::ostream & ) const = 0;
 };
 
-//! Check for equality of two statements.
+//! Check for equality of two statements. Two null statements are equal.
 bool operator == ( Statement, Statement );
 
-// TODO operator << ( ostream &, Node )
+//! Check for inequality of two statements.
+bool operator != ( Statement, Statement );
+
+//! Order statements by subject, predicate then object.
+bool operator < ( Statement, Statement );
+
+//! Write a statement to a stream as its three N-Triples terms.
+std::ostream & operator << ( std::ostream &, const Statement & );
 
 // ---------------------------------------------------------------
 
@@ -1067,11 +2115,93 @@ public:
 	// statement only valid until next() or closed.
 	virtual StatementRef current() = 0;
 
-	// TODO - iterator interface
+	//! Get a view of the terms of the current statement.
+	// only valid until next() or closed.
+	virtual TripleView triple() = 0;
+
+	//! Get views of the next statements in the stream.
+
+	/*!
+	 *  Fills the buffer with views of up to n statements, starting with
+	 *  the current one, and moves the stream past them. The views are
+	 *  valid until the next call or until the stream is closed.
+	 *  A range based for loop over a Stream takes one at a time.
+	 *  @return The number of views, zero at the end of the stream.
+	 */
+	virtual size_t nextBatch( TripleView *buffer, size_t n ) = 0;
 };
 
 // ---------------------------------------------------------------
 
+//! \class StatementRange rdfxx.h rdfxx/rdfxx.h
+//! \brief A single pass range over the statements of a stream.
+
+//!
+//! Nothing is fetched until the range is iterated. The statement an
+//! iterator refers to is a view into the stream which is rebound as the
+//! iterator advances. A copy of *it that the caller keeps is detached
+//! first, so it keeps its value after the stream moves on or closes.
+//!
+
+class StatementRange
+{
+private:
+	Stream stream;
+
+public:
+	//! Construct a range over the remaining statements of a stream.
+	explicit StatementRange( Stream );
+
+	//! \class iterator rdfxx.h rdfxx/rdfxx.h
+	//! \brief An input iterator over the statements of a stream.
+
+	class iterator : public std::iterator< std::input_iterator_tag, Statement >
+	{
+	private:
+		Stream_ *stream;
+		Statement view;
+	public:
+		//! Construct an iterator at the current position of a stream.
+		explicit iterator( Stream_ * );
+
+		//! Default constructor, the end of every range.
+		iterator();
+
+		//! Dereference the iterator to get a view of the statement.
+		const Statement & operator *() const;
+
+		//! Access the members of the statement.
+		Statement_ * operator ->() const;
+
+		//! Get a view of the terms of the statement, without making nodes.
+		TripleView triple() const;
+
+		//! Move to the next statement.
+		iterator & operator ++ ();
+
+		//! Check for equality
+		bool operator == ( const iterator & ) const;
+
+		//! Check for inequality
+		bool operator != ( const iterator & ) const;
+	};
+
+	//! Get an iterator at the start of the range.
+	iterator begin() const;
+
+	//! Get an iterator past the end of the range.
+	iterator end() const;
+};
+
+//! Get an iterator over the remaining statements of a stream.
+//! Together with end() this lets a range based for loop take a Stream.
+StatementRange::iterator begin( const Stream & );
+
+//! Get an iterator past the end of any stream.
+StatementRange::iterator end( const Stream & );
+
+// ---------------------------------------------------------------
+
 //! \class URI_ rdfxx.h rdfxx/rdfxx.h
 //! \brief An abstract class defining the methods for an RDF URI.
 
@@ -1099,12 +2229,32 @@ public:
 
 	//! Convert the URI to a file path name
 	virtual std::string toFileName() const = 0;
+
+	//! Get a hash of the URI string, computed once per URI.
+	virtual size_t hash() const = 0;
+
+	//! Get the characters of the URI, valid for as long as the URI.
+	virtual StringRef view() const = 0;
+
+	//! Get the namespace, up to and including the last '#' or, failing
+	//! that, the last '/'. It is the whole URI if there is neither.
+	virtual StringRef nameSpace() const = 0;
+
+	//! Get the local name, everything after the namespace.
+	virtual StringRef localName() const = 0;
 };
 
-//! Check for equality of two URIs
+//! Check for equality of two URIs. Two null URIs are equal.
 bool operator == ( URI, URI );
 
-// TODO operator << ( ostream &, Node )
+//! Check for inequality of two URIs
+bool operator != ( URI, URI );
+
+//! Order URIs by their strings.
+bool operator < ( URI, URI );
+
+//! Write the string of a URI to a stream.
+std::ostream & operator << ( std::ostream &, const URI & );
 
 // ---------------------------------------------------------------
 
@@ -1136,4 +2286,34 @@ T* deref( std::shared_ptr<C> a )
 
 } // namespace rdf
 
+// ---------------------------------------------------------------
+//
+//! Hash nodes, URIs and statements by value, so that they can be used as
+//! keys of the unordered containers. A null pointer hashes to zero.
+
+namespace std
+{
+
+template <> struct hash< rdf::Node >
+{
+	size_t operator () ( const rdf::Node &n ) const { return n ? n->hash() : 0; }
+};
+
+template <> struct hash< rdf::URI >
+{
+	size_t operator () ( const rdf::URI &u ) const { return u ? u->hash() : 0; }
+};
+
+template <> struct hash< rdf::Statement >
+{
+	size_t operator () ( const rdf::Statement &s ) const { return s ? s->hash() : 0; }
+};
+
+template <> struct hash< rdf::TermView >
+{
+	size_t operator () ( const rdf::TermView &t ) const { return t.hash(); }
+};
+
+} // namespace std
+
 #endif
@@ -69,6 +69,10 @@ class _Statement : public Statement_
      */
     _Statement(World, Node subject, Node predicate, Node object);
 
+    //  Create from librdf nodes, taking ownership of them.
+    _Statement(World, librdf_node *subject, librdf_node *predicate,
+    		librdf_node *object);
+
     //! RDF C++ Statement copy-constructor.
     /*! Makes a completecopy of a RDF C++ Statement object.
      * 
@@ -95,6 +99,14 @@ class _Statement : public Statement_
 
 	Statement copy() const;
 
+    //  Make this statement a view of a statement owned elsewhere, such
+    //  as the current statement of a stream. Used internally by the
+    //  statement iterators to avoid a copy per statement.
+    void rebind( librdf_statement * );
+
+    //  Make a statement that is a view own a copy of what it viewed.
+    void detach();
+
     //! Get the subject Node of the Statement object.
     /*!
      *  @return A RDF C++ Node object.
@@ -105,7 +117,8 @@ class _Statement : public Statement_
     /*!
      *  @param _node A RDF C++ Node object reference.
      */ 
-    void subject(Node node);
+    void subject(const Node &node);
+    void subject(Node &&node);
 
     //! Get the predicate Node of the Statement.
     /*!
@@ -117,7 +130,8 @@ class _Statement : public Statement_
     /*!
      *  @param _node A RDF C++ Node object reference.
      */
-    void predicate(Node _node);
+    void predicate(const Node &_node);
+    void predicate(Node &&_node);
 
     //! Get the object Node of the Statement object.
     /*!
@@ -129,7 +143,8 @@ class _Statement : public Statement_
     /*!
      *  @param _node A RDF C++ Node object reference.
      */
-    void object(Node node);
+    void object(const Node &node);
+    void object(Node &&node);
 
     //! Indicates if the current statement has a valid subject, 
     //! predicate and object.
@@ -162,12 +177,27 @@ class _Statement : public Statement_
     std::string toString() const;
     std::string toString( const Format & ) const;
 
+    //  The three N-Triples terms, separated by spaces.
+    void appendTo( std::string & ) const;
+    void writeTo( std::ostream & ) const;
+
     //! Equality operator.
     /*!
      *  @return True if statements are equal.
      */
     bool operator ==( Statement  _statement) const;
 
+    //  Hash of the three node values. Not cached, since a statement can
+    //  be changed or rebound; it is made from the librdf nodes directly.
+    size_t hash() const;
+
+    //  Views of the terms of a librdf statement owned elsewhere.
+    static TripleView view( librdf_statement * );
+    TripleView view() const { return view( statement ); }
+
+    //  Order by subject, predicate then object, each by node value.
+    static int compare( librdf_statement *, librdf_statement * );
+
     // This is used internally for the C API.
     operator librdf_statement*() const;
 };
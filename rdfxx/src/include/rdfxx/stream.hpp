@@ -30,6 +30,7 @@
 #define RDFXX_STREAM_H
 
 #include <iostream>
+#include <vector>
 #include <librdf.h>
 
 #include <rdfxx/statement.hpp>
@@ -47,6 +48,12 @@ class _Stream : public Stream_
     World world;
     librdf_stream* stream;
     Statement currStatement;
+    Statement viewStatement;	// rebound to each statement by currentView()
+    std::vector< librdf_node * > batch;	// the nodes viewed by nextBatch()
+    QueryResults results;	// the results a graph stream reads, kept while it is read
+
+    void releaseBatch();
+    void releaseView();
  
  public:
     //! RDF C++ Stream constructor.
@@ -70,6 +77,12 @@ class _Stream : public Stream_
      */
     _Stream( World, librdf_stream* _stream); 
 
+    //! RDF C++ Stream constructor.
+    /*! Initializes a Stream object over the statements of graph query
+     *  results, which are kept for as long as the stream is.
+     */
+    _Stream( World, librdf_stream* _stream, QueryResults _results );
+
     //! RDF C++ Stream destructor.
 	/*! Deletes the internally stored librdf_stream object.
      */
@@ -93,6 +106,26 @@ class _Stream : public Stream_
      */
     StatementRef current();
 
+    //! Returns a view of the current Statement without copying it.
+    /*! The same view is rebound on each call, so it is only valid
+     *  until the stream moves on.
+     */
+    Statement currentView();
+
+    //! Returns views of the terms of the current Statement.
+    /*! Nothing is allocated; the views are valid until the stream
+     *  moves on.
+     */
+    TripleView triple();
+
+    //! Returns views of the next statements in the stream.
+    /*! Holds a reference to the nodes of each statement, so that
+     *  the views outlive the statements in the stream.
+     *
+     *  @return The number of views written to buffer.
+     */
+    size_t nextBatch( TripleView *buffer, size_t n );
+
 	// This is used internally for the C API.
     operator librdf_stream*();
 };
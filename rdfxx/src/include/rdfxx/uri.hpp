@@ -40,6 +40,46 @@
 namespace rdf
 {
 
+// ----------------------------------------------------------------------------
+// FNV-1a over a run of bytes; start from a previous result to continue a hash.
+// Used in size_t for the value hashes of URIs, nodes and statements, and in
+// uint64_t for skolem IRIs, which must be the same on every platform.
+
+const size_t HashSeed = size_t( 14695981039346656037ULL );
+
+template< typename H = size_t >
+inline H hashBytes( const void *data, size_t len, H h = H( HashSeed ))
+{
+	const unsigned char *p = static_cast< const unsigned char * >( data );
+	for ( size_t i = 0; i < len; i++ )
+	{
+		h ^= p[i];
+		h *= H( 1099511628211ULL );
+	}
+	return h;
+}
+
+// ----------------------------------------------------------------------------
+// Where a URI divides into namespace and local name.
+
+// the length up to and including the last '#', or zero
+inline size_t fragmentStart( const char *s, size_t len )
+{
+	while ( len > 0 && s[len-1] != '#' ) len--;
+	return len;
+}
+
+// the length of the namespace, up to the last '#' or failing that the
+// last '/', or the whole length if there is neither
+inline size_t namespaceLength( const char *s, size_t len )
+{
+	size_t n = fragmentStart( s, len );
+	if ( n > 0 ) return n;
+	n = len;
+	while ( n > 0 && s[n-1] != '/' ) n--;
+	return ( n > 0 ) ? n : len;
+}
+
 // ============================================================================
 //! RDF C++ _URI
 // ============================================================================
@@ -48,6 +88,10 @@ class _URI : public URI_
 {
     protected:
     librdf_uri* uri;
+    mutable size_t hashValue = 0;	// valid when hashed is set
+    mutable bool hashed = false;
+    mutable size_t nsLength = 0;	// valid when split is set
+    mutable bool split = false;
     _URI( const _URI & ) = delete;
     void operator = ( const _URI & ) = delete;
 
@@ -111,10 +155,17 @@ class _URI : public URI_
 
     //! Type conversion operator to const char*.
     /*! 
-     *  @return URI as const char* string.
+     *  @return URI as const char* string, owned by the URI.
      */
     operator const char*() const;
 
+    // the characters of the URI, owned by librdf
+    StringRef view() const;
+
+    // the namespace and local name, split once per URI
+    StringRef nameSpace() const;
+    StringRef localName() const;
+
     //! Equality operator.
     /*! Returns true if both URI objects are equal.
      */ 
@@ -122,6 +173,12 @@ class _URI : public URI_
     bool operator ==(URI _uri) const;
     bool operator <(URI _uri) const;
 
+    // hash of the URI string, computed on first use
+    size_t hash() const;
+
+    // order the strings of two URIs, as memcmp
+    static int compare( librdf_uri *, librdf_uri * );
+
     // This is used internally for the C API.
     operator librdf_uri*() const;
 };
@@ -34,6 +34,9 @@
 #include <list>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
 #include <rdfxx/rdfxx.h>
 
 namespace rdf
@@ -59,11 +62,22 @@ public:
 
 //! RDF C++ World.
 //
-// TODO - limit a world to a single process thread
+// A world, like the librdf world it wraps, must only be used by one thread
+// at a time; the Universe and WorldPool may be used from any thread. That
+// includes its caches, and the nodes and queries they hand out.
+//
+// The World handles made by make() are the ones clients hold. What the
+// caches hold refers to the world through shared_from_this(), so when the
+// last client handle goes the caches are emptied and closed, letting the
+// world be freed.
 //
 class _World : public World_, public std::enable_shared_from_this< _World >
 {
 	friend class Universe;
+	friend class WorldPool;
+	// loaders give their worker worlds our error handling
+	friend class _ParallelLoader;
+	friend class _PipelinedLoader;
 private:
 	librdf_world* world;
 	std::string world_name;
@@ -76,10 +90,47 @@ private:
 	ErrorHandler forWarnings;
 
 	Serializer defSerializer;
+
+	// starts the ids of the blank nodes this world makes, set on first use
+	std::string blankTag;
+
+	// Interned resource nodes, split into shards each with its own lock.
+	struct InternShard
+	{
+		std::mutex lock;
+		std::unordered_map< std::string, ResourceNode > nodes;
+	};
+	static const size_t InternShardCount = 16;
+	InternShard internShards[ InternShardCount ];
+	std::atomic< unsigned long > internHits;
+	std::atomic< unsigned long > internMisses;
+
+	// Recently used queries, most recent first, keyed by language and
+	// normalised text. The queries hold the world, so closeCaches
+	// empties this too.
+	struct PreparedQuery
+	{
+		std::string key;
+		Query query;
+	};
+	static const size_t QueryCacheSize = 64;
+	mutable std::mutex queryLock;
+	std::list< PreparedQuery > queries;
+	std::unordered_map< std::string, std::list< PreparedQuery >::iterator > queryIndex;
+	unsigned long queryHits;
+	unsigned long queryMisses;
+	double queryParseSeconds;
  
 	//! RDF C++ World constructor.
 	_World( const std::string &name );
 
+	// set when the last client handle has gone
+	std::atomic< bool > closed;
+	void closeCaches();
+
+	//! Make a world and the handle for its clients.
+	static World make( const std::string & name );
+
 public:
 	//! RDF C++ World copy-constructor.
 	_World(const _World&) = delete;
@@ -103,6 +154,14 @@ public:
 
 	virtual Serializer defaultSerializer();
 
+	virtual ResourceNode intern( const std::string & iri );
+	virtual InternStats internStats() const;
+
+	virtual BlankNode newBlankNode();
+
+	virtual Query preparedQuery( const std::string & text, const std::string & lang );
+	virtual QueryCacheStats queryCacheStats() const;
+
 	// This is used internally for the C API.
 	operator librdf_world*();
 
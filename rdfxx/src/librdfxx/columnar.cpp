@@ -0,0 +1,1291 @@
+/* RDF C++ API 
+ *
+ * 			columnar.cpp
+ *
+ * 	Copyright 2017		Brenton Ross
+ *
+ * -----------------------------------------------------------------------------
+ * LICENSE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ * -----------------------------------------------------------------------------
+ */
+
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <rdf_storage_module.h>
+
+#include <rdfxx/except.h>
+#include <rdfxx/columnar.hpp>
+
+using namespace rdf;
+using namespace std;
+
+using Key = _ColumnarStore::Key;
+using TermId = _ColumnarStore::TermId;
+
+const char *_ColumnarStore::StorageName = "rdfxx-columnar";
+
+// pending and removed triples are scanned rather than sorted up to this many
+const size_t ShortBuffer = 1024;
+
+// -----------------------------------------------------------------------------
+//	Snapshot file layout
+// -----------------------------------------------------------------------------
+//
+// A header, then the dictionary keys of the terms in key order, so that the
+// id of a term is its position and a lookup is a binary search, then the
+// triples sorted in each of the three orders. Sections start on 8 byte
+// boundaries so the arrays can be used in place once mapped.
+//
+
+namespace
+{
+
+const char SnapshotMagic[8] = { 'R', 'D', 'F', 'X', 'X', 'S', 'N', 'P' };
+const uint32_t SnapshotVersion = 1;
+const uint32_t SnapshotByteOrder = 0x01020304;
+
+struct SnapshotHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;	// as written, to detect a foreign byte order
+	uint64_t terms;
+	uint64_t triples;
+	uint64_t offsetsAt;	// uint64_t[ terms + 1 ], offsets into the keys
+	uint64_t keysAt;
+	uint64_t indexAt[3];	// Key[ triples ] in SPO, POS and OSP order
+	uint64_t fileSize;
+};
+
+uint64_t
+align8( uint64_t n )
+{
+	return ( n + 7 ) & ~uint64_t(7);
+}
+
+// true if count items of size bytes from at fit in the file
+bool
+within( uint64_t at, uint64_t count, uint64_t size, uint64_t fileSize )
+{
+	return at <= fileSize && count <= ( fileSize - at ) / size;
+}
+
+void
+checkHeader( const SnapshotHeader & h, uint64_t fileSize, const std::string & path )
+{
+	if ( memcmp( h.magic, SnapshotMagic, sizeof( SnapshotMagic )) != 0 )
+		throw VX(Error) << path << " is not an rdfxx snapshot";
+	if ( h.version != SnapshotVersion )
+		throw VX(Error) << path << " has unsupported snapshot version " << h.version;
+	if ( h.byteOrder != SnapshotByteOrder )
+		throw VX(Error) << path << " was written with a different byte order";
+	if ( h.fileSize != fileSize )
+		throw VX(Error) << path << " is truncated";
+
+	// every section must lie in the file, in order, and be aligned for use in place
+	if ( h.offsetsAt < sizeof( h ) || h.offsetsAt % 8 != 0
+			|| ! within( h.offsetsAt, h.terms + 1, sizeof( uint64_t ), fileSize )
+			|| h.terms + 1 == 0 )
+		throw VX(Error) << path << " has a corrupt term index";
+	if ( h.keysAt < h.offsetsAt + ( h.terms + 1 ) * sizeof( uint64_t ) || h.keysAt > fileSize )
+		throw VX(Error) << path << " has a corrupt term dictionary";
+	uint64_t at = h.keysAt;
+	for ( int i = 0; i < 3; i++ )
+	{
+		if ( h.indexAt[i] < at || h.indexAt[i] % alignof( Key ) != 0
+				|| ! within( h.indexAt[i], h.triples, sizeof( Key ), fileSize ))
+			throw VX(Error) << path << " has a corrupt triple index";
+		at = h.indexAt[i] + h.triples * sizeof( Key );
+	}
+}
+
+// the keys at the start of each term, 0 first then never decreasing,
+// and ending before the triples
+void
+checkKeyOffsets( const uint64_t *offsets, const SnapshotHeader & h, const std::string & path )
+{
+	if ( offsets[0] != 0 )
+		throw VX(Error) << path << " has a corrupt term dictionary";
+	for ( uint64_t i = 0; i < h.terms; i++ )
+		if ( offsets[ i + 1 ] < offsets[i] )
+			throw VX(Error) << path << " has a corrupt term dictionary";
+	if ( offsets[ h.terms ] > h.indexAt[0] - h.keysAt )
+		throw VX(Error) << path << " has a corrupt term dictionary";
+}
+
+// every id in the triple indexes names a term in the dictionary
+void
+checkTripleIds( const char *bytes, const SnapshotHeader & h, const std::string & path )
+{
+	for ( int i = 0; i < 3; i++ )
+	{
+		const Key *rows = reinterpret_cast< const Key * >( bytes + h.indexAt[i] );
+		for ( uint64_t t = 0; t < h.triples; t++ )
+		{
+			const Key & k = rows[t];
+			if ( k.a == 0 || k.a > h.terms || k.b == 0 || k.b > h.terms
+					|| k.c == 0 || k.c > h.terms )
+				throw VX(Error) << path << " has a corrupt triple index";
+		}
+	}
+}
+
+// write a section, padded to the next 8 byte boundary
+void
+writeSection( std::ofstream & out, const void *data, uint64_t len, uint64_t & at )
+{
+	static const char zeros[8] = { 0 };
+	out.write( static_cast< const char * >( data ), len );
+	uint64_t next = align8( at + len );
+	out.write( zeros, next - at - len );
+	at = next;
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+//	_ColumnarStore
+// -----------------------------------------------------------------------------
+
+_ColumnarStore::_ColumnarStore( librdf_world *w )
+	: world(w), mapBase(nullptr), mapSize(0), mappedTerms(0), mappedTriples(0),
+	  keyOffsets(nullptr), keyBytes(nullptr), mapped{ nullptr, nullptr, nullptr }
+{}
+
+// -----------------------------------------------------------------------------
+
+_ColumnarStore::~_ColumnarStore()
+{
+	unmap();
+	for ( auto n : terms )
+		librdf_free_node( n );
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+void
+_ColumnarStore::termKey( librdf_node *node, std::string & key )
+{
+	size_t len = 0;
+	key.clear();
+	if ( librdf_node_is_resource( node ))
+	{
+		unsigned char *u = librdf_uri_as_counted_string( librdf_node_get_uri( node ), &len );
+		key += 'R';
+		key.append( (const char *)u, len );
+	}
+	else if ( librdf_node_is_blank( node ))
+	{
+		unsigned char *b = librdf_node_get_counted_blank_identifier( node, &len );
+		key += 'B';
+		key.append( (const char *)b, len );
+	}
+	else
+	{
+		// the value is length prefixed as it may contain anything,
+		// language tags cannot contain '^'
+		unsigned char *v = librdf_node_get_literal_value_as_counted_string( node, &len );
+		char *lang = librdf_node_get_literal_value_language( node );
+		librdf_uri *dt = librdf_node_get_literal_value_datatype_uri( node );
+		key += 'L';
+		key += std::to_string( len );
+		key += ':';
+		key.append( (const char *)v, len );
+		key += '@';
+		if ( lang ) key += lang;
+		key += '^';
+		if ( dt )
+		{
+			unsigned char *u = librdf_uri_as_counted_string( dt, &len );
+			key.append( (const char *)u, len );
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+Key
+_ColumnarStore::permute( Order ord, TermId s, TermId p, TermId o )
+{
+	switch ( ord )
+	{
+	case SPO: return Key{ s, p, o };
+	case POS: return Key{ p, o, s };
+	default:  return Key{ o, s, p };
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+void
+_ColumnarStore::unpermute( Order ord, const Key & k, TermId & s, TermId & p, TermId & o )
+{
+	switch ( ord )
+	{
+	case SPO: s = k.a; p = k.b; o = k.c; break;
+	case POS: p = k.a; o = k.b; s = k.c; break;
+	default:  o = k.a; s = k.b; p = k.c; break;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+TermId
+_ColumnarStore::lookup( librdf_node *node )
+{
+	termKey( node, scratch );
+	if ( ! mapBase )
+	{
+		auto I = ids.find( scratch );
+		return ( I == ids.end() ) ? 0 : I->second;
+	}
+
+	// the mapped keys are sorted, so search them in place
+	size_t lo = 0, hi = mappedTerms;
+	while ( lo < hi )
+	{
+		size_t mid = lo + ( hi - lo ) / 2;
+		size_t len = keyOffsets[ mid + 1 ] - keyOffsets[ mid ];
+		int cmp = memcmp( keyBytes + keyOffsets[ mid ], scratch.data(), std::min( len, scratch.size() ));
+		if ( cmp == 0 )
+		{
+			if ( len == scratch.size() )
+				return mid + 1;
+			cmp = ( len < scratch.size() ) ? -1 : 1;
+		}
+		if ( cmp < 0 )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+TermId
+_ColumnarStore::encode( librdf_node *node )
+{
+	materialise();
+	termKey( node, scratch );
+	auto I = ids.find( scratch );
+	if ( I != ids.end() )
+		return I->second;
+
+	if ( terms.size() >= std::numeric_limits< TermId >::max() )
+		throw VX(Error) << "Term dictionary is full";
+
+	terms.push_back( librdf_new_node_from_node( node ));
+	TermId id = terms.size();
+	ids.emplace( scratch, id );
+	return id;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ColumnarStore::add( TermId s, TermId p, TermId o )
+{
+	materialise();
+	Key k{ s, p, o };
+
+	// adding back a removed triple just forgets the removal
+	auto I = std::find( removed.begin(), removed.end(), k );
+	if ( I != removed.end() )
+	{
+		removed.erase( I );
+		return;
+	}
+	pending.push_back( k );
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_ColumnarStore::remove( TermId s, TermId p, TermId o )
+{
+	if ( mapBase && ! contains( s, p, o ))
+		return false;
+	materialise();
+	if ( pending.size() > ShortBuffer )
+		merge();
+
+	// a triple not yet merged is simply dropped
+	Key k{ s, p, o };
+	size_t had = pending.size();
+	pending.erase( std::remove( pending.begin(), pending.end(), k ), pending.end() );
+	bool found = pending.size() != had;
+
+	// one in the indexes is marked, and the marks applied together
+	if ( std::binary_search( index[ SPO ].begin(), index[ SPO ].end(), k )
+			&& std::find( removed.begin(), removed.end(), k ) == removed.end() )
+	{
+		removed.push_back( k );
+		found = true;
+		if ( removed.size() >= ShortBuffer )
+			compact();
+	}
+	return found;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ColumnarStore::compact()
+{
+	if ( removed.empty() ) return;
+
+	// one pass over each index, stepping through the sorted marks beside it
+	std::vector< Key > gone( removed.size() );
+	for ( int i = 0; i < 3; i++ )
+	{
+		Order ord = static_cast< Order >( i );
+		for ( size_t j = 0; j < removed.size(); j++ )
+			gone[j] = permute( ord, removed[j].a, removed[j].b, removed[j].c );
+		std::sort( gone.begin(), gone.end() );
+
+		auto & rows = index[ ord ];
+		auto G = gone.begin();
+		size_t kept = 0;
+		for ( size_t r = 0; r < rows.size(); r++ )
+		{
+			while ( G != gone.end() && *G < rows[r] )
+				++G;
+			if ( G != gone.end() && *G == rows[r] )
+				continue;
+			rows[ kept++ ] = rows[r];
+		}
+		rows.resize( kept );
+	}
+	removed.clear();
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_ColumnarStore::contains( TermId s, TermId p, TermId o )
+{
+	Key k{ s, p, o };
+	if ( mapBase )
+		return std::binary_search( mapped[ SPO ], mapped[ SPO ] + mappedTriples, k );
+	if ( std::binary_search( index[ SPO ].begin(), index[ SPO ].end(), k ))
+		return std::find( removed.begin(), removed.end(), k ) == removed.end();
+
+	// a short pending buffer is cheaper to scan than to merge
+	if ( pending.size() <= ShortBuffer )
+		return std::find( pending.begin(), pending.end(), k ) != pending.end();
+
+	merge();
+	return std::binary_search( index[ SPO ].begin(), index[ SPO ].end(), k );
+}
+
+// -----------------------------------------------------------------------------
+
+size_t
+_ColumnarStore::size()
+{
+	if ( mapBase )
+		return mappedTriples;
+	merge();
+	return index[ SPO ].size();
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ColumnarStore::merge()
+{
+	compact();
+	if ( pending.empty() ) return;
+
+	std::sort( pending.begin(), pending.end() );
+	pending.erase( std::unique( pending.begin(), pending.end() ), pending.end() );
+
+	std::vector< Key > fresh;
+	fresh.reserve( pending.size() );
+	std::set_difference( pending.begin(), pending.end(),
+			index[ SPO ].begin(), index[ SPO ].end(), std::back_inserter( fresh ));
+	pending.clear();
+	if ( fresh.empty() ) return;
+
+	std::vector< Key > other( fresh.size() );
+	for ( Order ord : { POS, OSP } )
+	{
+		for ( size_t i = 0; i < fresh.size(); i++ )
+			other[i] = permute( ord, fresh[i].a, fresh[i].b, fresh[i].c );
+		std::sort( other.begin(), other.end() );
+		mergeInto( ord, other );
+	}
+	mergeInto( SPO, fresh );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ColumnarStore::mergeInto( Order ord, std::vector< Key > & sorted )
+{
+	auto & rows = index[ ord ];
+	size_t mid = rows.size();
+	rows.insert( rows.end(), sorted.begin(), sorted.end() );
+	std::inplace_merge( rows.begin(), rows.begin() + mid, rows.end() );
+}
+
+// -----------------------------------------------------------------------------
+
+_ColumnarStore::Range
+_ColumnarStore::match( TermId s, TermId p, TermId o )
+{
+	merge();
+
+	// every pattern is a prefix of one of the three orders
+	Order ord;
+	int len;
+	if ( s && p )		{ ord = SPO; len = o ? 3 : 2; }
+	else if ( s && o )	{ ord = OSP; len = 2; }
+	else if ( s )		{ ord = SPO; len = 1; }
+	else if ( p )		{ ord = POS; len = o ? 2 : 1; }
+	else if ( o )		{ ord = OSP; len = 1; }
+	else			{ ord = SPO; len = 0; }
+
+	Rows rows = this->rows( ord );
+	Range r{ ord, 0, rows.size() };
+	if ( len == 0 ) return r;
+
+	Key k = permute( ord, s, p, o );
+	auto prefixLess = [len]( const Key & x, const Key & y ) -> bool
+	{
+		if ( x.a != y.a || len == 1 ) return x.a < y.a;
+		if ( x.b != y.b || len == 2 ) return x.b < y.b;
+		return x.c < y.c;
+	};
+	auto range = std::equal_range( rows.data, rows.data + rows.count, k, prefixLess );
+	r.begin = range.first - rows.data;
+	r.end = range.second - rows.data;
+	return r;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+librdf_node *
+_ColumnarStore::keyToNode( librdf_world *w, const char *key, size_t len )
+{
+	if ( len == 0 )
+		return nullptr;
+	const unsigned char *body = (const unsigned char *)key + 1;
+	switch ( key[0] )
+	{
+	case 'R':
+		return librdf_new_node_from_counted_uri_string( w, body, len - 1 );
+	case 'B':
+		return librdf_new_node_from_counted_blank_identifier( w, body, len - 1 );
+	case 'L':
+	{
+		// L<length>:<value>@<language>^<datatype>
+		const char *end = key + len;
+		const char *colon = (const char *)memchr( key, ':', len );
+		if ( ! colon ) return nullptr;
+		size_t vlen = strtoul( key + 1, nullptr, 10 );
+		const char *value = colon + 1;
+		if ( value + vlen + 2 > end ) return nullptr;
+		const char *lang = value + vlen + 1;
+		const char *caret = (const char *)memchr( lang, '^', end - lang );
+		if ( ! caret ) return nullptr;
+		size_t llen = caret - lang;
+		librdf_uri *dt = nullptr;
+		if ( caret + 1 < end )
+			dt = librdf_new_uri2( w, (const unsigned char *)caret + 1, end - caret - 1 );
+		std::string language( lang, llen );
+		librdf_node *n = librdf_new_node_from_typed_counted_literal( w,
+				(const unsigned char *)value, vlen,
+				llen ? language.c_str() : nullptr, llen, dt );
+		if ( dt ) librdf_free_uri( dt );
+		return n;
+	}
+	default:
+		return nullptr;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+librdf_node *
+_ColumnarStore::decode( TermId id )
+{
+	auto I = decoded.find( id );
+	if ( I != decoded.end() )
+		return I->second;
+
+	if ( id == 0 || id > mappedTerms )
+		throw VX(Error) << "Corrupt term " << id << " in snapshot";
+	librdf_node *n = keyToNode( world, keyBytes + keyOffsets[ id - 1 ],
+			keyOffsets[ id ] - keyOffsets[ id - 1 ] );
+	if ( ! n )
+		throw VX(Error) << "Corrupt term " << id << " in snapshot";
+	decoded.emplace( id, n );
+	return n;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ColumnarStore::materialise()
+{
+	if ( ! mapBase ) return;
+
+	terms.assign( mappedTerms, nullptr );
+	ids.reserve( mappedTerms );
+	for ( size_t i = 0; i < mappedTerms; i++ )
+	{
+		terms[i] = decode( i + 1 );
+		ids.emplace( std::string( keyBytes + keyOffsets[i], keyOffsets[i + 1] - keyOffsets[i] ), i + 1 );
+	}
+	decoded.clear();	// the nodes now belong to terms
+
+	for ( int i = 0; i < 3; i++ )
+		index[i].assign( mapped[i], mapped[i] + mappedTriples );
+	unmap();
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ColumnarStore::unmap()
+{
+	for ( auto & I : decoded )
+		librdf_free_node( I.second );
+	decoded.clear();
+	if ( mapBase )
+		munmap( mapBase, mapSize );
+	mapBase = nullptr;
+	mapSize = 0;
+	mappedTerms = mappedTriples = 0;
+	keyOffsets = nullptr;
+	keyBytes = nullptr;
+	mapped[0] = mapped[1] = mapped[2] = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+void
+_ColumnarStore::checkSnapshot( const std::string & path )
+{
+	std::ifstream in( path, std::ios::binary | std::ios::ate );
+	if ( ! in )
+		throw VX(Error) << "Cannot open snapshot " << path;
+	uint64_t fileSize = in.tellg();
+	SnapshotHeader h;
+	in.seekg( 0 );
+	if ( ! in.read( reinterpret_cast< char * >( &h ), sizeof( h )))
+		throw VX(Error) << path << " is not an rdfxx snapshot";
+	checkHeader( h, fileSize, path );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ColumnarStore::openSnapshot( const std::string & path )
+{
+	int fd = open( path.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		throw VX(Error) << "Cannot open snapshot " << path << ": " << strerror( errno );
+
+	struct stat sb;
+	if ( fstat( fd, &sb ) != 0 || (size_t)sb.st_size < sizeof( SnapshotHeader ))
+	{
+		close( fd );
+		throw VX(Error) << path << " is not an rdfxx snapshot";
+	}
+
+	// a shared read only mapping lets processes share the pages
+	void *base = mmap( nullptr, sb.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+	if ( base == MAP_FAILED )
+		throw VX(Error) << "Cannot map snapshot " << path << ": " << strerror( errno );
+
+	const SnapshotHeader & h = *static_cast< const SnapshotHeader * >( base );
+	try
+	{
+		checkHeader( h, sb.st_size, path );
+		if ( h.terms >= std::numeric_limits< TermId >::max() )
+			throw VX(Error) << path << " has too many terms";
+		checkKeyOffsets( reinterpret_cast< const uint64_t * >(
+				static_cast< const char * >( base ) + h.offsetsAt ), h, path );
+		checkTripleIds( static_cast< const char * >( base ), h, path );
+	}
+	catch ( ... )
+	{
+		munmap( base, sb.st_size );
+		throw;
+	}
+
+	unmap();
+	for ( auto n : terms )
+		librdf_free_node( n );
+	terms.clear();
+	ids.clear();
+	pending.clear();
+	removed.clear();
+	for ( auto & rows : index )
+		rows.clear();
+
+	const char *bytes = static_cast< const char * >( base );
+	mapBase = base;
+	mapSize = sb.st_size;
+	mappedTerms = h.terms;
+	mappedTriples = h.triples;
+	keyOffsets = reinterpret_cast< const uint64_t * >( bytes + h.offsetsAt );
+	keyBytes = bytes + h.keysAt;
+	for ( int i = 0; i < 3; i++ )
+		mapped[i] = reinterpret_cast< const Key * >( bytes + h.indexAt[i] );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ColumnarStore::saveSnapshot( const std::string & path )
+{
+	materialise();
+	merge();
+
+	// number the terms in key order
+	size_t n = terms.size();
+	std::vector< const std::string * > keys( n );
+	for ( auto & I : ids )
+		keys[ I.second - 1 ] = &I.first;
+	std::vector< TermId > byKey( n );
+	for ( size_t i = 0; i < n; i++ )
+		byKey[i] = i + 1;
+	std::sort( byKey.begin(), byKey.end(), [&keys]( TermId x, TermId y )
+		{ return *keys[ x - 1 ] < *keys[ y - 1 ]; } );
+	std::vector< TermId > renumber( n + 1, 0 );
+	std::vector< uint64_t > offsets( n + 1, 0 );
+	for ( size_t i = 0; i < n; i++ )
+	{
+		renumber[ byKey[i] ] = i + 1;
+		offsets[ i + 1 ] = offsets[i] + keys[ byKey[i] - 1 ]->size();
+	}
+
+	size_t triples = index[ SPO ].size();
+	SnapshotHeader h;
+	memset( &h, 0, sizeof( h ));
+	memcpy( h.magic, SnapshotMagic, sizeof( SnapshotMagic ));
+	h.version = SnapshotVersion;
+	h.byteOrder = SnapshotByteOrder;
+	h.terms = n;
+	h.triples = triples;
+	h.offsetsAt = align8( sizeof( h ));
+	h.keysAt = h.offsetsAt + align8( ( n + 1 ) * sizeof( uint64_t ));
+	uint64_t at = h.keysAt + align8( offsets[n] );
+	for ( int i = 0; i < 3; i++ )
+	{
+		h.indexAt[i] = at;
+		at += align8( triples * sizeof( Key ));
+	}
+	h.fileSize = at;
+
+	// write beside the target and rename, so readers never see half a file
+	std::string tmp = path + ".tmp";
+	std::ofstream out( tmp, std::ios::binary | std::ios::trunc );
+	if ( ! out )
+		throw VX(Error) << "Cannot create snapshot " << tmp;
+
+	at = 0;
+	writeSection( out, &h, sizeof( h ), at );
+	writeSection( out, offsets.data(), offsets.size() * sizeof( uint64_t ), at );
+	uint64_t keysAt = at;
+	for ( size_t i = 0; i < n; i++ )
+		out.write( keys[ byKey[i] - 1 ]->data(), keys[ byKey[i] - 1 ]->size() );
+	at = keysAt + offsets[n];
+	writeSection( out, nullptr, 0, at );
+
+	std::vector< Key > rows( triples );
+	for ( int i = 0; i < 3; i++ )
+	{
+		Order ord = static_cast< Order >( i );
+		for ( size_t t = 0; t < triples; t++ )
+		{
+			const Key & k = index[ SPO ][t];
+			rows[t] = permute( ord, renumber[ k.a ], renumber[ k.b ], renumber[ k.c ] );
+		}
+		std::sort( rows.begin(), rows.end() );
+		writeSection( out, rows.data(), triples * sizeof( Key ), at );
+	}
+
+	out.close();
+	if ( ! out )
+	{
+		::remove( tmp.c_str() );
+		throw VX(Error) << "Failed to write snapshot " << tmp;
+	}
+	if ( rename( tmp.c_str(), path.c_str() ) != 0 )
+	{
+		::remove( tmp.c_str() );
+		throw VX(Error) << "Cannot rename snapshot to " << path << ": " << strerror( errno );
+	}
+}
+
+// -----------------------------------------------------------------------------
+//	librdf storage module
+// -----------------------------------------------------------------------------
+//
+// librdf calls these through the storage factory. They must not let
+// exceptions escape into the C library.
+//
+
+namespace
+{
+
+_ColumnarStore *
+storeOf( librdf_storage *storage )
+{
+	return static_cast< _ColumnarStore * >( librdf_storage_get_instance( storage ));
+}
+
+// ---- ids for the nodes of a statement, 0 for a missing or unknown node -----
+
+bool
+lookupStatement( _ColumnarStore *store, librdf_statement *st, TermId & s, TermId & p, TermId & o )
+{
+	librdf_node *sn = librdf_statement_get_subject( st );
+	librdf_node *pn = librdf_statement_get_predicate( st );
+	librdf_node *on = librdf_statement_get_object( st );
+	s = sn ? store->lookup( sn ) : 0;
+	p = pn ? store->lookup( pn ) : 0;
+	o = on ? store->lookup( on ) : 0;
+
+	// false if a node is given but cannot match anything
+	return ( ! sn || s ) && ( ! pn || p ) && ( ! on || o );
+}
+
+// ---- streams of statements -------------------------------------------------
+
+struct StatementScan
+{
+	librdf_storage *storage;	// referenced while the scan is open
+	_ColumnarStore *store;
+	_ColumnarStore::Range range;
+	size_t pos;
+	librdf_statement *current;	// owned, reloaded at each step
+};
+
+int
+scanEnd( void *ctx )
+{
+	StatementScan *c = static_cast< StatementScan * >( ctx );
+	return ( c->pos >= c->range.end || c->pos >= c->store->rows( c->range.order ).size() ) ? 1 : 0;
+}
+
+void
+scanLoad( StatementScan *c )
+{
+	if ( scanEnd( c )) return;
+	TermId s, p, o;
+	_ColumnarStore::unpermute( c->range.order, c->store->rows( c->range.order )[ c->pos ], s, p, o );
+
+	// the statement takes ownership, copying a node only adds a reference
+	librdf_statement_clear( c->current );
+	try
+	{
+		librdf_statement_set_subject( c->current, librdf_new_node_from_node( c->store->term( s )));
+		librdf_statement_set_predicate( c->current, librdf_new_node_from_node( c->store->term( p )));
+		librdf_statement_set_object( c->current, librdf_new_node_from_node( c->store->term( o )));
+	}
+	catch ( ... )
+	{
+		// a term that cannot be made ends the stream
+		librdf_statement_clear( c->current );
+		c->pos = c->range.end;
+	}
+}
+
+int
+scanNext( void *ctx )
+{
+	StatementScan *c = static_cast< StatementScan * >( ctx );
+	c->pos++;
+	scanLoad( c );
+	return scanEnd( ctx );
+}
+
+void *
+scanGet( void *ctx, int flags )
+{
+	StatementScan *c = static_cast< StatementScan * >( ctx );
+	if ( flags == LIBRDF_STREAM_GET_METHOD_GET_OBJECT )
+		return c->current;
+	return nullptr;
+}
+
+void
+scanFinished( void *ctx )
+{
+	StatementScan *c = static_cast< StatementScan * >( ctx );
+	librdf_free_statement( c->current );
+	librdf_storage_remove_reference( c->storage );
+	delete c;
+}
+
+librdf_stream *
+newScan( librdf_storage *storage, const _ColumnarStore::Range & range )
+{
+	_ColumnarStore *store = storeOf( storage );
+	librdf_world *w = store->getWorld();
+	librdf_statement *st = librdf_new_statement( w );
+	if ( ! st ) return nullptr;
+
+	StatementScan *c = new StatementScan{ storage, store, range, range.begin, st };
+	scanLoad( c );
+	librdf_storage_add_reference( storage );
+	librdf_stream *strm = librdf_new_stream( w, c, scanEnd, scanNext, scanGet, scanFinished );
+	if ( ! strm )
+		scanFinished( c );
+	return strm;
+}
+
+// ---- iterators over one column of the matching rows -------------------------
+
+struct NodeScan
+{
+	librdf_storage *storage;	// referenced while the scan is open
+	_ColumnarStore *store;
+	_ColumnarStore::Range range;
+	size_t pos;
+	int column;			// the column of the key to return
+	std::vector< TermId > ids;	// used instead of the rows when not empty
+};
+
+TermId
+columnOf( const Key & k, int column )
+{
+	return column == 0 ? k.a : ( column == 1 ? k.b : k.c );
+}
+
+int
+nodeScanEnd( void *ctx )
+{
+	NodeScan *c = static_cast< NodeScan * >( ctx );
+	if ( ! c->ids.empty() )
+		return ( c->pos >= c->ids.size() ) ? 1 : 0;
+	return ( c->pos >= c->range.end || c->pos >= c->store->rows( c->range.order ).size() ) ? 1 : 0;
+}
+
+int
+nodeScanNext( void *ctx )
+{
+	NodeScan *c = static_cast< NodeScan * >( ctx );
+	if ( nodeScanEnd( ctx ))
+		return 1;
+	if ( ! c->ids.empty() )
+	{
+		c->pos++;
+		return nodeScanEnd( ctx );
+	}
+
+	// the matching rows are sorted, so repeats of the column are adjacent
+	const auto & rows = c->store->rows( c->range.order );
+	TermId last = columnOf( rows[ c->pos ], c->column );
+	do
+		c->pos++;
+	while ( ! nodeScanEnd( ctx ) && columnOf( rows[ c->pos ], c->column ) == last );
+	return nodeScanEnd( ctx );
+}
+
+void *
+nodeScanGet( void *ctx, int flags )
+{
+	NodeScan *c = static_cast< NodeScan * >( ctx );
+	if ( flags != LIBRDF_ITERATOR_GET_METHOD_GET_OBJECT || nodeScanEnd( ctx ))
+		return nullptr;
+	TermId id = c->ids.empty()
+		? columnOf( c->store->rows( c->range.order )[ c->pos ], c->column )
+		: c->ids[ c->pos ];
+	try
+	{
+		return c->store->term( id );
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+void
+nodeScanFinished( void *ctx )
+{
+	NodeScan *c = static_cast< NodeScan * >( ctx );
+	librdf_storage_remove_reference( c->storage );
+	delete c;
+}
+
+librdf_iterator *
+newNodeScan( librdf_storage *storage, NodeScan *c )
+{
+	c->storage = storage;
+	librdf_storage_add_reference( storage );
+	librdf_iterator *iter = librdf_new_iterator( c->store->getWorld(), c,
+			nodeScanEnd, nodeScanNext, nodeScanGet, nodeScanFinished );
+	if ( ! iter )
+		nodeScanFinished( c );
+	return iter;
+}
+
+// find the rows for a two node pattern and return the remaining column
+librdf_iterator *
+findNodes( librdf_storage *storage, librdf_node *sn, librdf_node *pn, librdf_node *on )
+{
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId s = sn ? store->lookup( sn ) : 0;
+		TermId p = pn ? store->lookup( pn ) : 0;
+		TermId o = on ? store->lookup( on ) : 0;
+		if (( sn && ! s ) || ( pn && ! p ) || ( on && ! o ))
+			return librdf_new_empty_iterator( store->getWorld() );
+
+		_ColumnarStore::Range r = store->match( s, p, o );
+		// with two columns bound the free one is always the last
+		NodeScan *c = new NodeScan{ nullptr, store, r, r.begin, 2, {} };
+		return newNodeScan( storage, c );
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+// ---- the factory methods ----------------------------------------------------
+
+int
+columnarInit( librdf_storage *storage, const char *name, librdf_hash *options )
+{
+	if ( options )
+		librdf_free_hash( options );
+
+	// a storage name is the path of a snapshot to open
+	_ColumnarStore *store = nullptr;
+	try
+	{
+		store = new _ColumnarStore( librdf_storage_get_world( storage ));
+		if ( name && *name )
+			store->openSnapshot( name );
+	}
+	catch ( ... )
+	{
+		delete store;
+		return 1;
+	}
+	librdf_storage_set_instance( storage, store );
+	return 0;
+}
+
+void
+columnarTerminate( librdf_storage *storage )
+{
+	delete storeOf( storage );
+}
+
+int
+columnarOpen( librdf_storage *, librdf_model * )
+{
+	return 0;
+}
+
+int
+columnarClose( librdf_storage * )
+{
+	return 0;
+}
+
+int
+columnarSync( librdf_storage * )
+{
+	return 0;
+}
+
+int
+columnarSize( librdf_storage *storage )
+{
+	try
+	{
+		return storeOf( storage )->size();
+	}
+	catch ( ... )
+	{
+		return -1;
+	}
+}
+
+int
+columnarAddStatement( librdf_storage *storage, librdf_statement *st )
+{
+	if ( ! librdf_statement_is_complete( st ))
+		return 1;
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId s = store->encode( librdf_statement_get_subject( st ));
+		TermId p = store->encode( librdf_statement_get_predicate( st ));
+		TermId o = store->encode( librdf_statement_get_object( st ));
+		store->add( s, p, o );
+	}
+	catch ( ... )
+	{
+		return 1;
+	}
+	return 0;
+}
+
+int
+columnarAddStatements( librdf_storage *storage, librdf_stream *strm )
+{
+	// statements are only queued here, they are sorted in once at the end
+	int status = 0;
+	while ( status == 0 && ! librdf_stream_end( strm ))
+	{
+		librdf_statement *st = librdf_stream_get_object( strm );
+		if ( ! st )
+			return 1;
+		status = columnarAddStatement( storage, st );
+		librdf_stream_next( strm );
+	}
+	return status;
+}
+
+int
+columnarRemoveStatement( librdf_storage *storage, librdf_statement *st )
+{
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId s, p, o;
+		if ( ! librdf_statement_is_complete( st ) || ! lookupStatement( store, st, s, p, o ))
+			return 1;
+		return store->remove( s, p, o ) ? 0 : 1;
+	}
+	catch ( ... )
+	{
+		return 1;
+	}
+}
+
+int
+columnarContainsStatement( librdf_storage *storage, librdf_statement *st )
+{
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId s, p, o;
+		if ( ! librdf_statement_is_complete( st ) || ! lookupStatement( store, st, s, p, o ))
+			return 0;
+		return store->contains( s, p, o ) ? 1 : 0;
+	}
+	catch ( ... )
+	{
+		return 0;
+	}
+}
+
+int
+columnarHasArcIn( librdf_storage *storage, librdf_node *node, librdf_node *property )
+{
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId p = store->lookup( property );
+		TermId o = store->lookup( node );
+		if ( ! p || ! o ) return 0;
+		_ColumnarStore::Range r = store->match( 0, p, o );
+		return ( r.begin < r.end ) ? 1 : 0;
+	}
+	catch ( ... )
+	{
+		return 0;
+	}
+}
+
+int
+columnarHasArcOut( librdf_storage *storage, librdf_node *node, librdf_node *property )
+{
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId s = store->lookup( node );
+		TermId p = store->lookup( property );
+		if ( ! s || ! p ) return 0;
+		_ColumnarStore::Range r = store->match( s, p, 0 );
+		return ( r.begin < r.end ) ? 1 : 0;
+	}
+	catch ( ... )
+	{
+		return 0;
+	}
+}
+
+librdf_stream *
+columnarFindStatements( librdf_storage *storage, librdf_statement *st )
+{
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId s, p, o;
+		if ( ! lookupStatement( store, st, s, p, o ))
+			return librdf_new_empty_stream( store->getWorld() );
+		return newScan( storage, store->match( s, p, o ));
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+librdf_stream *
+columnarSerialise( librdf_storage *storage )
+{
+	try
+	{
+		return newScan( storage, storeOf( storage )->match( 0, 0, 0 ));
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+librdf_iterator *
+columnarFindSources( librdf_storage *storage, librdf_node *arc, librdf_node *target )
+{
+	return findNodes( storage, nullptr, arc, target );
+}
+
+librdf_iterator *
+columnarFindArcs( librdf_storage *storage, librdf_node *source, librdf_node *target )
+{
+	return findNodes( storage, source, nullptr, target );
+}
+
+librdf_iterator *
+columnarFindTargets( librdf_storage *storage, librdf_node *source, librdf_node *arc )
+{
+	return findNodes( storage, source, arc, nullptr );
+}
+
+librdf_iterator *
+columnarArcsOut( librdf_storage *storage, librdf_node *node )
+{
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId s = store->lookup( node );
+		if ( ! s )
+			return librdf_new_empty_iterator( store->getWorld() );
+
+		// SPO rows for one subject are grouped by predicate
+		_ColumnarStore::Range r = store->match( s, 0, 0 );
+		NodeScan *c = new NodeScan{ nullptr, store, r, r.begin, 1, {} };
+		return newNodeScan( storage, c );
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+librdf_iterator *
+columnarArcsIn( librdf_storage *storage, librdf_node *node )
+{
+	_ColumnarStore *store = storeOf( storage );
+	try
+	{
+		TermId o = store->lookup( node );
+		if ( ! o )
+			return librdf_new_empty_iterator( store->getWorld() );
+
+		// OSP rows for one object are not grouped by predicate,
+		// so collect the distinct predicates
+		_ColumnarStore::Range r = store->match( 0, 0, o );
+		const auto & rows = store->rows( r.order );
+		std::vector< TermId > preds;
+		for ( size_t i = r.begin; i < r.end; i++ )
+			preds.push_back( rows[i].c );
+		std::sort( preds.begin(), preds.end() );
+		preds.erase( std::unique( preds.begin(), preds.end() ), preds.end() );
+		if ( preds.empty() )
+			return librdf_new_empty_iterator( store->getWorld() );
+
+		NodeScan *c = new NodeScan{ nullptr, store, r, 0, 2, std::move( preds ) };
+		return newNodeScan( storage, c );
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+void
+columnarFactory( librdf_storage_factory *factory )
+{
+	factory->version		= LIBRDF_STORAGE_INTERFACE_VERSION;
+	factory->init			= columnarInit;
+	factory->terminate		= columnarTerminate;
+	factory->open			= columnarOpen;
+	factory->close			= columnarClose;
+	factory->size			= columnarSize;
+	factory->add_statement		= columnarAddStatement;
+	factory->add_statements		= columnarAddStatements;
+	factory->remove_statement	= columnarRemoveStatement;
+	factory->contains_statement	= columnarContainsStatement;
+	factory->has_arc_in		= columnarHasArcIn;
+	factory->has_arc_out		= columnarHasArcOut;
+	factory->serialise		= columnarSerialise;
+	factory->find_statements	= columnarFindStatements;
+	factory->find_sources		= columnarFindSources;
+	factory->find_arcs		= columnarFindArcs;
+	factory->find_targets		= columnarFindTargets;
+	factory->get_arcs_in		= columnarArcsIn;
+	factory->get_arcs_out		= columnarArcsOut;
+	factory->sync			= columnarSync;
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+// static
+void
+_ColumnarStore::registerFactory( librdf_world *w )
+{
+	if ( librdf_storage_register_factory( w, StorageName,
+			"rdfxx dictionary encoded column store", columnarFactory ))
+		throw VX(Error) << "Failed to register the " << StorageName << " storage";
+}
+
+// ------------------------------- end -----------------------------------------
@@ -0,0 +1,1651 @@
+/* RDF C++ API
+ *
+ * 			literal.cpp
+ *
+ * 	Copyright 2017		Brenton Ross
+ *
+ * -----------------------------------------------------------------------------
+ * LICENSE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <rdfxx/except.h>
+#include <rdfxx/rdfxx.h>
+
+using namespace rdf;
+using namespace std;
+
+// -----------------------------------------------------------------------------
+//	Lexical forms
+// -----------------------------------------------------------------------------
+//
+// The parsers work on the characters of a literal's value in place. Where
+// one hands the characters to strtod, the number is followed by white space
+// or the end of the string, so strtod cannot read past it.
+
+namespace
+{
+
+const long long powersOf10[] =
+{
+	1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL,
+	100000000LL, 1000000000LL, 10000000000LL, 100000000000LL,
+	1000000000000LL, 10000000000000LL, 100000000000000LL,
+	1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+	1000000000000000000LL
+};
+const int MaxScale = 18;
+
+bool isSpace( char c ) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+bool isDigit( char c ) { return c >= '0' && c <= '9'; }
+
+// XSD collapses the white space of everything but the string types
+void trim( const char *&p, const char *&end )
+{
+	while ( p < end && isSpace( *p )) p++;
+	while ( end > p && isSpace( end[-1] )) end--;
+}
+
+bool expect( const char *&p, const char *end, char c )
+{
+	if ( p < end && *p == c )
+	{
+		p++;
+		return true;
+	}
+	return false;
+}
+
+// exactly n digits
+bool fixedDigits( const char *&p, const char *end, int n, int &v )
+{
+	if ( end - p < n ) return false;
+	v = 0;
+	for ( int i = 0; i < n; i++ )
+	{
+		if ( ! isDigit( p[i] )) return false;
+		v = v * 10 + ( p[i] - '0' );
+	}
+	p += n;
+	return true;
+}
+
+// one or more digits, all of the input
+bool parseUnsigned( const char *p, const char *end, unsigned long long &v )
+{
+	if ( p == end ) return false;
+	v = 0;
+	for ( ; p < end; p++ )
+	{
+		if ( ! isDigit( *p )) return false;
+		unsigned d = *p - '0';
+		if ( v > ( ULLONG_MAX - d ) / 10 ) return false;
+		v = v * 10 + d;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool parseBoolean( const char *p, const char *end, bool &b )
+{
+	size_t n = end - p;
+	if (( n == 4 && memcmp( p, "true", 4 ) == 0 ) || ( n == 1 && *p == '1' ))
+		b = true;
+	else if (( n == 5 && memcmp( p, "false", 5 ) == 0 ) || ( n == 1 && *p == '0' ))
+		b = false;
+	else
+		return false;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// The value space of each integer type. Where big is set there is no upper
+// limit below ULLONG_MAX.
+struct IntegerRange
+{
+	long long low;
+	long long high;
+	bool big;
+};
+
+bool integerRange( DataType dt, IntegerRange &r )
+{
+	switch ( dt )
+	{
+	case DataType::Integer:		 r = { LLONG_MIN, LLONG_MAX, true }; break;
+	case DataType::Long:		 r = { LLONG_MIN, LLONG_MAX, false }; break;
+	case DataType::Int:		 r = { INT_MIN, INT_MAX, false }; break;
+	case DataType::Short:		 r = { SHRT_MIN, SHRT_MAX, false }; break;
+	case DataType::Byte:		 r = { SCHAR_MIN, SCHAR_MAX, false }; break;
+	case DataType::UnsignedLong:	 r = { 0, LLONG_MAX, true }; break;
+	case DataType::UnsignedInt:	 r = { 0, UINT_MAX, false }; break;
+	case DataType::UnsignedShort:	 r = { 0, USHRT_MAX, false }; break;
+	case DataType::UnsignedByte:	 r = { 0, UCHAR_MAX, false }; break;
+	case DataType::PositiveInteger:	 r = { 1, LLONG_MAX, true }; break;
+	case DataType::NonNegativeInteger: r = { 0, LLONG_MAX, true }; break;
+	case DataType::NegativeInteger:	 r = { LLONG_MIN, -1, false }; break;
+	case DataType::NonPositiveInteger: r = { LLONG_MIN, 0, false }; break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+// Integers are limited to 64 bits, signed or, when not negative, unsigned.
+bool parseInteger( const char *p, const char *end, const IntegerRange &r, TypedValue &v )
+{
+	bool negative = false;
+	if ( p < end && ( *p == '+' || *p == '-' ))
+		negative = ( *p++ == '-' );
+
+	unsigned long long mag;
+	if ( ! parseUnsigned( p, end, mag )) return false;
+
+	if ( ! negative && mag > static_cast< unsigned long long >( LLONG_MAX ))
+	{
+		if ( ! r.big ) return false;
+		v.kind = TypedValue::Kind::Unsigned;
+		v.unsignedInteger = mag;
+		return true;
+	}
+
+	long long x;
+	if ( negative )
+	{
+		if ( mag > static_cast< unsigned long long >( LLONG_MAX ) + 1 ) return false;
+		x = ( mag == static_cast< unsigned long long >( LLONG_MAX ) + 1 )
+			? LLONG_MIN : -static_cast< long long >( mag );
+	}
+	else
+		x = static_cast< long long >( mag );
+
+	if ( x < r.low || x > r.high ) return false;
+	v.kind = TypedValue::Kind::Integer;
+	v.integer = x;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// Up to 18 digits after the point; trailing zeros there are dropped.
+bool parseDecimal( const char *p, const char *end, DecimalValue &d )
+{
+	bool negative = false;
+	if ( p < end && ( *p == '+' || *p == '-' ))
+		negative = ( *p++ == '-' );
+
+	unsigned long long v = 0;
+	int scale = 0;
+	int zeros = 0;		// fraction zeros not yet known to be significant
+	bool any = false;
+	bool point = false;
+	for ( ; p < end; p++ )
+	{
+		if ( *p == '.' )
+		{
+			if ( point ) return false;
+			point = true;
+			continue;
+		}
+		if ( ! isDigit( *p )) return false;
+		any = true;
+		unsigned digit = *p - '0';
+		if ( point && digit == 0 )
+		{
+			zeros++;
+			continue;
+		}
+		for ( ; zeros > 0; zeros-- )
+		{
+			if ( v > static_cast< unsigned long long >( LLONG_MAX ) / 10 ) return false;
+			v *= 10;
+			scale++;
+		}
+		if ( v > ( static_cast< unsigned long long >( LLONG_MAX ) - digit ) / 10 ) return false;
+		v = v * 10 + digit;
+		if ( point ) scale++;
+	}
+	if ( ! any || scale > MaxScale ) return false;
+
+	d.digits = negative ? -static_cast< long long >( v ) : static_cast< long long >( v );
+	d.scale = scale;
+	return true;
+}
+
+// The lexical form of xsd:decimal, whatever the number of digits.
+bool decimalForm( const char *p, const char *end )
+{
+	if ( p < end && ( *p == '+' || *p == '-' ))
+		p++;
+	bool any = false;
+	bool point = false;
+	for ( ; p < end; p++ )
+	{
+		if ( *p == '.' )
+		{
+			if ( point ) return false;
+			point = true;
+		}
+		else if ( isDigit( *p ))
+			any = true;
+		else
+			return false;
+	}
+	return any;
+}
+
+// -----------------------------------------------------------------------------
+
+bool parseDouble( const char *p, const char *end, double &x )
+{
+	size_t n = end - p;
+	if ( n == 3 && memcmp( p, "NaN", 3 ) == 0 )
+	{
+		x = NAN;
+		return true;
+	}
+	if (( n == 3 && memcmp( p, "INF", 3 ) == 0 ) || ( n == 4 && memcmp( p, "+INF", 4 ) == 0 ))
+	{
+		x = INFINITY;
+		return true;
+	}
+	if ( n == 4 && memcmp( p, "-INF", 4 ) == 0 )
+	{
+		x = -INFINITY;
+		return true;
+	}
+
+	// check the form ourselves, as strtod takes more than XSD allows
+	const char *q = p;
+	if ( q < end && ( *q == '+' || *q == '-' )) q++;
+	int digits = 0;
+	while ( q < end && isDigit( *q )) { q++; digits++; }
+	if ( expect( q, end, '.' ))
+		while ( q < end && isDigit( *q )) { q++; digits++; }
+	if ( digits == 0 ) return false;
+	if ( q < end && ( *q == 'e' || *q == 'E' ))
+	{
+		q++;
+		if ( q < end && ( *q == '+' || *q == '-' )) q++;
+		int expDigits = 0;
+		while ( q < end && isDigit( *q )) { q++; expDigits++; }
+		if ( expDigits == 0 ) return false;
+	}
+	if ( q != end ) return false;
+
+	// out of range values become infinities or zero, as XSD rounds them
+	x = strtod( p, nullptr );
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool isLeap( int y )
+{
+	return ( y % 4 == 0 && y % 100 != 0 ) || y % 400 == 0;
+}
+
+int daysInMonth( int y, int m )
+{
+	static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	return ( m == 2 && isLeap( y )) ? 29 : days[ m - 1 ];
+}
+
+// days since 1970-01-01 in the proleptic Gregorian calendar
+long long daysFromCivil( long long y, int m, int d )
+{
+	y -= m <= 2;
+	long long era = ( y >= 0 ? y : y - 399 ) / 400;
+	long long yoe = y - era * 400;
+	long long doy = ( 153 * ( m + ( m > 2 ? -3 : 9 )) + 2 ) / 5 + d - 1;
+	long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+void civilFromDays( long long z, int &y, int &m, int &d )
+{
+	z += 719468;
+	long long era = ( z >= 0 ? z : z - 146096 ) / 146097;
+	long long doe = z - era * 146097;
+	long long yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+	long long doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+	long long mp = ( 5 * doy + 2 ) / 153;
+	d = static_cast< int >( doy - ( 153 * mp + 2 ) / 5 + 1 );
+	m = static_cast< int >( mp < 10 ? mp + 3 : mp - 9 );
+	y = static_cast< int >( yoe + era * 400 + ( m <= 2 ));
+}
+
+// at least four digits, with no leading zero when there are more
+bool parseYear( const char *&p, const char *end, int &year )
+{
+	bool negative = expect( p, end, '-' );
+	const char *start = p;
+	long long y = 0;
+	while ( p < end && isDigit( *p ))
+	{
+		y = y * 10 + ( *p++ - '0' );
+		if ( y > INT_MAX ) return false;
+	}
+	size_t n = p - start;
+	if ( n < 4 || ( n > 4 && *start == '0' )) return false;
+	year = negative ? -static_cast< int >( y ) : static_cast< int >( y );
+	return true;
+}
+
+bool parseMonthDay( const char *&p, const char *end, int year, DateTimeValue &v )
+{
+	if ( ! fixedDigits( p, end, 2, v.month ) || v.month < 1 || v.month > 12 ) return false;
+	if ( ! expect( p, end, '-' )) return false;
+	if ( ! fixedDigits( p, end, 2, v.day ) || v.day < 1 ) return false;
+	return v.day <= daysInMonth( year, v.month );
+}
+
+// hh:mm:ss with an optional fraction; 24:00:00 is allowed
+bool parseTime( const char *&p, const char *end, DateTimeValue &v )
+{
+	int sec;
+	if ( ! fixedDigits( p, end, 2, v.hour ) || ! expect( p, end, ':' )) return false;
+	if ( ! fixedDigits( p, end, 2, v.minute ) || ! expect( p, end, ':' )) return false;
+	if ( ! fixedDigits( p, end, 2, sec )) return false;
+	v.second = sec;
+	if ( expect( p, end, '.' ))
+	{
+		double scale = 0.1;
+		const char *start = p;
+		while ( p < end && isDigit( *p ))
+		{
+			v.second += ( *p++ - '0' ) * scale;
+			scale /= 10;
+		}
+		if ( p == start ) return false;
+	}
+	if ( v.minute > 59 || v.second >= 60 ) return false;
+	if ( v.hour == 24 )
+		return v.minute == 0 && v.second == 0;
+	return v.hour < 24;
+}
+
+// Z, or an offset of up to 14 hours, or nothing
+bool parseTimezone( const char *&p, const char *end, DateTimeValue &v )
+{
+	v.hasTimezone = false;
+	v.timezone = 0;
+	if ( p == end ) return true;
+	v.hasTimezone = true;
+	if ( expect( p, end, 'Z' )) return p == end;
+
+	bool negative = false;
+	if ( *p == '+' || *p == '-' )
+		negative = ( *p++ == '-' );
+	else
+		return false;
+	int h, m;
+	if ( ! fixedDigits( p, end, 2, h ) || ! expect( p, end, ':' )) return false;
+	if ( ! fixedDigits( p, end, 2, m ) || m > 59 ) return false;
+	if ( h > 14 || ( h == 14 && m != 0 )) return false;
+	v.timezone = ( negative ? -1 : 1 ) * ( h * 60 + m );
+	return p == end;
+}
+
+bool parseDateTime( const char *p, const char *end, DataType dt, DateTimeValue &v )
+{
+	memset( &v, 0, sizeof( v ));
+	switch ( dt )
+	{
+	case DataType::DateTime:
+	case DataType::DateTimeStamp:
+		if ( ! parseYear( p, end, v.year ) || ! expect( p, end, '-' )) return false;
+		if ( ! parseMonthDay( p, end, v.year, v ) || ! expect( p, end, 'T' )) return false;
+		if ( ! parseTime( p, end, v ) || ! parseTimezone( p, end, v )) return false;
+		if ( dt == DataType::DateTimeStamp && ! v.hasTimezone ) return false;
+		if ( v.hour == 24 )
+		{
+			// the first moment of the next day
+			civilFromDays( daysFromCivil( v.year, v.month, v.day ) + 1,
+					v.year, v.month, v.day );
+			v.hour = 0;
+		}
+		return true;
+
+	case DataType::Data:
+		if ( ! parseYear( p, end, v.year ) || ! expect( p, end, '-' )) return false;
+		return parseMonthDay( p, end, v.year, v ) && parseTimezone( p, end, v );
+
+	case DataType::Time:
+		if ( ! parseTime( p, end, v ) || ! parseTimezone( p, end, v )) return false;
+		if ( v.hour == 24 ) v.hour = 0;
+		return true;
+
+	case DataType::Year:
+		return parseYear( p, end, v.year ) && parseTimezone( p, end, v );
+
+	case DataType::YearMonth:
+		if ( ! parseYear( p, end, v.year ) || ! expect( p, end, '-' )) return false;
+		if ( ! fixedDigits( p, end, 2, v.month ) || v.month < 1 || v.month > 12 ) return false;
+		return parseTimezone( p, end, v );
+
+	case DataType::Month:
+		if ( ! expect( p, end, '-' ) || ! expect( p, end, '-' )) return false;
+		if ( ! fixedDigits( p, end, 2, v.month ) || v.month < 1 || v.month > 12 ) return false;
+		return parseTimezone( p, end, v );
+
+	case DataType::Day:
+		if ( ! expect( p, end, '-' ) || ! expect( p, end, '-' ) || ! expect( p, end, '-' ))
+			return false;
+		if ( ! fixedDigits( p, end, 2, v.day ) || v.day < 1 || v.day > 31 ) return false;
+		return parseTimezone( p, end, v );
+
+	case DataType::MonthDay:
+		// any leap year, so that --02-29 is allowed
+		if ( ! expect( p, end, '-' ) || ! expect( p, end, '-' )) return false;
+		return parseMonthDay( p, end, 2000, v ) && parseTimezone( p, end, v );
+
+	default:
+		return false;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+// PnYnMnDTnHnMnS, with the parts allowed by the data type
+bool parseDuration( const char *p, const char *end, DataType dt, DurationValue &d )
+{
+	bool negative = expect( p, end, '-' );
+	if ( ! expect( p, end, 'P' )) return false;
+
+	static const char designators[] = "YMDHMS";
+	long long months = 0;
+	double seconds = 0;
+	int next = 0;			// the first designator still allowed
+	bool time = false;
+	bool any = false;
+	while ( p < end )
+	{
+		if ( expect( p, end, 'T' ))
+		{
+			if ( time || p == end ) return false;
+			time = true;
+			next = 3;
+			continue;
+		}
+
+		unsigned long long n = 0;
+		const char *start = p;
+		while ( p < end && isDigit( *p ))
+		{
+			unsigned digit = *p++ - '0';
+			if ( n > ( ULLONG_MAX - digit ) / 10 ) return false;
+			n = n * 10 + digit;
+		}
+		if ( p == start ) return false;
+		double fraction = 0;
+		bool hasFraction = expect( p, end, '.' );
+		if ( hasFraction )
+		{
+			double scale = 0.1;
+			const char *f = p;
+			while ( p < end && isDigit( *p ))
+			{
+				fraction += ( *p++ - '0' ) * scale;
+				scale /= 10;
+			}
+			if ( p == f ) return false;
+		}
+		if ( p == end ) return false;
+
+		const char *found = strchr( designators + next, *p++ );
+		if ( found == nullptr || *found == '\0' ) return false;
+		int index = static_cast< int >( found - designators );
+		if ( ( index < 3 ) == time ) return false;	// date part after T or time part before
+		if ( hasFraction && index != 5 ) return false;
+		next = index + 1;
+
+		switch ( index )
+		{
+		case 0:
+			if ( n > static_cast< unsigned long long >( LLONG_MAX ) / 12 - months ) return false;
+			months += n * 12;
+			break;
+		case 1:
+			if ( n > static_cast< unsigned long long >( LLONG_MAX ) - months ) return false;
+			months += n;
+			break;
+		case 2: seconds += n * 86400.0; break;
+		case 3: seconds += n * 3600.0; break;
+		case 4: seconds += n * 60.0; break;
+		default: seconds += n + fraction; break;
+		}
+		any = true;
+	}
+	if ( ! any ) return false;
+	if ( dt == DataType::YearMonthDuration && ( time || next > 2 )) return false;
+	if ( dt == DataType::DayTimeDuration && months != 0 ) return false;
+
+	d.months = negative ? -months : months;
+	d.seconds = negative ? -seconds : seconds;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+int hexValue( char c )
+{
+	if ( c >= '0' && c <= '9' ) return c - '0';
+	if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+	if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+	return -1;
+}
+
+// decode into out if it is not null
+bool decodeHex( const char *p, const char *end, string *out )
+{
+	if (( end - p ) % 2 != 0 ) return false;
+	for ( ; p < end; p += 2 )
+	{
+		int hi = hexValue( p[0] ), lo = hexValue( p[1] );
+		if ( hi < 0 || lo < 0 ) return false;
+		if ( out ) *out += static_cast< char >( hi * 16 + lo );
+	}
+	return true;
+}
+
+int base64Value( char c )
+{
+	if ( c >= 'A' && c <= 'Z' ) return c - 'A';
+	if ( c >= 'a' && c <= 'z' ) return c - 'a' + 26;
+	if ( c >= '0' && c <= '9' ) return c - '0' + 52;
+	if ( c == '+' ) return 62;
+	if ( c == '/' ) return 63;
+	return -1;
+}
+
+// spaces between the characters are ignored, and padding may only end it
+bool decodeBase64( const char *p, const char *end, string *out )
+{
+	unsigned long bits = 0;
+	int count = 0;		// characters in the current group of four
+	int padding = 0;
+	for ( ; p < end; p++ )
+	{
+		if ( *p == ' ' ) continue;
+		if ( *p == '=' )
+		{
+			if ( count < 2 ) return false;
+			padding++;
+			count++;
+		}
+		else
+		{
+			int v = base64Value( *p );
+			if ( v < 0 || padding > 0 ) return false;
+			bits = ( bits << 6 ) | v;
+			count++;
+		}
+		if ( count == 4 )
+		{
+			bits <<= 6 * padding;
+			if ( out )
+			{
+				*out += static_cast< char >(( bits >> 16 ) & 0xFF );
+				if ( padding < 2 ) *out += static_cast< char >(( bits >> 8 ) & 0xFF );
+				if ( padding < 1 ) *out += static_cast< char >( bits & 0xFF );
+			}
+			bits = 0;
+			count = 0;
+			if ( padding > 0 ) break;
+		}
+	}
+	for ( ; p < end; p++ )
+	{
+		if ( *p != ' ' && ! ( *p == '=' && padding > 0 )) return false;
+	}
+	return count == 0;
+}
+
+// -----------------------------------------------------------------------------
+
+TypedValue parse( DataType dt, StringRef value )
+{
+	TypedValue v;
+	const char *p = value.begin();
+	const char *end = value.end();
+	trim( p, end );
+
+	IntegerRange range;
+	bool ok = true;
+	if ( integerRange( dt, range ))
+	{
+		ok = parseInteger( p, end, range, v );
+	}
+	else switch ( dt )
+	{
+	case DataType::Boolean:
+		v.kind = TypedValue::Kind::Boolean;
+		ok = parseBoolean( p, end, v.boolean );
+		break;
+
+	case DataType::Decimal:
+		v.kind = TypedValue::Kind::Decimal;
+		ok = parseDecimal( p, end, v.decimal );
+		if ( ! ok && decimalForm( p, end ))
+		{
+			// valid, but too long to hold exactly
+			v.kind = TypedValue::Kind::Real;
+			v.real = strtod( string( p, end ).c_str(), nullptr );
+			ok = true;
+		}
+		break;
+
+	case DataType::Double:
+	case DataType::Float:
+		v.kind = TypedValue::Kind::Real;
+		ok = parseDouble( p, end, v.real );
+		break;
+
+	case DataType::Data:
+	case DataType::Time:
+	case DataType::DateTime:
+	case DataType::DateTimeStamp:
+	case DataType::Year:
+	case DataType::Month:
+	case DataType::Day:
+	case DataType::YearMonth:
+	case DataType::MonthDay:
+		v.kind = TypedValue::Kind::DateTime;
+		ok = parseDateTime( p, end, dt, v.dateTime );
+		break;
+
+	case DataType::Duration:
+	case DataType::YearMonthDuration:
+	case DataType::DayTimeDuration:
+		v.kind = TypedValue::Kind::Duration;
+		ok = parseDuration( p, end, dt, v.duration );
+		break;
+
+	case DataType::HexBinary:
+		ok = decodeHex( p, end, nullptr );
+		break;
+
+	case DataType::Base64Binary:
+		ok = decodeBase64( p, end, nullptr );
+		break;
+
+	default:
+		// the string types have no other value
+		break;
+	}
+	if ( ! ok )
+	{
+		v = TypedValue();
+		v.kind = TypedValue::Kind::Invalid;
+	}
+	return v;
+}
+
+// -----------------------------------------------------------------------------
+//	Writing values
+// -----------------------------------------------------------------------------
+
+// The shortest digits that read back as x, or as the same float, in the
+// form of printf's %e.
+void shortest( double x, bool single, char *buf, size_t size )
+{
+	for ( int precision = 1; precision <= 17; precision++ )
+	{
+		snprintf( buf, size, "%.*e", precision - 1, x );
+		double y = strtod( buf, nullptr );
+		if ( single ? static_cast< float >( y ) == static_cast< float >( x ) : y == x )
+			return;
+	}
+}
+
+// Write a finite number in plain or scientific notation from its shortest
+// digits. Plain notation always has a digit after the point.
+void writeReal( string &s, double x, bool single, bool plain )
+{
+	char buf[40];
+	shortest( x, single, buf, sizeof( buf ));
+
+	const char *p = buf;
+	if ( *p == '-' ) s += *p++;
+	char digits[20];
+	int n = 0;
+	for ( ; *p && *p != 'e'; p++ )
+		if ( isDigit( *p )) digits[n++] = *p;
+	int exponent = ( *p == 'e' ) ? atoi( p + 1 ) : 0;
+	while ( n > 1 && digits[n - 1] == '0' ) n--;
+
+	if ( plain || ( exponent >= -7 && exponent < 21 ))
+	{
+		if ( exponent < 0 )
+		{
+			s += "0.";
+			s.append( -exponent - 1, '0' );
+			s.append( digits, n );
+		}
+		else if ( exponent + 1 >= n )
+		{
+			s.append( digits, n );
+			s.append( exponent + 1 - n, '0' );
+			s += ".0";
+		}
+		else
+		{
+			s.append( digits, exponent + 1 );
+			s += '.';
+			s.append( digits + exponent + 1, n - exponent - 1 );
+		}
+	}
+	else
+	{
+		s += digits[0];
+		s += '.';
+		if ( n > 1 )
+			s.append( digits + 1, n - 1 );
+		else
+			s += '0';
+		s += 'E';
+		s += to_string( exponent );
+	}
+}
+
+void writeDecimal( string &s, const DecimalValue &d )
+{
+	if ( d.scale < 0 || d.scale > MaxScale )
+		throw VX(Error) << "Decimal scale out of range: " << d.scale;
+
+	unsigned long long v = d.digits < 0
+		? static_cast< unsigned long long >( -( d.digits + 1 )) + 1
+		: static_cast< unsigned long long >( d.digits );
+	if ( d.digits < 0 ) s += '-';
+
+	unsigned long long p = powersOf10[ d.scale ];
+	s += to_string( v / p );
+	s += '.';
+	if ( d.scale == 0 )
+	{
+		s += '0';
+		return;
+	}
+	string fraction = to_string( v % p );
+	s.append( d.scale - fraction.size(), '0' );
+	s += fraction;
+}
+
+void writeDigits( string &s, int v, int width )
+{
+	char buf[16];
+	snprintf( buf, sizeof( buf ), "%0*d", width, v );
+	s += buf;
+}
+
+// The shortest digits of the whole number, so that 5.1 is not written as
+// 5 and the nearest double to 0.1.
+void writeSeconds( string &s, double seconds )
+{
+	string text;
+	writeReal( text, seconds, false, true );
+	size_t point = text.find( '.' );
+	if ( point < 2 )
+		s.append( 2 - point, '0' );
+	s.append( text, 0, point );
+	if ( text.compare( point, string::npos, ".0" ) != 0 )
+		s.append( text, point, string::npos );
+}
+
+void writeDateTime( string &s, const DateTimeValue &v, DataType dt )
+{
+	auto year = [&]()
+	{
+		if ( v.year < 0 ) s += '-';
+		writeDigits( s, v.year < 0 ? -v.year : v.year, 4 );
+	};
+	auto time = [&]()
+	{
+		writeDigits( s, v.hour, 2 );
+		s += ':';
+		writeDigits( s, v.minute, 2 );
+		s += ':';
+		writeSeconds( s, v.second );
+	};
+
+	switch ( dt )
+	{
+	case DataType::DateTime:
+	case DataType::DateTimeStamp:
+		year();
+		s += '-'; writeDigits( s, v.month, 2 );
+		s += '-'; writeDigits( s, v.day, 2 );
+		s += 'T';
+		time();
+		break;
+	case DataType::Data:
+		year();
+		s += '-'; writeDigits( s, v.month, 2 );
+		s += '-'; writeDigits( s, v.day, 2 );
+		break;
+	case DataType::Time:
+		time();
+		break;
+	case DataType::Year:
+		year();
+		break;
+	case DataType::YearMonth:
+		year();
+		s += '-'; writeDigits( s, v.month, 2 );
+		break;
+	case DataType::Month:
+		s += "--"; writeDigits( s, v.month, 2 );
+		break;
+	case DataType::Day:
+		s += "---"; writeDigits( s, v.day, 2 );
+		break;
+	case DataType::MonthDay:
+		s += "--"; writeDigits( s, v.month, 2 );
+		s += '-'; writeDigits( s, v.day, 2 );
+		break;
+	default:
+		throw VX(Code) << "Not a date or time type";
+	}
+
+	if ( v.hasTimezone )
+	{
+		if ( v.timezone == 0 )
+			s += 'Z';
+		else
+		{
+			int tz = v.timezone < 0 ? -v.timezone : v.timezone;
+			s += ( v.timezone < 0 ) ? '-' : '+';
+			writeDigits( s, tz / 60, 2 );
+			s += ':';
+			writeDigits( s, tz % 60, 2 );
+		}
+	}
+}
+
+void writeDuration( string &s, const DurationValue &d, DataType dt )
+{
+	if ( dt != DataType::Duration && dt != DataType::YearMonthDuration
+			&& dt != DataType::DayTimeDuration )
+		throw VX(Code) << "Not a duration type";
+	if (( d.months < 0 && d.seconds > 0 ) || ( d.months > 0 && d.seconds < 0 ))
+		throw VX(Error) << "Duration parts have different signs";
+	if ( dt == DataType::YearMonthDuration && d.seconds != 0 )
+		throw VX(Error) << "A year month duration has no days or time";
+	if ( dt == DataType::DayTimeDuration && d.months != 0 )
+		throw VX(Error) << "A day time duration has no years or months";
+
+	if ( d.months < 0 || d.seconds < 0 ) s += '-';
+	s += 'P';
+	if ( d.months == 0 && d.seconds == 0 )
+	{
+		s += ( dt == DataType::YearMonthDuration ) ? "0M" : "T0S";
+		return;
+	}
+
+	unsigned long long months = d.months < 0 ? -d.months : d.months;
+	if ( months >= 12 ) s += to_string( months / 12 ) + 'Y';
+	if ( months % 12 ) s += to_string( months % 12 ) + 'M';
+
+	double seconds = fabs( d.seconds );
+	long long days = static_cast< long long >( seconds / 86400 );
+	seconds -= days * 86400.0;
+	if ( days ) s += to_string( days ) + 'D';
+	if ( seconds > 0 )
+	{
+		s += 'T';
+		int hours = static_cast< int >( seconds / 3600 );
+		seconds -= hours * 3600.0;
+		int minutes = static_cast< int >( seconds / 60 );
+		seconds -= minutes * 60.0;
+		if ( hours ) s += to_string( hours ) + 'H';
+		if ( minutes ) s += to_string( minutes ) + 'M';
+		if ( seconds > 0 )
+		{
+			string sec;
+			writeReal( sec, seconds, false, true );
+			if ( sec.size() > 2 && sec.compare( sec.size() - 2, 2, ".0" ) == 0 )
+				sec.resize( sec.size() - 2 );
+			s += sec + 'S';
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+//	Comparing values
+// -----------------------------------------------------------------------------
+
+template < typename T >
+int sign( T a, T b )
+{
+	return ( a < b ) ? -1 : ( b < a ? 1 : 0 );
+}
+
+double toReal( const TypedValue &v )
+{
+	switch ( v.kind )
+	{
+	case TypedValue::Kind::Integer: return static_cast< double >( v.integer );
+	case TypedValue::Kind::Unsigned: return static_cast< double >( v.unsignedInteger );
+	case TypedValue::Kind::Decimal: return v.decimal.toDouble();
+	default: return v.real;
+	}
+}
+
+// Exact: the remainders, once brought to the same scale, are below 10^18.
+int compareDecimals( const DecimalValue &a, const DecimalValue &b )
+{
+	long long pa = powersOf10[ a.scale ], pb = powersOf10[ b.scale ];
+	int c = sign( a.digits / pa, b.digits / pb );
+	if ( c != 0 ) return c;
+	int scale = a.scale > b.scale ? a.scale : b.scale;
+	return sign(( a.digits % pa ) * powersOf10[ scale - a.scale ],
+			( b.digits % pb ) * powersOf10[ scale - b.scale ] );
+}
+
+// NaN sorts after everything else, and equal to itself
+int compareNumbers( const TypedValue &a, const TypedValue &b )
+{
+	using Kind = TypedValue::Kind;
+	if ( a.kind == Kind::Real || b.kind == Kind::Real )
+	{
+		double x = toReal( a ), y = toReal( b );
+		if ( std::isnan( x ) || std::isnan( y ))
+			return sign( std::isnan( x ), std::isnan( y ));
+		return sign( x, y );
+	}
+	if ( a.kind == Kind::Unsigned || b.kind == Kind::Unsigned )
+	{
+		// only integers above LLONG_MAX are held as unsigned
+		if ( a.kind == b.kind )
+			return sign( a.unsignedInteger, b.unsignedInteger );
+		return ( a.kind == Kind::Unsigned ) ? 1 : -1;
+	}
+	if ( a.kind == Kind::Integer && b.kind == Kind::Integer )
+		return sign( a.integer, b.integer );
+
+	DecimalValue x = ( a.kind == Kind::Decimal ) ? a.decimal : DecimalValue{ a.integer, 0 };
+	DecimalValue y = ( b.kind == Kind::Decimal ) ? b.decimal : DecimalValue{ b.integer, 0 };
+	return compareDecimals( x, y );
+}
+
+// A missing timezone is taken as UTC.
+double instant( const DateTimeValue &v )
+{
+	long long days = ( v.year || v.month || v.day )
+		? daysFromCivil( v.year, v.month ? v.month : 1, v.day ? v.day : 1 ) : 0;
+	return days * 86400.0 + v.hour * 3600.0 + v.minute * 60.0 + v.second
+		- ( v.hasTimezone ? v.timezone * 60.0 : 0 );
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+//	DecimalValue
+// -----------------------------------------------------------------------------
+
+double
+DecimalValue::toDouble() const
+{
+	if ( scale < 0 || scale > MaxScale )
+		throw VX(Error) << "Decimal scale out of range: " << scale;
+	return static_cast< double >( digits ) / static_cast< double >( powersOf10[ scale ] );
+}
+
+// -----------------------------------------------------------------------------
+//	Literal
+// -----------------------------------------------------------------------------
+
+Literal::Literal( int x, DataType dt )
+	: Literal( static_cast< long long >( x ), dt )
+{}
+
+// -----------------------------------------------------------------------------
+
+Literal::Literal( long long x, DataType dt )
+	: mDataType(dt), mValue( to_string( x )), mParsed( false )
+{
+	TypedValue v;
+	v.kind = TypedValue::Kind::Integer;
+	v.integer = x;
+	IntegerRange r;
+	if ( integerRange( dt, r ) && x >= r.low && x <= r.high )
+		typed( v );
+}
+
+// -----------------------------------------------------------------------------
+
+Literal::Literal( unsigned long long x, DataType dt )
+	: mDataType(dt), mValue( to_string( x )), mParsed( false )
+{
+	IntegerRange r;
+	if ( x > static_cast< unsigned long long >( LLONG_MAX ))
+	{
+		TypedValue v;
+		v.kind = TypedValue::Kind::Unsigned;
+		v.unsignedInteger = x;
+		if ( integerRange( dt, r ) && r.big )
+			typed( v );
+	}
+	else
+	{
+		TypedValue v;
+		v.kind = TypedValue::Kind::Integer;
+		v.integer = static_cast< long long >( x );
+		if ( integerRange( dt, r ) && v.integer >= r.low && v.integer <= r.high )
+			typed( v );
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+Literal::Literal( double x, DataType dt )
+	: mDataType(dt), mParsed( false )
+{
+	bool decimal = ( dt == DataType::Decimal );
+	if ( std::isnan( x ))
+		mValue = "NaN";
+	else if ( std::isinf( x ))
+		mValue = ( x < 0 ) ? "-INF" : "INF";
+	else
+		writeReal( mValue, x, dt == DataType::Float, decimal );
+
+	if ( decimal && ! std::isfinite( x ))
+		throw VX(Error) << "No decimal for " << mValue;
+	if ( dt == DataType::Double )
+	{
+		// the shortest form reads back as x
+		TypedValue v;
+		v.kind = TypedValue::Kind::Real;
+		v.real = x;
+		typed( v );
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+Literal::Literal( const DecimalValue &d )
+	: mDataType( DataType::Decimal ), mParsed( false )
+{
+	writeDecimal( mValue, d );
+	TypedValue v;
+	v.kind = TypedValue::Kind::Decimal;
+	v.decimal = d;
+	typed( v );
+}
+
+// -----------------------------------------------------------------------------
+
+Literal::Literal( const DateTimeValue &d, DataType dt )
+	: mDataType( dt ), mParsed( false )
+{
+	writeDateTime( mValue, d, dt );
+}
+
+// -----------------------------------------------------------------------------
+
+Literal::Literal( const DurationValue &d, DataType dt )
+	: mDataType( dt ), mParsed( false )
+{
+	writeDuration( mValue, d, dt );
+}
+
+// -----------------------------------------------------------------------------
+
+Literal::Literal( bool x)
+	: mDataType(DataType::Boolean), mParsed( false )
+{
+	mValue = (x ? "true" : "false");
+	TypedValue v;
+	v.kind = TypedValue::Kind::Boolean;
+	v.boolean = x;
+	typed( v );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+Literal::typed( const TypedValue &v ) const
+{
+	mTyped = v;
+	mParsed = true;
+}
+
+// -----------------------------------------------------------------------------
+
+const TypedValue &
+Literal::typedValue() const
+{
+	if ( ! mParsed )
+		typed( parse( mDataType, mValue ));
+	return mTyped;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+Literal::isValid() const
+{
+	return typedValue().kind != TypedValue::Kind::Invalid;
+}
+
+// -----------------------------------------------------------------------------
+
+// Numbers of other types are truncated. A value of a type with no number,
+// such as a plain literal, is read as an integer.
+long long
+Literal::asLong() const
+{
+	const TypedValue &v = typedValue();
+	switch ( v.kind )
+	{
+	case TypedValue::Kind::Integer:
+		return v.integer;
+	case TypedValue::Kind::Decimal:
+		return v.decimal.digits / powersOf10[ v.decimal.scale ];
+	case TypedValue::Kind::Real:
+		if ( ! ( v.real > -9223372036854775808.0 && v.real < 9223372036854775808.0 ))
+			throw VX(Error) << "Value out of range: " << mValue;
+		return static_cast< long long >( v.real );
+	case TypedValue::Kind::Boolean:
+		return v.boolean ? 1 : 0;
+	case TypedValue::Kind::Unsigned:
+		throw VX(Error) << "Value out of range: " << mValue;
+	default:
+		break;
+	}
+
+	TypedValue x = parse( DataType::Integer, mValue );
+	if ( x.kind == TypedValue::Kind::Integer )
+		return x.integer;
+	throw VX(Error) << "Not an integer: " << mValue;
+}
+
+// -----------------------------------------------------------------------------
+
+int
+Literal::asInteger() const
+{
+	long long x = asLong();
+	if ( x < INT_MIN || x > INT_MAX )
+		throw VX(Error) << "Value out of range: " << mValue;
+	return static_cast< int >( x );
+}
+
+// -----------------------------------------------------------------------------
+
+unsigned long long
+Literal::asUnsignedLong() const
+{
+	const TypedValue &v = typedValue();
+	if ( v.kind == TypedValue::Kind::Unsigned )
+		return v.unsignedInteger;
+	if ( v.kind == TypedValue::Kind::None )
+	{
+		TypedValue x = parse( DataType::NonNegativeInteger, mValue );
+		if ( x.kind == TypedValue::Kind::Unsigned )
+			return x.unsignedInteger;
+	}
+	long long x = asLong();
+	if ( x < 0 )
+		throw VX(Error) << "Value out of range: " << mValue;
+	return static_cast< unsigned long long >( x );
+}
+
+// -----------------------------------------------------------------------------
+
+DecimalValue
+Literal::asDecimal() const
+{
+	const TypedValue &v = typedValue();
+	switch ( v.kind )
+	{
+	case TypedValue::Kind::Decimal:
+		return v.decimal;
+	case TypedValue::Kind::Integer:
+		return DecimalValue{ v.integer, 0 };
+	case TypedValue::Kind::Real:
+		if ( std::isfinite( v.real ))
+		{
+			string s;
+			DecimalValue d;
+			writeReal( s, v.real, mDataType == DataType::Float, true );
+			if ( parseDecimal( s.data(), s.data() + s.size(), d ))
+				return d;
+		}
+		throw VX(Error) << "Value out of range: " << mValue;
+	case TypedValue::Kind::None:
+		{
+			TypedValue x = parse( DataType::Decimal, mValue );
+			if ( x.kind == TypedValue::Kind::Decimal )
+				return x.decimal;
+		}
+		break;
+	default:
+		break;
+	}
+	throw VX(Error) << "Not a decimal: " << mValue;
+}
+
+// -----------------------------------------------------------------------------
+
+// A value of a type with no number, such as a plain literal, is read as a
+// double.
+double
+Literal::asDouble() const
+{
+	const TypedValue &v = typedValue();
+	if ( v.isNumeric() )
+		return toReal( v );
+	if ( v.kind == TypedValue::Kind::None )
+	{
+		TypedValue x = parse( DataType::Double, mValue );
+		if ( x.kind == TypedValue::Kind::Real )
+			return x.real;
+	}
+	throw VX(Error) << "Not a number: " << mValue;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+Literal::asBoolean() const
+{
+	const TypedValue &v = typedValue();
+	if ( v.kind == TypedValue::Kind::Boolean )
+		return v.boolean;
+	return ( mValue == "true" );
+}
+
+// -----------------------------------------------------------------------------
+
+DateTimeValue
+Literal::asDateTime() const
+{
+	const TypedValue &v = typedValue();
+	if ( v.kind != TypedValue::Kind::DateTime )
+		throw VX(Error) << "Not a date or time: " << mValue;
+	return v.dateTime;
+}
+
+// -----------------------------------------------------------------------------
+
+DurationValue
+Literal::asDuration() const
+{
+	const TypedValue &v = typedValue();
+	if ( v.kind != TypedValue::Kind::Duration )
+		throw VX(Error) << "Not a duration: " << mValue;
+	return v.duration;
+}
+
+// -----------------------------------------------------------------------------
+
+// Not kept, as the bytes would need their own storage.
+std::string
+Literal::asBinary() const
+{
+	const char *p = mValue.data();
+	const char *end = p + mValue.size();
+	trim( p, end );
+	string bytes;
+	bool ok = false;
+	if ( mDataType == DataType::HexBinary )
+		ok = decodeHex( p, end, &bytes );
+	else if ( mDataType == DataType::Base64Binary )
+		ok = decodeBase64( p, end, &bytes );
+	if ( ! ok )
+		throw VX(Error) << "Not binary data: " << mValue;
+	return bytes;
+}
+
+// -----------------------------------------------------------------------------
+
+int
+Literal::compare( const Literal &other ) const
+{
+	const TypedValue &a = typedValue();
+	const TypedValue &b = other.typedValue();
+
+	if ( a.isNumeric() && b.isNumeric() )
+		return compareNumbers( a, b );
+	if ( a.kind == b.kind && mDataType == other.mDataType )
+	{
+		switch ( a.kind )
+		{
+		case TypedValue::Kind::Boolean:
+			return sign( a.boolean, b.boolean );
+		case TypedValue::Kind::DateTime:
+			return sign( instant( a.dateTime ), instant( b.dateTime ));
+		case TypedValue::Kind::Duration:
+		{
+			int c = sign( a.duration.months, b.duration.months );
+			return c ? c : sign( a.duration.seconds, b.duration.seconds );
+		}
+		default:
+			break;
+		}
+	}
+
+	int c = sign( static_cast< int >( mDataType ), static_cast< int >( other.mDataType ));
+	if ( c == 0 ) c = mValue.compare( other.mValue );
+	if ( c == 0 ) c = mLanguage.compare( other.mLanguage );
+	return ( c < 0 ) ? -1 : ( c > 0 ? 1 : 0 );
+}
+
+// -----------------------------------------------------------------------------
+//	TermView
+// -----------------------------------------------------------------------------
+
+TypedValue
+TermView::typedValue() const
+{
+	if ( ! isLiteral() )
+		return TypedValue();
+	StringRef dt = datatype();
+	if ( dt.empty() )
+		return TypedValue();
+	return parse( Literal::fromURI( dt.data(), dt.size() ), value() );
+}
+
+// -----------------------------------------------------------------------------
+//	Data types
+// -----------------------------------------------------------------------------
+//
+// The names of the data types are held in a table indexed by DataType, so
+// converting a data type to a name is an array access. The full IRIs are
+// found through a perfect hash: FNV-1a from TypeSeed, where the top seven
+// bits of the hash select a slot in typeSlots. The seed was found by trying
+// successive values until no two IRIs shared a slot. The names for people
+// are found the same way, from NameSeed through nameSlots. When a data type
+// is added, add it here in enum order and find new seeds and slot tables;
+// the static_asserts below fail until they are right.
+
+namespace
+{
+
+#define RDF_NS "http://www.w3.org/1999/02/22-rdf-syntax-ns#"
+#define XSD_NS "http://www.w3.org/2001/XMLSchema#"
+#define RDF_TYPE( dt, local, name ) \
+	{ DataType::dt, "rdf:" local, name, RDF_NS local, sizeof( RDF_NS local ) - 1 }
+#define XSD_TYPE( dt, local, name ) \
+	{ DataType::dt, "xsd:" local, name, XSD_NS local, sizeof( XSD_NS local ) - 1 }
+
+struct TypeEntry
+{
+	DataType type;
+	const char *xsd;	// prefixed form, eg "xsd:integer"
+	const char *name;	// for people
+	const char *iri;
+	size_t length;		// of the IRI
+};
+
+constexpr TypeEntry dataTypes[] =
+{
+	{ DataType::UNDEF, "", "", "", 0 },
+
+	RDF_TYPE( PlainLiteral, "PlainLiteral", "PlainLiteral" ),
+	RDF_TYPE( XMLLiteral, "XMLLiteral", "XMLLiteral" ),
+	RDF_TYPE( XHTML, "HTML", "HTML" ),
+
+	XSD_TYPE( String, "string", "string" ),
+	XSD_TYPE( Boolean, "boolean", "boolean" ),
+	XSD_TYPE( Decimal, "decimal", "decimal" ),
+	XSD_TYPE( Integer, "integer", "integer" ),
+
+	XSD_TYPE( Double, "double", "double" ),
+	XSD_TYPE( Float, "float", "float" ),
+
+	XSD_TYPE( Data, "date", "date" ),
+	XSD_TYPE( Time, "time", "time" ),
+	XSD_TYPE( DateTime, "dateTime", "date time" ),
+	XSD_TYPE( DateTimeStamp, "dateTimeStamp", "date time stamp" ),
+
+	XSD_TYPE( Year, "gYear", "Year" ),
+	XSD_TYPE( Month, "gMonth", "Month" ),
+	XSD_TYPE( Day, "gDay", "Day" ),
+	XSD_TYPE( YearMonth, "gYearMonth", "Year Month" ),
+	XSD_TYPE( MonthDay, "gMonthDay", "Month Day" ),
+	XSD_TYPE( Duration, "duration", "duration" ),
+	XSD_TYPE( YearMonthDuration, "yearMonthDuration", "year month duration" ),
+	XSD_TYPE( DayTimeDuration, "dayTimeDuration", "day time duration" ),
+
+	XSD_TYPE( Byte, "byte", "byte" ),
+	XSD_TYPE( Short, "short", "short" ),
+	XSD_TYPE( Int, "int", "int" ),
+	XSD_TYPE( Long, "long", "long" ),
+	XSD_TYPE( UnsignedByte, "unsignedByte", "unsigned byte" ),
+	XSD_TYPE( UnsignedShort, "unsignedShort", "unsigned short" ),
+	XSD_TYPE( UnsignedLong, "unsignedLong", "unsigned long" ),
+	XSD_TYPE( PositiveInteger, "positiveInteger", "positive integer" ),
+	XSD_TYPE( NonNegativeInteger, "nonNegativeInteger", "non-negative integer" ),
+	XSD_TYPE( NegativeInteger, "negativeInteger", "negative integer" ),
+	XSD_TYPE( NonPositiveInteger, "nonPositiveInteger", "non-positive integer" ),
+
+	XSD_TYPE( HexBinary, "hexBinary", "hex binary" ),
+	XSD_TYPE( Base64Binary, "base64Binary", "base 64 binary" ),
+
+	XSD_TYPE( AnyURI, "anyURI", "any URI" ),
+	XSD_TYPE( Language, "language", "language" ),
+	XSD_TYPE( NormalizedString, "normalizedString", "normalized string" ),
+	XSD_TYPE( Token, "token", "token" ),
+	XSD_TYPE( NMTOKEN, "NMTOKEN", "NMTOKEN" ),
+	XSD_TYPE( Name, "Name", "Name" ),
+	XSD_TYPE( NCName, "NCName", "NCName" ),
+
+	XSD_TYPE( UnsignedInt, "unsignedInt", "unsigned int" )
+};
+
+#undef XSD_TYPE
+#undef RDF_TYPE
+
+const size_t numDataTypes = sizeof( dataTypes ) / sizeof( dataTypes[0] );
+
+const uint32_t TypeSeed = 2166138045u;
+const int TypeSlotBits = 7;
+
+// the index in dataTypes of the IRI in each slot, zero for none
+constexpr unsigned char typeSlots[ 1 << TypeSlotBits ] =
+{
+	0, 0, 0, 11, 17, 0, 0, 0, 21, 0, 0, 0, 31, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 35, 20, 22, 10, 0, 26, 3, 25, 0, 0,
+	0, 19, 0, 0, 0, 0, 0, 34, 39, 0, 0, 0, 16, 40, 0, 0,
+	0, 28, 0, 0, 0, 14, 9, 0, 0, 0, 0, 0, 0, 0, 29, 0,
+	0, 0, 0, 0, 5, 0, 32, 0, 0, 33, 37, 30, 0, 0, 6, 4,
+	0, 36, 0, 1, 0, 0, 42, 0, 0, 12, 0, 0, 8, 0, 41, 0,
+	0, 0, 0, 2, 0, 18, 0, 0, 13, 0, 15, 0, 0, 0, 0, 0,
+	24, 0, 38, 0, 0, 0, 0, 0, 0, 27, 7, 23, 0, 0, 0, 0
+};
+
+const uint32_t NameSeed = 2166136386u;
+
+// the index in dataTypes of the name in each slot, zero for none
+constexpr unsigned char nameSlots[ 1 << TypeSlotBits ] =
+{
+	14, 0, 0, 0, 37, 0, 0, 26, 0, 0, 0, 17, 0, 0, 0, 0,
+	0, 0, 0, 0, 4, 0, 0, 33, 18, 0, 0, 0, 11, 27, 0, 0,
+	0, 28, 9, 0, 19, 20, 38, 0, 3, 0, 0, 23, 2, 0, 21, 0,
+	0, 0, 0, 0, 0, 22, 0, 34, 0, 32, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 31, 0, 0, 0, 30, 0, 0, 0, 0, 6, 24, 0, 40,
+	10, 0, 42, 0, 25, 13, 0, 0, 0, 1, 0, 29, 0, 0, 0, 0,
+	0, 0, 12, 36, 0, 0, 0, 16, 0, 0, 0, 0, 0, 8, 35, 0,
+	41, 5, 15, 0, 0, 0, 39, 7, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+constexpr uint32_t typeHash( const char *s, uint32_t h )
+{
+	return *s ? typeHash( s + 1, ( h ^ static_cast< unsigned char >( *s )) * 16777619u ) : h;
+}
+
+uint32_t typeHash( const char *s, size_t len, uint32_t h )
+{
+	for ( const char *end = s + len; s < end; s++ )
+		h = ( h ^ static_cast< unsigned char >( *s )) * 16777619u;
+	return h;
+}
+
+constexpr unsigned typeSlot( uint32_t h )
+{
+	return h >> ( 32 - TypeSlotBits );
+}
+
+// every entry is at the index of its data type
+constexpr bool inEnumOrder( size_t i )
+{
+	return i == numDataTypes
+		|| ( dataTypes[i].type == static_cast< DataType >( i ) && inEnumOrder( i + 1 ));
+}
+
+// every IRI hashes to the slot that holds it
+constexpr bool slotsMatch( size_t i )
+{
+	return i == numDataTypes
+		|| ( typeSlots[ typeSlot( typeHash( dataTypes[i].iri, TypeSeed )) ] == i
+			&& slotsMatch( i + 1 ));
+}
+
+// every name hashes to the slot that holds it
+constexpr bool nameSlotsMatch( size_t i )
+{
+	return i == numDataTypes
+		|| ( nameSlots[ typeSlot( typeHash( dataTypes[i].name, NameSeed )) ] == i
+			&& nameSlotsMatch( i + 1 ));
+}
+
+static_assert( numDataTypes == static_cast< size_t >( DataType::UnsignedInt ) + 1,
+		"dataTypes must have an entry for every DataType" );
+static_assert( inEnumOrder( 0 ), "dataTypes must be in DataType order" );
+static_assert( slotsMatch( 1 ), "typeSlots does not match TypeSeed and dataTypes" );
+static_assert( nameSlotsMatch( 1 ), "nameSlots does not match NameSeed and dataTypes" );
+
+const TypeEntry & entry( DataType dt )
+{
+	size_t i = static_cast< size_t >( dt );
+	return dataTypes[ i < numDataTypes ? i : 0 ];
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+URI
+Literal::dataTypeURI( World w ) const
+{
+	if ( mDataType == DataType::UNDEF )
+		throw VX(Code) << "Literal not initialised";
+	return URI( w, entry( mDataType ).iri );
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+std::string
+Literal::toXSD( DataType dt )
+{
+	return entry( dt ).xsd;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+std::string
+Literal::toTypeName( DataType dt )
+{
+	return entry( dt ).name;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+DataType
+Literal::toDataType( const std::string & xsd_type )
+{
+	// hash the IRI the prefixed form stands for, without building it
+	uint32_t h;
+	size_t nsLength;
+	if ( xsd_type.compare( 0, 4, "xsd:" ) == 0 )
+	{
+		h = typeHash( XSD_NS, TypeSeed );
+		nsLength = sizeof( XSD_NS ) - 1;
+	}
+	else if ( xsd_type.compare( 0, 4, "rdf:" ) == 0 )
+	{
+		h = typeHash( RDF_NS, TypeSeed );
+		nsLength = sizeof( RDF_NS ) - 1;
+	}
+	else
+		return DataType::UNDEF;
+
+	const char *local = xsd_type.data() + 4;
+	size_t len = xsd_type.size() - 4;
+	const TypeEntry &e = dataTypes[ typeSlots[ typeSlot( typeHash( local, len, h )) ]];
+	if ( e.length == nsLength + len && xsd_type.compare( 0, 4, e.xsd, 4 ) == 0
+			&& memcmp( e.iri + nsLength, local, len ) == 0 )
+		return e.type;
+	return DataType::UNDEF;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+DataType
+Literal::fromURI( const char *uri, size_t len )
+{
+	const TypeEntry &e = dataTypes[ typeSlots[ typeSlot( typeHash( uri, len, TypeSeed )) ]];
+	if ( e.length == len && len > 0 && memcmp( e.iri, uri, len ) == 0 )
+		return e.type;
+	return DataType::UNDEF;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+DataType
+Literal::asDataType( const std::string & type_name )
+{
+	const TypeEntry &e = dataTypes[ nameSlots[ typeSlot(
+			typeHash( type_name.data(), type_name.size(), NameSeed )) ]];
+	if ( ! type_name.empty() && type_name == e.name )
+		return e.type;
+	return DataType::UNDEF;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+std::vector< std::string >
+Literal::getDataTypeNames()
+{
+	vector< string > res;
+	res.reserve( numDataTypes - 1 );
+	for ( size_t i = 1; i < numDataTypes; i++ )
+	{
+		res.push_back( dataTypes[i].name );
+	}
+	return res;
+}
+
+// ---------------------------- end --------------------------------------------
@@ -0,0 +1,922 @@
+/* RDF C++ API
+ *
+ * 			loader.cpp
+ *
+ * 	Copyright 2017		Brenton Ross
+ *
+ * -----------------------------------------------------------------------------
+ * LICENSE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <rdfxx/except.h>
+#include <rdfxx/loader.hpp>
+#include <rdfxx/model.hpp>
+#include <rdfxx/node.hpp>
+#include <rdfxx/world.hpp>
+
+using namespace rdf;
+using namespace std;
+
+namespace
+{
+
+// chunks are about this size, but there are at least four per worker
+const size_t ChunkBytes = 16 * 1024 * 1024;
+
+// and not so many that they get very small
+const size_t MinChunkBytes = 64 * 1024;
+
+// the messages kept from each worker
+const size_t MaxMessages = 100;
+
+// the pipeline passes smaller batches so that the inserter starts sooner
+const size_t PipelineBatch = 4096;
+const size_t PipelineSlots = 16;
+
+// ---- a read only mapping of a whole file -----------------------------------
+
+class MappedFile
+{
+	void *base;
+	size_t len;
+public:
+	explicit MappedFile( const std::string & path )
+		: base( nullptr ), len( 0 )
+	{
+		int fd = open( path.c_str(), O_RDONLY );
+		if ( fd < 0 )
+			throw VX(Error) << "Cannot open " << path << ": " << strerror( errno );
+
+		struct stat sb;
+		if ( fstat( fd, &sb ) != 0 )
+		{
+			close( fd );
+			throw VX(Error) << "Cannot read " << path << ": " << strerror( errno );
+		}
+		len = sb.st_size;
+		if ( len > 0 )
+		{
+			base = mmap( nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0 );
+			if ( base == MAP_FAILED )
+			{
+				close( fd );
+				throw VX(Error) << "Cannot map " << path << ": " << strerror( errno );
+			}
+			// each worker reads its chunks from start to end
+			madvise( base, len, MADV_SEQUENTIAL );
+		}
+		close( fd );
+	}
+
+	~MappedFile()
+	{
+		if ( base ) munmap( base, len );
+	}
+
+	MappedFile( const MappedFile & ) = delete;
+	MappedFile & operator = ( const MappedFile & ) = delete;
+
+	const char *data() const { return static_cast< const char * >( base ); }
+	size_t size() const { return len; }
+};
+
+// ---- the messages from one worker world ------------------------------------
+
+class Collector : public ErrorClient
+{
+public:
+	std::vector< std::string > errors;
+	std::vector< std::string > warnings;
+
+	void handleError( const std::string & message )
+	{
+		if ( errors.size() < MaxMessages ) errors.push_back( message );
+	}
+
+	void handleWarning( const std::string & message )
+	{
+		if ( warnings.size() < MaxMessages ) warnings.push_back( message );
+	}
+};
+
+// ---- waiting on the ring ----------------------------------------------------
+
+void
+backOff( unsigned & tries )
+{
+	if ( ++tries < 16 )
+		std::this_thread::yield();
+	else
+		std::this_thread::sleep_for( std::chrono::microseconds( 100 ));
+}
+
+double
+secondsSince( std::chrono::steady_clock::time_point start )
+{
+	return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+}
+
+// ---- blank node labels -----------------------------------------------------
+
+bool
+endsLabel( char c )
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n'
+		|| c == '<' || c == '"' || c == '#';
+}
+
+// the end of a blank node label that starts at p, after the "_:"
+const char *
+labelEnd( const char *p, const char *end )
+{
+	const char *q = p;
+	while ( q < end && ! endsLabel( *q )) q++;
+	// a label cannot end with a '.', that ends the statement
+	while ( q > p && q[-1] == '.' ) q--;
+	return q;
+}
+
+//
+// Copy N-Triples or N-Quads text replacing each blank node label "_:x" with
+// the IRI <scheme x>. Returns false, without copying, if there are none.
+//
+bool
+rewriteBlanks( const char *text, size_t len, const std::string & scheme, std::string & out )
+{
+	const char *end = text + len;
+	const char *p = text;
+	bool any = false;
+	while ( ! any && p < end )
+	{
+		p = static_cast< const char * >( memchr( p, '_', end - p ));
+		if ( ! p ) break;
+		p++;
+		any = ( p < end && *p == ':' );
+	}
+	if ( ! any ) return false;
+
+	out.clear();
+	out.reserve( len + len / 8 );
+
+	enum { Plain, InIRI, InLiteral, InComment } state = Plain;
+	p = text;
+	while ( p < end )
+	{
+		char c = *p;
+		if ( c == '\n' )
+		{
+			// recover at the next line from anything unterminated
+			state = Plain;
+		}
+		else if ( state == Plain )
+		{
+			if ( c == '_' && p + 1 < end && p[1] == ':' )
+			{
+				const char *q = labelEnd( p + 2, end );
+				out += '<';
+				out += scheme;
+				out.append( p + 2, q - p - 2 );
+				out += '>';
+				p = q;
+				continue;
+			}
+			if ( c == '<' ) state = InIRI;
+			else if ( c == '"' ) state = InLiteral;
+			else if ( c == '#' ) state = InComment;
+		}
+		else if ( state == InIRI )
+		{
+			if ( c == '>' ) state = Plain;
+		}
+		else if ( state == InLiteral )
+		{
+			if ( c == '\\' && p + 1 < end && p[1] != '\n' )
+			{
+				out += c;
+				c = *++p;
+			}
+			else if ( c == '"' )
+			{
+				state = Plain;
+			}
+		}
+		out += c;
+		p++;
+	}
+	return true;
+}
+
+//
+// Append the blank node labels of N-Triples or N-Quads text that are not yet
+// in labels, in the order a parser would first report them: as subjects
+// and objects, since graph names are dropped.
+//
+void
+scanBlanks( const char *text, size_t len, std::vector< std::string > & labels )
+{
+	std::unordered_set< std::string > seen;
+	const char *end = text + len;
+	enum { Plain, InIRI, InLiteral, InComment } state = Plain;
+	int term = 0;		// the position of the next term in the statement
+	for ( const char *p = text; p < end; p++ )
+	{
+		char c = *p;
+		if ( c == '\n' )
+		{
+			state = Plain;
+			term = 0;
+		}
+		else if ( state == Plain )
+		{
+			if ( c == '_' && p + 1 < end && p[1] == ':' )
+			{
+				const char *q = labelEnd( p + 2, end );
+				if ( term == 0 || term == 2 )
+				{
+					std::string label( p + 2, q - p - 2 );
+					if ( seen.insert( label ).second )
+						labels.push_back( label );
+				}
+				term++;
+				p = q - 1;
+			}
+			else if ( c == '<' )
+			{
+				// a datatype is part of its literal
+				if ( p - text < 2 || p[-1] != '^' || p[-2] != '^' )
+					term++;
+				state = InIRI;
+			}
+			else if ( c == '"' )
+			{
+				term++;
+				state = InLiteral;
+			}
+			else if ( c == '#' )
+				state = InComment;
+		}
+		else if ( state == InIRI )
+		{
+			if ( c == '>' ) state = Plain;
+		}
+		else if ( state == InLiteral )
+		{
+			if ( c == '\\' && p + 1 < end && p[1] != '\n' )
+				p++;
+			else if ( c == '"' )
+				state = Plain;
+		}
+	}
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+//	StatementBatch
+// -----------------------------------------------------------------------------
+
+StatementBatch::TermId
+StatementBatch::encode( const std::string & key )
+{
+	auto I = ids.find( key );
+	if ( I != ids.end() )
+		return I->second;
+
+	keys.push_back( key );
+	TermId id = keys.size();
+	ids.emplace( key, id );
+	return id;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+StatementBatch::clear()
+{
+	ids.clear();
+	keys.clear();
+	rows.clear();
+}
+
+// -----------------------------------------------------------------------------
+//	_ParallelLoader
+// -----------------------------------------------------------------------------
+
+_ParallelLoader::_ParallelLoader( World w, const std::string & name, const std::string & mime,
+		const std::string & _skolem )
+	: world(w), parserName(name), parserMime(mime), skolem(_skolem),
+	  data(nullptr), nextChunk(0), readyLimit(0), running(0), stopping(false)
+{
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+bool
+_ParallelLoader::lineBased( const std::string & name, const std::string & mime )
+{
+	if ( ! name.empty() )
+		return name == "ntriples" || name == "nquads";
+
+	return mime == "application/n-triples" || mime == "application/n-quads";
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ParallelLoader::split( size_t size, unsigned chunks )
+{
+	cuts.clear();
+	cuts.push_back( 0 );
+	for ( unsigned i = 1; i < chunks; i++ )
+	{
+		size_t at = size / chunks * i;
+		if ( at <= cuts.back() ) continue;
+
+		const char *nl = static_cast< const char * >( memchr( data + at, '\n', size - at ));
+		if ( ! nl ) break;
+		size_t cut = nl - data + 1;
+		if ( cut < size ) cuts.push_back( cut );
+	}
+	if ( size > 0 ) cuts.push_back( size );
+}
+
+// -----------------------------------------------------------------------------
+
+AddCounts
+_ParallelLoader::load( _Model & model, const std::string & file, const std::string & source_uri,
+		const std::string & base_uri, unsigned threads )
+{
+	librdf_world *w = DEREF( World, librdf_world, world );
+
+	if ( threads == 0 )
+		threads = std::max( 1u, std::thread::hardware_concurrency() );
+
+	path = file;
+	source = source_uri;
+	base = base_uri;
+
+	// a label from librdf makes the blank nodes of this load distinct
+	// from those of any other
+	unsigned char *genid = librdf_world_get_genid( w );
+	if ( ! genid )
+		throw VX(Error) << "Failed to generate a blank node id";
+	blankScheme = "rdfxx-blank:";
+	blankScheme += (const char *)genid;
+	blankScheme += '/';
+	blankKey = "B";
+	blankKey += (const char *)genid;
+	blankKey += '_';
+	librdf_free_memory( genid );
+
+	MappedFile input( file );
+	data = input.data();
+	size_t chunks = std::max< size_t >( threads * 4, input.size() / ChunkBytes + 1 );
+	chunks = std::min< size_t >( chunks, input.size() / MinChunkBytes + 1 );
+	split( input.size(), chunks );
+	threads = std::min< size_t >( threads, cuts.size() - 1 );
+	if ( ! skolem.empty() )
+		orderBlanks( threads );
+
+	nextChunk = 0;
+	ready.clear();
+	readyLimit = 2 * threads;
+	running = threads;
+	stopping = false;
+	failure = nullptr;
+	errors.clear();
+	warnings.clear();
+
+	AddCounts total = { 0, 0, 0, true };
+	std::vector< std::thread > workers;
+	try
+	{
+		for ( unsigned i = 0; i < threads; i++ )
+			workers.emplace_back( &_ParallelLoader::work, this );
+
+		StatementBatch batch;
+		while ( pop( batch ))
+		{
+			AddCounts c = model.addBatch( batch );
+			total.offered += c.offered;
+			total.inserted += c.inserted;
+			total.duplicates += c.duplicates;
+			total.ok = total.ok && c.ok;
+			if ( ! c.ok ) stop();
+		}
+	}
+	catch ( ... )
+	{
+		stop();
+		for ( auto & t : workers )
+			t.join();
+		throw;
+	}
+	for ( auto & t : workers )
+		t.join();
+
+	if ( failure )
+		std::rethrow_exception( failure );
+
+	// pass on the messages now that we are back in the thread of the world
+	_World *wld = static_cast< _World * >( world.get() );
+	for ( auto & msg : warnings )
+		wld->forWarnings.processMessage( msg );
+	if ( ! errors.empty() )
+		total.ok = false;
+	for ( auto & msg : errors )
+		wld->forErrors.processMessage( msg );
+
+	return total;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ParallelLoader::orderBlanks( unsigned threads )
+{
+	// each chunk is scanned for its labels in parallel
+	size_t chunks = cuts.size() - 1;
+	std::vector< std::vector< std::string > > found( chunks );
+	std::atomic< size_t > next( 0 );
+	auto scan = [this, &found, &next, chunks]()
+	{
+		size_t chunk;
+		while ( ( chunk = next++ ) < chunks )
+			scanBlanks( data + cuts[chunk], cuts[chunk + 1] - cuts[chunk], found[chunk] );
+	};
+	std::vector< std::thread > scanners;
+	for ( unsigned i = 1; i < threads; i++ )
+		scanners.emplace_back( scan );
+	scan();
+	for ( auto & t : scanners )
+		t.join();
+
+	// then numbered in file order
+	blankOrder.clear();
+	for ( auto & labels : found )
+		for ( auto & label : labels )
+			blankOrder.emplace( label, blankOrder.size() + 1 );
+}
+// -----------------------------------------------------------------------------
+
+void
+_ParallelLoader::work()
+{
+	Collector messages;
+	ErrorHandler forErrors( false );
+	ErrorHandler forWarnings( true );
+	forErrors.registerClient( &messages );
+	forWarnings.registerClient( &messages );
+
+	librdf_world *w = nullptr;
+	librdf_parser *parser = nullptr;
+	librdf_uri *base_uri = nullptr;
+	std::exception_ptr error;
+	try
+	{
+		w = librdf_new_world();
+		if ( ! w )
+			throw VX(Error) << "Failed to allocate the World";
+		librdf_world_set_warning( w, &forWarnings, _World::errorHandler );
+		librdf_world_set_error( w, &forErrors, _World::errorHandler );
+		librdf_world_open( w );
+
+		parser = librdf_new_parser( w,
+				parserName.empty() ? nullptr : parserName.c_str(),
+				parserMime.empty() ? nullptr : parserMime.c_str(), nullptr );
+		if ( ! parser )
+			throw VX(Error) << "Failed to allocate parser";
+
+		base_uri = librdf_new_uri( w, (const unsigned char *)base.c_str() );
+		if ( ! base_uri )
+			throw VX(Error) << "Failed to allocate base URI " << base;
+
+		StatementBatch batch;
+		std::string text, key;
+		size_t chunk;
+		while ( ! stopping && ( chunk = nextChunk++ ) < cuts.size() - 1 )
+		{
+			const char *start = data + cuts[chunk];
+			size_t len = cuts[chunk + 1] - cuts[chunk];
+			if ( rewriteBlanks( start, len, blankScheme, text ))
+			{
+				start = text.data();
+				len = text.size();
+			}
+
+			librdf_stream *strm = librdf_parser_parse_counted_string_as_stream( parser,
+					(const unsigned char *)start, len, base_uri );
+			if ( ! strm )
+			{
+				messages.handleError( "Failed to parse " + path + " from byte "
+					+ std::to_string( cuts[chunk] ));
+				break;
+			}
+
+			bool more = true;
+			try
+			{
+				while ( more && ! librdf_stream_end( strm ))
+				{
+					encode( batch, librdf_stream_get_object( strm ), key );
+					if ( batch.full() )
+						more = push( batch );
+					librdf_stream_next( strm );
+				}
+			}
+			catch ( ... )
+			{
+				librdf_free_stream( strm );
+				throw;
+			}
+			librdf_free_stream( strm );
+			if ( ! more || ! messages.errors.empty() ) break;
+		}
+		if ( batch.size() > 0 && messages.errors.empty() )
+			push( batch );
+	}
+	catch ( ... )
+	{
+		error = std::current_exception();
+	}
+
+	if ( base_uri ) librdf_free_uri( base_uri );
+	if ( parser ) librdf_free_parser( parser );
+	if ( w ) librdf_free_world( w );
+
+	finished( error, messages.errors, messages.warnings );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ParallelLoader::encode( StatementBatch & batch, librdf_statement *st, std::string & key )
+{
+	StatementBatch::TermId ids[3];
+	librdf_node *nodes[3] = {
+		librdf_statement_get_subject( st ),
+		librdf_statement_get_predicate( st ),
+		librdf_statement_get_object( st ) };
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		_ColumnarStore::termKey( nodes[i], key );
+		// turn the stand in IRIs back into blank nodes
+		if ( key[0] == 'R' && key.compare( 1, blankScheme.size(), blankScheme ) == 0 )
+		{
+			if ( skolem.empty() )
+				key.replace( 0, 1 + blankScheme.size(), blankKey );
+			else
+			{
+				// numbered before the workers started
+				auto I = blankOrder.find( key.substr( 1 + blankScheme.size() ));
+				if ( I == blankOrder.end() )
+					throw VX(Error) << "Blank node " << key.substr( 1 + blankScheme.size() )
+						<< " was not found in " << path;
+				key.resize( 1 );
+				_Skolemiser::ordinalIRI( skolem, source, I->second, key );
+			}
+		}
+		ids[i] = batch.encode( key );
+	}
+	batch.add( ids[0], ids[1], ids[2] );
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_ParallelLoader::push( StatementBatch & batch )
+{
+	std::unique_lock< std::mutex > guard( lock );
+	notFull.wait( guard, [this]{ return stopping || ready.size() < readyLimit; } );
+	if ( stopping ) return false;
+
+	ready.push_back( std::move( batch ));
+	batch.clear();
+	notEmpty.notify_one();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_ParallelLoader::pop( StatementBatch & batch )
+{
+	std::unique_lock< std::mutex > guard( lock );
+	notEmpty.wait( guard, [this]{ return stopping || ! ready.empty() || running == 0; } );
+	if ( stopping || ready.empty() ) return false;
+
+	batch = std::move( ready.front() );
+	ready.pop_front();
+	notFull.notify_one();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ParallelLoader::finished( std::exception_ptr error, const std::vector< std::string > & errs,
+		const std::vector< std::string > & warns )
+{
+	std::lock_guard< std::mutex > guard( lock );
+	running--;
+	errors.insert( errors.end(), errs.begin(), errs.end() );
+	warnings.insert( warnings.end(), warns.begin(), warns.end() );
+	if ( error && ! failure )
+		failure = error;
+	if ( error || ! errs.empty() )
+	{
+		// there is no point parsing the rest
+		stopping = true;
+		notFull.notify_all();
+	}
+	notEmpty.notify_all();
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_ParallelLoader::stop()
+{
+	std::lock_guard< std::mutex > guard( lock );
+	stopping = true;
+	notFull.notify_all();
+	notEmpty.notify_all();
+}
+
+// -----------------------------------------------------------------------------
+//	_PipelinedLoader
+// -----------------------------------------------------------------------------
+
+_PipelinedLoader::_PipelinedLoader( World w, const std::string & name, const std::string & mime,
+		const std::string & syntax, const std::string & _skolem )
+	: world(w), parserName(name), parserMime(mime), parserSyntax(syntax), skolem(_skolem),
+	  ring(PipelineSlots), done(false), stopping(false), stalled(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+
+IngestStats
+_PipelinedLoader::load( _Model & model, const std::string & uri, const std::string & base_uri )
+{
+	librdf_world *w = DEREF( World, librdf_world, world );
+	Clock::time_point start = Clock::now();
+
+	source = uri;
+	base = base_uri;
+
+	unsigned char *genid = librdf_world_get_genid( w );
+	if ( ! genid )
+		throw VX(Error) << "Failed to generate a blank node id";
+	blankKey = "B";
+	blankKey += (const char *)genid;
+	blankKey += '_';
+	librdf_free_memory( genid );
+
+	IngestStats stats = { { 0, 0, 0, true }, 0, 0, 0, 0 };
+	std::thread producer( &_PipelinedLoader::produce, this );
+	try
+	{
+		StatementBatch batch;
+		unsigned tries = 0;
+		while ( true )
+		{
+			// the producer sets done after its last push, so if it
+			// was set before an empty ring is seen there is no more
+			bool last = done.load( std::memory_order_acquire );
+			if ( ring.tryPop( batch ))
+			{
+				AddCounts c = model.addBatch( batch );
+				stats.batches++;
+				stats.counts.offered += c.offered;
+				stats.counts.inserted += c.inserted;
+				stats.counts.duplicates += c.duplicates;
+				if ( ! c.ok )
+				{
+					stats.counts.ok = false;
+					break;
+				}
+				tries = 0;
+				continue;
+			}
+
+			if ( last )
+				break;
+
+			Clock::time_point idle = Clock::now();
+			backOff( tries );
+			stats.inserterStalled += secondsSince( idle );
+		}
+	}
+	catch ( ... )
+	{
+		stopping = true;
+		producer.join();
+		throw;
+	}
+	stopping = true;
+	producer.join();
+
+	if ( failure )
+		std::rethrow_exception( failure );
+
+	stats.parserStalled = stalled;
+	stats.seconds = secondsSince( start );
+
+	// as parseIntoModel, record the namespaces seen
+	Prefixes & prefixes = world->prefixes();
+	for ( auto & ns : namespaces )
+	{
+		URI u( world, ns.uri );
+		if ( ns.named )
+			prefixes.insert( ns.prefix, u );
+		else
+			prefixes.anonymous( u );
+	}
+	model.updatePrefixes();
+
+	_World *wld = static_cast< _World * >( world.get() );
+	for ( auto & msg : warnings )
+		wld->forWarnings.processMessage( msg );
+	if ( ! errors.empty() )
+		stats.counts.ok = false;
+	for ( auto & msg : errors )
+		wld->forErrors.processMessage( msg );
+
+	return stats;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_PipelinedLoader::produce()
+{
+	Collector messages;
+	ErrorHandler forErrors( false );
+	ErrorHandler forWarnings( true );
+	forErrors.registerClient( &messages );
+	forWarnings.registerClient( &messages );
+
+	librdf_world *w = nullptr;
+	librdf_parser *parser = nullptr;
+	librdf_uri *syntax_uri = nullptr;
+	librdf_uri *source_uri = nullptr;
+	librdf_uri *base_uri = nullptr;
+	librdf_stream *strm = nullptr;
+	try
+	{
+		w = librdf_new_world();
+		if ( ! w )
+			throw VX(Error) << "Failed to allocate the World";
+		librdf_world_set_warning( w, &forWarnings, _World::errorHandler );
+		librdf_world_set_error( w, &forErrors, _World::errorHandler );
+		librdf_world_open( w );
+
+		if ( ! parserSyntax.empty() )
+		{
+			syntax_uri = librdf_new_uri( w, (const unsigned char *)parserSyntax.c_str() );
+			if ( ! syntax_uri )
+				throw VX(Error) << "Failed to allocate syntax URI " << parserSyntax;
+		}
+		parser = librdf_new_parser( w,
+				parserName.empty() ? nullptr : parserName.c_str(),
+				parserMime.empty() ? nullptr : parserMime.c_str(), syntax_uri );
+		if ( ! parser )
+			throw VX(Error) << "Failed to allocate parser";
+
+		source_uri = librdf_new_uri( w, (const unsigned char *)source.c_str() );
+		base_uri = librdf_new_uri( w, (const unsigned char *)base.c_str() );
+		if ( ! source_uri || ! base_uri )
+			throw VX(Error) << "Failed to allocate URI " << source;
+
+		strm = librdf_parser_parse_as_stream( parser, source_uri, base_uri );
+		if ( ! strm )
+			throw VX(Error) << "Failed to parse " << source;
+
+		StatementBatch batch;
+		std::string key;
+		_Skolemiser skolemiser( skolem, source );
+		bool more = true;
+		while ( more && ! stopping && ! librdf_stream_end( strm ))
+		{
+			encode( batch, librdf_stream_get_object( strm ), key,
+					skolem.empty() ? nullptr : &skolemiser );
+			if ( batch.size() >= PipelineBatch )
+				more = push( batch );
+			librdf_stream_next( strm );
+		}
+		if ( more && batch.size() > 0 )
+			push( batch );
+
+		int n = librdf_parser_get_namespaces_seen_count( parser );
+		for ( int i = 0; i < n; i++ )
+		{
+			const char *prfx = librdf_parser_get_namespaces_seen_prefix( parser, i );
+			librdf_uri *u = librdf_parser_get_namespaces_seen_uri( parser, i );
+			if ( ! u ) continue;
+			Namespace ns;
+			ns.named = ( prfx != nullptr );
+			if ( prfx ) ns.prefix = prfx;
+			ns.uri = (const char *)librdf_uri_as_string( u );
+			namespaces.push_back( ns );
+		}
+	}
+	catch ( ... )
+	{
+		failure = std::current_exception();
+	}
+
+	if ( strm ) librdf_free_stream( strm );
+	if ( base_uri ) librdf_free_uri( base_uri );
+	if ( source_uri ) librdf_free_uri( source_uri );
+	if ( parser ) librdf_free_parser( parser );
+	if ( syntax_uri ) librdf_free_uri( syntax_uri );
+	if ( w ) librdf_free_world( w );
+
+	errors = messages.errors;
+	warnings = messages.warnings;
+	done.store( true, std::memory_order_release );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_PipelinedLoader::encode( StatementBatch & batch, librdf_statement *st, std::string & key,
+		_Skolemiser *skolemiser )
+{
+	StatementBatch::TermId ids[3];
+	librdf_node *nodes[3] = {
+		librdf_statement_get_subject( st ),
+		librdf_statement_get_predicate( st ),
+		librdf_statement_get_object( st ) };
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		_ColumnarStore::termKey( nodes[i], key );
+		if ( key[0] == 'B' )
+		{
+			if ( skolemiser )
+			{
+				const std::string & iri = skolemiser->iri( key.data() + 1, key.size() - 1 );
+				key.resize( 1 );
+				key[0] = 'R';
+				key += iri;
+			}
+			else
+				key.replace( 0, 1, blankKey );
+		}
+		ids[i] = batch.encode( key );
+	}
+	batch.add( ids[0], ids[1], ids[2] );
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_PipelinedLoader::push( StatementBatch & batch )
+{
+	unsigned tries = 0;
+	Clock::time_point start;
+	while ( ! ring.tryPush( batch ))
+	{
+		if ( stopping ) return false;
+		if ( tries == 0 ) start = Clock::now();
+		backOff( tries );
+	}
+	if ( tries > 0 )
+		stalled += secondsSince( start );
+
+	// we have the consumer's last batch back
+	batch.clear();
+	return true;
+}
+
+// ---- end ----
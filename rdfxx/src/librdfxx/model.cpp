@@ -31,10 +31,263 @@
 #include <rdfxx/model.hpp>
 #include <rdfxx/query.hpp>
 #include <rdfxx/query_results.hpp>
+#include <rdfxx/columnar.hpp>
+#include <rdfxx/loader.hpp>
+#include <rdfxx/parser.hpp>
+
+#include <exception>
 
 using namespace rdf;
 using namespace std;
 
+// -----------------------------------------------------------------------------
+//	Bulk loading adaptors
+// -----------------------------------------------------------------------------
+//
+// Each source of statements is presented to librdf as a librdf_stream so that
+// a whole batch goes through librdf_model_add_statements. The contexts live on
+// the stack of the calling addAll, so the finished method has nothing to free.
+// Exceptions must not propagate through librdf, so they are held in the
+// context and rethrown once librdf has returned.
+//
+
+namespace
+{
+
+void
+finishedNothing( void * )
+{
+}
+
+// an incomplete statement ends the batch with an error, as it does for a
+// vector of triples
+void
+incomplete( std::exception_ptr & error )
+{
+	try
+	{
+		throw VX(Error) << "Incomplete statement in batch";
+	}
+	catch ( ... )
+	{
+		error = std::current_exception();
+	}
+}
+
+// ---- an existing librdf stream, counting the statements taken from it ------
+
+struct CountingContext
+{
+	librdf_stream *stream;	// not owned
+	long count;
+	std::exception_ptr error;
+};
+
+int
+countingEnd( void *ctx )
+{
+	CountingContext *c = static_cast< CountingContext * >( ctx );
+	if ( c->error || librdf_stream_end( c->stream ))
+		return 1;
+	librdf_statement *st = librdf_stream_get_object( c->stream );
+	if ( ! st || ! librdf_statement_is_complete( st ))
+	{
+		incomplete( c->error );
+		return 1;
+	}
+	return 0;
+}
+
+int
+countingNext( void *ctx )
+{
+	CountingContext *c = static_cast< CountingContext * >( ctx );
+	c->count++;
+	return librdf_stream_next( c->stream );
+}
+
+void *
+countingGet( void *ctx, int flags )
+{
+	CountingContext *c = static_cast< CountingContext * >( ctx );
+	if ( flags == LIBRDF_STREAM_GET_METHOD_GET_OBJECT )
+		return librdf_stream_get_object( c->stream );
+	return nullptr;
+}
+
+// ---- a vector of node triples, using one reusable librdf statement ---------
+
+struct TripleContext
+{
+	const std::vector< Triple > *triples;
+	size_t index;
+	librdf_statement *statement;	// owned by addAll
+};
+
+void
+loadTriple( TripleContext *c )
+{
+	if ( c->index >= c->triples->size() ) return;
+	const Triple &t = (*c->triples)[c->index];
+	librdf_statement_clear( c->statement );
+	librdf_statement_set_subject( c->statement,
+		librdf_new_node_from_node( _NodeBase::derefNode( t.subject )));
+	librdf_statement_set_predicate( c->statement,
+		librdf_new_node_from_node( _NodeBase::derefNode( t.predicate )));
+	librdf_statement_set_object( c->statement,
+		librdf_new_node_from_node( _NodeBase::derefNode( t.object )));
+}
+
+int
+tripleEnd( void *ctx )
+{
+	TripleContext *c = static_cast< TripleContext * >( ctx );
+	return ( c->index >= c->triples->size() ) ? 1 : 0;
+}
+
+int
+tripleNext( void *ctx )
+{
+	TripleContext *c = static_cast< TripleContext * >( ctx );
+	c->index++;
+	loadTriple( c );
+	return tripleEnd( ctx );
+}
+
+void *
+tripleGet( void *ctx, int flags )
+{
+	TripleContext *c = static_cast< TripleContext * >( ctx );
+	if ( flags == LIBRDF_STREAM_GET_METHOD_GET_OBJECT )
+		return c->statement;
+	return nullptr;
+}
+
+// ---- a statement batch, its terms decoded once into this world -------------
+
+struct BatchContext
+{
+	const std::vector< _ColumnarStore::Key > *rows;
+	const std::vector< librdf_node * > *nodes;	// indexed by term id - 1
+	size_t index;
+	librdf_statement *statement;	// owned by addBatch
+};
+
+void
+loadRow( BatchContext *c )
+{
+	if ( c->index >= c->rows->size() ) return;
+	const _ColumnarStore::Key &k = (*c->rows)[c->index];
+	const std::vector< librdf_node * > &n = *c->nodes;
+	librdf_statement_clear( c->statement );
+	librdf_statement_set_subject( c->statement, librdf_new_node_from_node( n[k.a - 1] ));
+	librdf_statement_set_predicate( c->statement, librdf_new_node_from_node( n[k.b - 1] ));
+	librdf_statement_set_object( c->statement, librdf_new_node_from_node( n[k.c - 1] ));
+}
+
+int
+batchEnd( void *ctx )
+{
+	BatchContext *c = static_cast< BatchContext * >( ctx );
+	return ( c->index >= c->rows->size() ) ? 1 : 0;
+}
+
+int
+batchNext( void *ctx )
+{
+	BatchContext *c = static_cast< BatchContext * >( ctx );
+	c->index++;
+	loadRow( c );
+	return batchEnd( ctx );
+}
+
+void *
+batchGet( void *ctx, int flags )
+{
+	BatchContext *c = static_cast< BatchContext * >( ctx );
+	if ( flags == LIBRDF_STREAM_GET_METHOD_GET_OBJECT )
+		return c->statement;
+	return nullptr;
+}
+
+// ---- a function returning statements until it returns a null one ----------
+
+struct SourceContext
+{
+	StatementSource *source;
+	Statement current;
+	long count;
+	std::exception_ptr error;
+};
+
+void
+pullStatement( SourceContext *c )
+{
+	try
+	{
+		c->current = (*c->source)();
+		if ( c->current && ! librdf_statement_is_complete(
+					DEREF( Statement, librdf_statement, c->current )))
+		{
+			incomplete( c->error );
+			c->current.reset();
+		}
+		if ( c->current ) c->count++;
+	}
+	catch ( ... )
+	{
+		c->error = std::current_exception();
+		c->current.reset();
+	}
+}
+
+int
+sourceEnd( void *ctx )
+{
+	return static_cast< SourceContext * >( ctx )->current ? 0 : 1;
+}
+
+int
+sourceNext( void *ctx )
+{
+	SourceContext *c = static_cast< SourceContext * >( ctx );
+	pullStatement( c );
+	return sourceEnd( ctx );
+}
+
+void *
+sourceGet( void *ctx, int flags )
+{
+	SourceContext *c = static_cast< SourceContext * >( ctx );
+	if ( flags == LIBRDF_STREAM_GET_METHOD_GET_OBJECT && c->current )
+		return DEREF( Statement, librdf_statement, c->current );
+	return nullptr;
+}
+
+// ----------------------------------------------------------------------------
+
+AddCounts
+makeCounts( long offered, int before, int after, bool ok )
+{
+	AddCounts counts;
+	counts.offered = offered;
+	counts.ok = ok;
+	if ( before >= 0 && after >= 0 )
+	{
+		counts.inserted = after - before;
+		// after a failure we cannot tell which statements were duplicates
+		counts.duplicates = ok ? offered - counts.inserted : 0;
+	}
+	else
+	{
+		counts.inserted = offered;
+		counts.duplicates = 0;
+	}
+	return counts;
+}
+
+} // namespace
+
 // -----------------------------------------------------------------------------
 //	Model
 // -----------------------------------------------------------------------------
@@ -52,6 +305,17 @@ Model::Model( World w, const std::string & _storage_type, const std::string & _s
 {
 }
 
+// -----------------------------------------------------------------------------
+
+// static
+Model
+Model::openSnapshot( World w, const std::string & path )
+{
+	// check first, librdf cannot report why a storage failed to open
+	_ColumnarStore::checkSnapshot( path );
+	return Model( w, _ColumnarStore::StorageName, path );
+}
+
 // -----------------------------------------------------------------------------
 //	_Model
 // -----------------------------------------------------------------------------
@@ -116,6 +380,38 @@ _Model::sync()
 
 // -----------------------------------------------------------------------------
 
+void
+_Model::saveSnapshot( const std::string & path )
+{
+	savePrefixes();
+
+	_ColumnarStore store( DEREF( World, librdf_world, world ));
+	librdf_stream *strm = librdf_model_as_stream( model );
+	if ( ! strm )
+		throw VX(Error) << "Failed to get model stream";
+	try
+	{
+		while ( ! librdf_stream_end( strm ))
+		{
+			librdf_statement *st = librdf_stream_get_object( strm );
+			store.add( store.encode( librdf_statement_get_subject( st )),
+				   store.encode( librdf_statement_get_predicate( st )),
+				   store.encode( librdf_statement_get_object( st )));
+			librdf_stream_next( strm );
+		}
+	}
+	catch ( ... )
+	{
+		librdf_free_stream( strm );
+		throw;
+	}
+	librdf_free_stream( strm );
+
+	store.saveSnapshot( path );
+}
+
+// -----------------------------------------------------------------------------
+
 Stream
 _Model::toStream()
 {
@@ -148,6 +444,163 @@ _Model::add(Statement _statement)
 
 // -----------------------------------------------------------------------------
 
+bool
+_Model::addStatements( librdf_stream *strm, const std::exception_ptr *error )
+{
+	if ( ! strm )
+		throw VX(Error) << "Failed to allocate stream";
+
+	bool txn = ( librdf_model_transaction_start( model ) == 0 );
+	int status = librdf_model_add_statements( model, strm );
+	librdf_free_stream( strm );
+	if ( error && *error )
+		status = 1;
+
+	if ( txn )
+	{
+		if ( status == 0 )
+			status = librdf_model_transaction_commit( model );
+		else
+			librdf_model_transaction_rollback( model );
+	}
+
+	return (status == 0) ? true : false;
+}
+
+// -----------------------------------------------------------------------------
+
+AddCounts
+_Model::addAll( Stream _stream )
+{
+	librdf_world *w = DEREF( World, librdf_world, world );
+	CountingContext ctx = { DEREF( Stream, librdf_stream, _stream ), 0, nullptr };
+	if ( ! ctx.stream )
+		throw VX(Code) << "Stream has no librdf stream";
+
+	int before = size();
+	bool ok = addStatements( librdf_new_stream( w, &ctx,
+			countingEnd, countingNext, countingGet, finishedNothing ), &ctx.error );
+	if ( ctx.error )
+		std::rethrow_exception( ctx.error );
+	return makeCounts( ctx.count, before, size(), ok );
+}
+
+// -----------------------------------------------------------------------------
+
+AddCounts
+_Model::addAll( const std::vector< Triple > & triples )
+{
+	for ( auto & t : triples )
+	{
+		if ( ! t.subject || ! t.predicate || ! t.object )
+			throw VX(Error) << "Incomplete triple in batch";
+	}
+
+	librdf_world *w = DEREF( World, librdf_world, world );
+	TripleContext ctx = { &triples, 0, librdf_new_statement( w ) };
+	if ( ! ctx.statement )
+		throw VX(Error) << "Failed to allocate statement";
+	loadTriple( &ctx );
+
+	int before = size();
+	bool ok;
+	try
+	{
+		ok = addStatements( librdf_new_stream( w, &ctx,
+				tripleEnd, tripleNext, tripleGet, finishedNothing ));
+	}
+	catch ( ... )
+	{
+		librdf_free_statement( ctx.statement );
+		throw;
+	}
+	librdf_free_statement( ctx.statement );
+
+	// statements after a failure are never taken from the vector
+	return makeCounts( ok ? triples.size() : ctx.index, before, size(), ok );
+}
+
+// -----------------------------------------------------------------------------
+
+AddCounts
+_Model::addAll( StatementSource source )
+{
+	librdf_world *w = DEREF( World, librdf_world, world );
+	SourceContext ctx;
+	ctx.source = &source;
+	ctx.count = 0;
+	pullStatement( &ctx );
+
+	int before = size();
+	bool ok = addStatements( librdf_new_stream( w, &ctx,
+			sourceEnd, sourceNext, sourceGet, finishedNothing ), &ctx.error );
+	if ( ctx.error )
+		std::rethrow_exception( ctx.error );
+	return makeCounts( ctx.count, before, size(), ok );
+}
+
+// -----------------------------------------------------------------------------
+
+AddCounts
+_Model::addBatch( const StatementBatch & batch )
+{
+	librdf_world *w = DEREF( World, librdf_world, world );
+	std::vector< librdf_node * > nodes;
+	nodes.reserve( batch.terms().size() );
+	BatchContext ctx = { &batch.triples(), &nodes, 0, nullptr };
+
+	int before = 0;
+	bool ok = false;
+	try
+	{
+		for ( auto & key : batch.terms() )
+		{
+			librdf_node *n = _ColumnarStore::keyToNode( w, key.data(), key.size() );
+			if ( ! n )
+				throw VX(Error) << "Failed to make a node for " << key;
+			nodes.push_back( n );
+		}
+
+		ctx.statement = librdf_new_statement( w );
+		if ( ! ctx.statement )
+			throw VX(Error) << "Failed to allocate statement";
+		loadRow( &ctx );
+
+		before = size();
+		ok = addStatements( librdf_new_stream( w, &ctx,
+				batchEnd, batchNext, batchGet, finishedNothing ));
+	}
+	catch ( ... )
+	{
+		if ( ctx.statement ) librdf_free_statement( ctx.statement );
+		for ( auto n : nodes )
+			librdf_free_node( n );
+		throw;
+	}
+	librdf_free_statement( ctx.statement );
+	for ( auto n : nodes )
+		librdf_free_node( n );
+
+	return makeCounts( ok ? batch.size() : ctx.index, before, size(), ok );
+}
+
+// -----------------------------------------------------------------------------
+
+IngestStats
+_Model::ingest( Parser _parser, URI _uri, URI _base_uri )
+{
+	_Parser *p = static_cast< _Parser * >( _parser.get() );
+	if ( ! p || ! _uri )
+		throw VX(Code) << "Ingest needs a parser and a URI";
+
+	_PipelinedLoader loader( world, p->syntaxName(), p->syntaxMime(), p->syntaxURI(),
+			p->skolemPrefix() );
+	return loader.load( *this, _uri->toString(),
+			( _base_uri ? _base_uri : _uri )->toString() );
+}
+
+// -----------------------------------------------------------------------------
+
 bool
 _Model::remove(Statement _statement)
 {
@@ -191,6 +644,36 @@ _Model::contains(Statement _statement) const
 
 // -----------------------------------------------------------------------------
 
+StatementRange
+_Model::find( Node subject, Node predicate, Node object )
+{
+	librdf_world *w = DEREF( World, librdf_world, world );
+	librdf_statement *pattern = librdf_new_statement( w );
+	if ( ! pattern )
+		throw VX(Error) << "Failed to allocate statement";
+
+	// the pattern takes ownership of its nodes, so give it copies
+	if ( subject )
+		librdf_statement_set_subject( pattern,
+			librdf_new_node_from_node( _NodeBase::derefNode( subject )));
+	if ( predicate )
+		librdf_statement_set_predicate( pattern,
+			librdf_new_node_from_node( _NodeBase::derefNode( predicate )));
+	if ( object )
+		librdf_statement_set_object( pattern,
+			librdf_new_node_from_node( _NodeBase::derefNode( object )));
+
+	// the storage keeps its own copy of the pattern
+	librdf_stream *strm = librdf_model_find_statements( model, pattern );
+	librdf_free_statement( pattern );
+	if ( ! strm )
+		throw VX(Error) << "Failed to find statements";
+
+	return StatementRange( Stream( new _Stream( world, strm )));
+}
+
+// -----------------------------------------------------------------------------
+
 std::vector< Node >
 _Model::predicates( Node subject, Node object )
 {
@@ -285,6 +768,69 @@ _Model::arcsOut( Node subject )
 
 // -----------------------------------------------------------------------------
 
+NodeRange
+_Model::predicatesRange( Node subject, Node object )
+{
+	librdf_node *s = _NodeBase::derefNode( subject );
+	librdf_node *o = _NodeBase::derefNode( object );
+	librdf_iterator *iter = librdf_model_get_arcs( model, s, o );
+	if ( ! iter )
+		throw VX(Error) << "Failed to get predicates";
+	return NodeRange( new _NodeIterator( world, iter ));
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange
+_Model::objectsRange( Node subject, Node predicate )
+{
+	librdf_node *s = _NodeBase::derefNode( subject );
+	librdf_node *p = _NodeBase::derefNode( predicate );
+	librdf_iterator *iter = librdf_model_get_targets( model, s, p );
+	if ( ! iter )
+		throw VX(Error) << "Failed to get objects";
+	return NodeRange( new _NodeIterator( world, iter ));
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange
+_Model::subjectsRange( Node predicate, Node object )
+{
+	librdf_node *p = _NodeBase::derefNode( predicate );
+	librdf_node *o = _NodeBase::derefNode( object );
+	librdf_iterator *iter = librdf_model_get_sources( model, p, o );
+	if ( ! iter )
+		throw VX(Error) << "Failed to get subjects";
+	return NodeRange( new _NodeIterator( world, iter ));
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange
+_Model::arcsInRange( Node object )
+{
+	librdf_node *o = _NodeBase::derefNode( object );
+	librdf_iterator *iter = librdf_model_get_arcs_in( model, o );
+	if ( ! iter )
+		throw VX(Error) << "Failed to get arcs in";
+	return NodeRange( new _NodeIterator( world, iter ));
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange
+_Model::arcsOutRange( Node subject )
+{
+	librdf_node *s = _NodeBase::derefNode( subject );
+	librdf_iterator *iter = librdf_model_get_arcs_out( model, s );
+	if ( ! iter )
+		throw VX(Error) << "Failed to get arcs out";
+	return NodeRange( new _NodeIterator( world, iter ));
+}
+
+// -----------------------------------------------------------------------------
+
 void 
 _Model::nodeIteratorToVector( librdf_iterator *iter, std::vector< Node > & nodes )
 {
@@ -304,11 +850,11 @@ void
 _Model::savePrefixes()
 {
 	Prefixes &prefs = world->prefixes();
-	ResourceNode pred( world, URI( prefs.uriForm("rdfxx:hasPrefix")));
+	ResourceNode pred = world->intern( prefs.uriForm("rdfxx:hasPrefix")->toString() );
 
 	for ( auto & I : world->prefixes() )
 	{
-		ResourceNode subj( world, I.second );
+		ResourceNode subj = world->intern( I.second->toString() );
 		LiteralNode  obj( world, Literal(I.first));
 		Statement st( world, subj, pred, obj );
 		if ( ! contains( st ))
@@ -327,8 +873,9 @@ _Model::updatePrefixes()
 	qs.setVariables("DISTINCT ?uri ?prefix");
 	qs.addCondition("?uri rdfxx:hasPrefix ?prefix");
 
-	_Query q( world, qs );
-	QueryResults qr( q.execute( model ));
+	// run after every parse, so keep it prepared
+	Query q = world->preparedQuery( qs );
+	QueryResults qr( static_cast< _Query * >( q.get() )->execute( model ));
 
 	Format format = {false, false, "_", false, false, "en", false };
 	for( auto &P : *qr )
@@ -26,6 +26,11 @@
  */
 
 
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <strings.h>
 #include <rdfxx/except.h>
 #include <rdfxx/node.hpp>
 
@@ -37,65 +42,32 @@ using namespace std;
 // -----------------------------------------------------------------------------
 
 Literal::Literal()
-	: mDataType( DataType::UNDEF )
+	: mDataType( DataType::UNDEF ), mParsed( false )
 {}
 
 // -----------------------------------------------------------------------------
 
 Literal::Literal( const std::string &val )
 	: mLanguage("en"), mDataType( DataType::PlainLiteral ),
-	  mValue(val)
+	  mValue(val), mParsed( false )
 {}
 
 // -----------------------------------------------------------------------------
 
 Literal::Literal( const std::string &val, const std::string &lang )
 	: mLanguage(lang), mDataType( DataType::PlainLiteral ),
-	  mValue(val)
+	  mValue(val), mParsed( false )
 {}
 
 // -----------------------------------------------------------------------------
 
 Literal::Literal( const std::string &val, DataType dt, const std::string &lang )
 	: mLanguage(lang), mDataType( dt ),
-	  mValue(val)
+	  mValue(val), mParsed( false )
 {}
 
 // -----------------------------------------------------------------------------
 
-Literal::Literal( int x, DataType dt )
-	: mDataType(dt)
-{
-	mValue = std::to_string( x );
-}
-
-// -----------------------------------------------------------------------------
-
-Literal::Literal( double x, DataType dt )
-	: mDataType(dt)
-{
-	mValue = std::to_string(x);
-	string::size_type p = mValue.find('.');
-	if ( p != string::npos )
-	{
-		p = mValue.find_last_not_of("0");
-		if ( p != string::npos )
-		{
-			mValue = mValue.substr(0,p+1);
-		}
-	}
-}
-
-// -----------------------------------------------------------------------------
-
-Literal::Literal( bool x)
-	: mDataType(DataType::Boolean)
-{
-	mValue = (x ? "true" : "false");
-}
-
-// -----------------------------------------------------------------------------
-
 std::string
 Literal::toString() const
 {
@@ -125,229 +97,6 @@ Literal::toString( const Format &format ) const
 	return s;
 }
 
-// -----------------------------------------------------------------------------
-
-URI
-Literal::dataTypeURI( World w ) const
-{
-	if ( mDataType == DataType::UNDEF )
-		throw VX(Code) << "Literal not initialised";
-	string s = toXSD( mDataType );
-	string::size_type p = s.find(':');
-	URI s2(w, s.substr(0,p+1));
-	URI base_uri = w->prefixes().find( s.substr(0,p ));
-	return URI( s, s2, base_uri );
-}
-
-// -----------------------------------------------------------------------------
-
-int
-Literal::asInteger() const
-{
-	return std::stoi( mValue );
-}
-
-// -----------------------------------------------------------------------------
-
-double
-Literal::asDouble() const
-{
-	return std::stod( mValue );
-}
-
-// -----------------------------------------------------------------------------
-
-bool
-Literal::asBoolean() const
-{
-	return ( mValue == "true" );
-}
-
-// -----------------------------------------------------------------------------
-
-// static
-std::string
-Literal::toXSD( DataType dt )
-{
-	if ( xsd_types.empty()) initXSDtypes();
-	return xsd_types[ dt ];
-}
-
-// -----------------------------------------------------------------------------
-
-// static
-std::string
-Literal::toTypeName( DataType dt )
-{
-	if ( names.empty()) initXSDtypes();
-	return names[ dt ];
-}
-
-// -----------------------------------------------------------------------------
-
-// static
-DataType
-Literal::toDataType( const std::string & xsd_type )
-{
-	if ( xsd_types.empty()) initXSDtypes();
-	//
-	// converting string to datatype is probably something
-	// for the UI. Hence we can afford to use a slower reverse lookup
-	//
-	for ( auto &x : xsd_types )
-	{
-		if ( x.second == xsd_type ) return x.first;
-	}
-	return DataType::UNDEF;
-}
-
-// -----------------------------------------------------------------------------
-
-// static
-DataType
-Literal::asDataType( const std::string & type_name )
-{
-	if ( names.empty()) initXSDtypes();
-	//
-	// converting string to datatype is probably something
-	// for the UI. Hence we can afford to use a slower reverse lookup
-	//
-	for ( auto &x : names )
-	{
-		if ( x.second == type_name ) return x.first;
-	}
-	return DataType::UNDEF;
-}
-
-// -----------------------------------------------------------------------------
-
-// static
-std::vector< std::string >
-Literal::getDataTypeNames()
-{
-	if ( names.empty()) initXSDtypes();
-	vector< string > res;
-	for ( auto &x : names )
-	{
-		res.push_back( x.second );
-	}
-	return res;
-}
-
-// -----------------------------------------------------------------------------
-
-std::map< DataType, std::string > Literal::xsd_types;
-std::map< DataType, std::string > Literal::names;
-
-// static
-void
-Literal::initXSDtypes()
-{
-	xsd_types =
-	{
-        	{ DataType::PlainLiteral, "rdf:PlainLiteral" },
-        	{ DataType::XMLLiteral, "rdf:XMLLiteral" },
-        	{ DataType::XHTML, "rdf:HTML" },
-
-        	{ DataType::String, "xsd:string" },
-        	{ DataType::Boolean, "xsd:boolean" },
-        	{ DataType::Decimal, "xsd:decimal" },
-        	{ DataType::Integer, "xsd:integer" },
-
-        	{ DataType::Double, "xsd:double" },
-        	{ DataType::Float, "xsd:float" },
-
-        	{ DataType::Data, "xsd:date" },
-        	{ DataType::Time, "xsd:time" },
-        	{ DataType::DateTime, "xsd:dateTime" },
-        	{ DataType::DateTimeStamp, "xsd:dateTimeStamp" },
-
-        	{ DataType::Year, "xsd:gYear" },
-        	{ DataType::Month, "xsd:gMonth" },
-        	{ DataType::Day, "xsd:gDay" },
-        	{ DataType::YearMonth, "xsd:gYearMonth" },
-        	{ DataType::MonthDay, "xsd:gMonthDay" },
-        	{ DataType::Duration, "xsd:duration" },
-        	{ DataType::YearMonthDuration, "xsd:yearMonthDuration" },
-        	{ DataType::DayTimeDuration, "xsd:dayTimeDuration" },
-
-        	{ DataType::Byte, "xsd:byte" },
-        	{ DataType::Short, "xsd:short" },
-        	{ DataType::Int, "xsd:int" },
-        	{ DataType::Long, "xsd:long" },
-        	{ DataType::UnsignedByte, "xsd:unsignedByte" },
-        	{ DataType::UnsignedShort, "xsd:unsignedShort" },
-        	{ DataType::UnsignedLong, "xsd:unsignedLong" },
-        	{ DataType::PositiveInteger, "xsd:positiveInteger" },
-        	{ DataType::NonNegativeInteger, "xsd:nonNegativeInteger" },
-        	{ DataType::NegativeInteger, "xsd:negativeInteger" },
-        	{ DataType::NonPositiveInteger, "xsd:nonPositiveInteger" },
-
-        	{ DataType::HexBinary, "xsd:hexBinary" },
-        	{ DataType::Base64Binary, "xsd:base64Binary" },
-
-        	{ DataType::AnyURI, "xsd:anyURI" },
-        	{ DataType::Language, "xsd:language" },
-        	{ DataType::NormalizedString, "xsd:normalizedString" },
-        	{ DataType::Token, "xsd:token" },
-        	{ DataType::NMTOKEN, "xsd:NMTOKEN" },
-        	{ DataType::Name, "xsd:Name" },
-        	{ DataType::NCName, "xsd:NCName" }
-	};
-
-	names =
-	{
-        	{ DataType::PlainLiteral, "PlainLiteral" },
-        	{ DataType::XMLLiteral, "XMLLiteral" },
-        	{ DataType::XHTML, "HTML" },
-
-        	{ DataType::String, "string" },
-        	{ DataType::Boolean, "boolean" },
-        	{ DataType::Decimal, "decimal" },
-        	{ DataType::Integer, "integer" },
-
-        	{ DataType::Double, "double" },
-        	{ DataType::Float, "float" },
-
-        	{ DataType::Data, "date" },
-        	{ DataType::Time, "time" },
-        	{ DataType::DateTime, "date time" },
-        	{ DataType::DateTimeStamp, "date time stamp" },
-
-        	{ DataType::Year, "Year" },
-        	{ DataType::Month, "Month" },
-        	{ DataType::Day, "Day" },
-        	{ DataType::YearMonth, "Year Month" },
-        	{ DataType::MonthDay, "Month Day" },
-        	{ DataType::Duration, "duration" },
-        	{ DataType::YearMonthDuration, "year month duration" },
-        	{ DataType::DayTimeDuration, "day time duration" },
-
-        	{ DataType::Byte, "byte" },
-        	{ DataType::Short, "short" },
-        	{ DataType::Int, "int" },
-        	{ DataType::Long, "long" },
-        	{ DataType::UnsignedByte, "unsigned byte" },
-        	{ DataType::UnsignedShort, "unsigned short" },
-        	{ DataType::UnsignedLong, "unsigned long" },
-        	{ DataType::PositiveInteger, "positive integer" },
-        	{ DataType::NonNegativeInteger, "non-negative integer" },
-        	{ DataType::NegativeInteger, "negative integer" },
-        	{ DataType::NonPositiveInteger, "non-positive integer" },
-
-        	{ DataType::HexBinary, "hex binary" },
-        	{ DataType::Base64Binary, "base 64 binary" },
-
-        	{ DataType::AnyURI, "any URI" },
-        	{ DataType::Language, "language" },
-        	{ DataType::NormalizedString, "normalized string" },
-        	{ DataType::Token, "token" },
-        	{ DataType::NMTOKEN, "NMTOKEN" },
-        	{ DataType::Name, "Name" },
-        	{ DataType::NCName, "NCName" }
-	};
-}
-
 // -----------------------------------------------------------------------------
 //	Node
 // -----------------------------------------------------------------------------
@@ -445,23 +194,402 @@ BlankNode::BlankNode( Node n )
 // -----------------------------------------------------------------------------
 
 // static
-librdf_node *
-_NodeBase::derefNode( Node a )
+_NodeBase *
+_NodeBase::base( const Node & a )
 {
-	librdf_node *t = nullptr;
-	_NodeBase *c = nullptr;
+	if ( ! a )
+		return nullptr;
 	if ( a->isResource() )
-		c = static_cast< _ResourceNode * >( a.get());
+		return static_cast< _ResourceNode * >( a.get());
 	else if ( a->isLiteral())
-		c = static_cast< _LiteralNode * >( a.get());
+		return static_cast< _LiteralNode * >( a.get());
 	else
-		c = static_cast< _BlankNode * >( a.get());
+		return static_cast< _BlankNode * >( a.get());
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+librdf_node *
+_NodeBase::derefNode( Node a )
+{
+	librdf_node *t = nullptr;
+	_NodeBase *c = base( a );
 	if ( c ) t = *c;
 	return t;
 }
 
 // -----------------------------------------------------------------------------
 
+// static
+void
+_NodeBase::rebind( Node a, librdf_node *n )
+{
+	_NodeBase *c = base( a );
+	if ( c->free )
+		throw VX(Code) << "Cannot rebind a node that owns its librdf_node";
+	c->node = n;
+	c->hashed = false;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+void
+_NodeBase::detach( Node a )
+{
+	_NodeBase *c = base( a );
+	if ( ! c || c->free || ! c->node )
+		return;
+	librdf_node *n = librdf_new_node_from_node( c->node );
+	if ( ! n )
+		throw VX(Error) << "Failed to copy node";
+	c->node = n;
+	c->free = true;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+librdf_node *
+_NodeBase::release( Node &&a )
+{
+	_NodeBase *c = base( a );
+	if ( ! c )
+		return nullptr;
+
+	librdf_node *n = nullptr;
+	if ( c->free && a.use_count() == 1 )
+	{
+		n = c->node;
+		c->node = nullptr;
+		c->free = false;
+	}
+	else
+	{
+		n = librdf_new_node_from_node( c->node );
+		if ( ! n )
+			throw VX(Error) << "Failed to allocate node";
+	}
+	a.reset();
+	return n;
+}
+
+// -----------------------------------------------------------------------------
+
+size_t
+_NodeBase::hash() const
+{
+	if ( ! hashed )
+	{
+		hashValue = hash( node );
+		hashed = true;
+	}
+	return hashValue;
+}
+
+// -----------------------------------------------------------------------------
+
+namespace
+{
+
+// resources sort before blank nodes, and blank nodes before literals
+int kindOf( librdf_node *n )
+{
+	if ( librdf_node_is_resource( n )) return 0;
+	if ( librdf_node_is_blank( n )) return 1;
+	return 2;
+}
+
+int compareBytes( const unsigned char *a, size_t alen, const unsigned char *b, size_t blen )
+{
+	int c = memcmp( a, b, std::min( alen, blen ));
+	if ( c != 0 ) return c;
+	return ( alen < blen ) ? -1 : ( alen > blen ? 1 : 0 );
+}
+
+// language tags are ordered without regard to case, then by case, so that
+// tags differing only in case are neighbours
+int compareLanguage( const char *a, const char *b )
+{
+	if ( a == nullptr || b == nullptr )
+		return ( a ? 1 : 0 ) - ( b ? 1 : 0 );
+	int c = strcasecmp( a, b );
+	return ( c != 0 ) ? c : strcmp( a, b );
+}
+
+// a missing datatype sorts first
+int compareDatatype( librdf_uri *a, librdf_uri *b )
+{
+	if ( a == nullptr || b == nullptr )
+		return ( a ? 1 : 0 ) - ( b ? 1 : 0 );
+	return _URI::compare( a, b );
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+// static
+size_t
+_NodeBase::hash( librdf_node *n )
+{
+	if ( ! n ) return 0;
+
+	unsigned char kind = kindOf( n );
+	size_t h = hashBytes( &kind, 1 );
+	size_t len = 0;
+	const unsigned char *s = nullptr;
+	switch ( kind )
+	{
+	case 0:
+		s = librdf_uri_as_counted_string( librdf_node_get_uri( n ), &len );
+		return hashBytes( s, len, h );
+	case 1:
+		s = librdf_node_get_counted_blank_identifier( n, &len );
+		return hashBytes( s, len, h );
+	default:
+		break;
+	}
+
+	s = librdf_node_get_literal_value_as_counted_string( n, &len );
+	h = hashBytes( s, len, h );
+
+	// folded, so the hash holds whether or not librdf ignores case in tags
+	const char *lang = librdf_node_get_literal_value_language( n );
+	if ( lang )
+	{
+		h = hashBytes( "@", 1, h );
+		for ( ; *lang; lang++ )
+		{
+			char c = tolower( static_cast< unsigned char >( *lang ));
+			h = hashBytes( &c, 1, h );
+		}
+	}
+
+	librdf_uri *dt = librdf_node_get_literal_value_datatype_uri( n );
+	if ( dt )
+	{
+		s = librdf_uri_as_counted_string( dt, &len );
+		h = hashBytes( "^", 1, h );
+		h = hashBytes( s, len, h );
+	}
+	return h;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+int
+_NodeBase::compare( librdf_node *a, librdf_node *b )
+{
+	if ( a == b ) return 0;
+	if ( a == nullptr || b == nullptr )
+		return ( a ? 1 : 0 ) - ( b ? 1 : 0 );
+
+	int kind = kindOf( a );
+	int c = kind - kindOf( b );
+	if ( c != 0 ) return c;
+
+	size_t alen = 0, blen = 0;
+	const unsigned char *as, *bs;
+	switch ( kind )
+	{
+	case 0:
+		return _URI::compare( librdf_node_get_uri( a ), librdf_node_get_uri( b ));
+	case 1:
+		as = librdf_node_get_counted_blank_identifier( a, &alen );
+		bs = librdf_node_get_counted_blank_identifier( b, &blen );
+		return compareBytes( as, alen, bs, blen );
+	default:
+		break;
+	}
+
+	as = librdf_node_get_literal_value_as_counted_string( a, &alen );
+	bs = librdf_node_get_literal_value_as_counted_string( b, &blen );
+	c = compareBytes( as, alen, bs, blen );
+	if ( c != 0 ) return c;
+
+	c = compareLanguage( librdf_node_get_literal_value_language( a ),
+				librdf_node_get_literal_value_language( b ));
+	if ( c != 0 ) return c;
+
+	return compareDatatype( librdf_node_get_literal_value_datatype_uri( a ),
+				librdf_node_get_literal_value_datatype_uri( b ));
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+TermView
+_NodeBase::view( librdf_node *n )
+{
+	if ( ! n )
+		return TermView();
+	if ( librdf_node_is_resource( n ))
+		return TermView( TermKind::Resource, n );
+	if ( librdf_node_is_blank( n ))
+		return TermView( TermKind::Blank, n );
+	return TermView( TermKind::Literal, n );
+}
+
+// -----------------------------------------------------------------------------
+//	StringRef
+// -----------------------------------------------------------------------------
+
+std::ostream &
+rdf::operator << ( std::ostream &os, StringRef s )
+{
+	return os.write( s.data(), s.size() );
+}
+
+// -----------------------------------------------------------------------------
+//	TermView
+// -----------------------------------------------------------------------------
+
+StringRef
+TermView::value() const
+{
+	librdf_node *n = static_cast< librdf_node * >( term );
+	size_t len = 0;
+	const unsigned char *str = nullptr;
+	switch ( mKind )
+	{
+	case TermKind::Resource:
+		str = librdf_uri_as_counted_string( librdf_node_get_uri( n ), &len );
+		break;
+	case TermKind::Blank:
+		str = librdf_node_get_counted_blank_identifier( n, &len );
+		break;
+	case TermKind::Literal:
+		str = librdf_node_get_literal_value_as_counted_string( n, &len );
+		break;
+	default:
+		return StringRef();
+	}
+	return StringRef( reinterpret_cast< const char * >( str ), len );
+}
+
+// -----------------------------------------------------------------------------
+
+StringRef
+TermView::iri() const
+{
+	return isResource() ? value() : StringRef();
+}
+
+// -----------------------------------------------------------------------------
+
+StringRef
+TermView::language() const
+{
+	if ( ! isLiteral() )
+		return StringRef();
+	return StringRef( librdf_node_get_literal_value_language(
+				static_cast< librdf_node * >( term )));
+}
+
+// -----------------------------------------------------------------------------
+
+StringRef
+TermView::datatype() const
+{
+	if ( ! isLiteral() )
+		return StringRef();
+	librdf_uri *dt = librdf_node_get_literal_value_datatype_uri(
+				static_cast< librdf_node * >( term ));
+	if ( ! dt )
+		return StringRef();
+	size_t len = 0;
+	const unsigned char *str = librdf_uri_as_counted_string( dt, &len );
+	return StringRef( reinterpret_cast< const char * >( str ), len );
+}
+
+// -----------------------------------------------------------------------------
+
+size_t
+TermView::hash() const
+{
+	return _NodeBase::hash( static_cast< librdf_node * >( term ));
+}
+
+// -----------------------------------------------------------------------------
+
+void
+TermView::appendTo( std::string &s ) const
+{
+	_NodeBase::appendTo( static_cast< librdf_node * >( term ), s );
+}
+
+// -----------------------------------------------------------------------------
+
+Node
+TermView::toNode( World world ) const
+{
+	if ( ! term )
+		return nullptr;
+	librdf_node *n = librdf_new_node_from_node( static_cast< librdf_node * >( term ));
+	if ( ! n )
+		throw VX(Error) << "Failed to allocate node";
+	return _NodeBase::make( world, n, true );
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+TermView::operator == ( const TermView &x ) const
+{
+	if ( term == x.term ) return true;
+	if ( ! term || ! x.term || mKind != x.mKind ) return false;
+	return librdf_node_equals( static_cast< librdf_node * >( term ),
+				static_cast< librdf_node * >( x.term )) != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+std::ostream &
+rdf::operator << ( std::ostream &os, const TermView &t )
+{
+	static thread_local string buffer;
+	buffer.clear();
+	t.appendTo( buffer );
+	return os.write( buffer.data(), buffer.size() );
+}
+
+// -----------------------------------------------------------------------------
+
+// Equal hashes are only trusted to rule out a match once both have been
+// computed; librdf has the last word on equality.
+bool
+rdf::operator == ( const Node &_a, const Node &_b )
+{
+	if ( _a.get() == _b.get() ) return true;
+	_NodeBase *a = _NodeBase::base( _a );
+	_NodeBase *b = _NodeBase::base( _b );
+	if ( ! a || ! b ) return false;
+	if ( a->hash() != b->hash() ) return false;
+	return librdf_node_equals( *a, *b ) != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+rdf::operator != ( const Node &a, const Node &b )
+{
+	return ! ( a == b );
+}
+
+// -----------------------------------------------------------------------------
+
+// null nodes sort first
+bool
+rdf::operator < ( const Node &a, const Node &b )
+{
+	return _NodeBase::compare( _NodeBase::derefNode( a ), _NodeBase::derefNode( b )) < 0;
+}
+
+// -----------------------------------------------------------------------------
+
 _NodeBase::operator librdf_node*() const
 {
     return node;
@@ -497,29 +625,208 @@ std::string
 _NodeBase::toString() const
 {
 	string s;
-	char *str = NULL;
-	size_t len = 2;
-	librdf_world *w = DEREF( World, librdf_world, world );
-	raptor_world * rw = librdf_world_get_raptor(w);
-	if ( rw )
+	appendTo( node, s );
+	return s;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_NodeBase::appendTo( std::string &s ) const
+{
+	appendTo( node, s );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_NodeBase::writeTo( std::ostream &os ) const
+{
+	// reused, so writing a node does not allocate once it has grown
+	static thread_local string buffer;
+	buffer.clear();
+	appendTo( node, buffer );
+	os.write( buffer.data(), buffer.size() );
+}
+
+// -----------------------------------------------------------------------------
+
+namespace
+{
+
+const char hexDigits[] = "0123456789ABCDEF";
+
+void appendCodePoint( string &s, unsigned long c )
+{
+	int digits = ( c < 0x10000 ) ? 4 : 8;
+	s += '\\';
+	s += ( digits == 4 ) ? 'u' : 'U';
+	for ( int shift = ( digits - 1 ) * 4; shift >= 0; shift -= 4 )
+		s += hexDigits[ ( c >> shift ) & 0xF ];
+}
+
+// Escape a string as raptor_string_ntriples_write does: backslash escapes
+// for the delimiter and the usual controls, and \u or \U for everything
+// outside printable ASCII. A byte that does not start a valid UTF-8
+// sequence is written as if it were a Latin-1 character.
+void appendEscaped( string &s, const unsigned char *p, size_t len, char delim )
+{
+	const unsigned char *end = p + len;
+	while ( p < end )
 	{
-		raptor_iostream *stream = raptor_new_iostream_to_string(rw, (void**)& str, &len, malloc );
-		librdf_node_write( node, stream );
-		raptor_free_iostream(stream);
+		unsigned char c = *p;
+		if ( c >= 0x20 && c < 0x7F )
+		{
+			if ( c == '\\' || c == static_cast< unsigned char >( delim ))
+				s += '\\';
+			s += static_cast< char >( c );
+			p++;
+			continue;
+		}
+		switch ( c )
+		{
+		case '\t': s += "\\t"; p++; continue;
+		case '\n': s += "\\n"; p++; continue;
+		case '\r': s += "\\r"; p++; continue;
+		case '\b': s += "\\b"; p++; continue;
+		case '\f': s += "\\f"; p++; continue;
+		default: break;
+		}
+		if ( c < 0x80 )
+		{
+			appendCodePoint( s, c );
+			p++;
+			continue;
+		}
+
+		size_t n = 0;
+		if ( c >= 0xC0 && c < 0xE0 ) n = 2;
+		else if ( c >= 0xE0 && c < 0xF0 ) n = 3;
+		else if ( c >= 0xF0 && c < 0xF8 ) n = 4;
+		unsigned long cp = c & ( 0x7F >> n );
+		bool valid = n != 0 && n <= static_cast< size_t >( end - p );
+		for ( size_t i = 1; valid && i < n; i++ )
+		{
+			valid = ( p[i] & 0xC0 ) == 0x80;
+			cp = ( cp << 6 ) | ( p[i] & 0x3F );
+		}
+		if ( valid )
+		{
+			appendCodePoint( s, cp );
+			p += n;
+		}
+		else
+		{
+			appendCodePoint( s, c );
+			p++;
+		}
+	}
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+// static
+void
+_NodeBase::appendTo( librdf_node *n, std::string &s )
+{
+	if ( ! n )
+	{
+		s += "(null)";
+		return;
+	}
+
+	size_t len = 0;
+	const unsigned char *str = nullptr;
+	if ( librdf_node_is_resource( n ))
+	{
+		str = librdf_uri_as_counted_string( librdf_node_get_uri( n ), &len );
+		s += '<';
+		appendEscaped( s, str, len, '>' );
+		s += '>';
+	}
+	else if ( librdf_node_is_blank( n ))
+	{
+		str = librdf_node_get_counted_blank_identifier( n, &len );
+		s += "_:";
+		s.append( reinterpret_cast< const char * >( str ), len );
 	}
 	else
 	{
-		cerr << "Failed to get raptor world" << endl;
+		str = librdf_node_get_literal_value_as_counted_string( n, &len );
+		s += '"';
+		appendEscaped( s, str, len, '"' );
+		s += '"';
+		const char *lang = librdf_node_get_literal_value_language( n );
+		if ( lang )
+		{
+			s += '@';
+			s += lang;
+		}
+		librdf_uri *dt = librdf_node_get_literal_value_datatype_uri( n );
+		if ( dt )
+		{
+			str = librdf_uri_as_counted_string( dt, &len );
+			s += "^^<";
+			appendEscaped( s, str, len, '>' );
+			s += '>';
+		}
 	}
-	if ( str ) s = str;
-	::free(str);
-    
-    // deprecated
-    // nstring = (const char*) librdf_node_to_string(node);
+}
+
+// -----------------------------------------------------------------------------
 
-    return s;
+std::ostream &
+rdf::operator << ( std::ostream &os, const Node &n )
+{
+	if ( n )
+		n->writeTo( os );
+	else
+		os << "(null)";
+	return os;
+}
+
+// -----------------------------------------------------------------------------
+
+std::ostream &
+rdf::operator << ( std::ostream &os, const ResourceNode &n )
+{
+	return os << Node( n );
+}
+
+// -----------------------------------------------------------------------------
+
+std::ostream &
+rdf::operator << ( std::ostream &os, const LiteralNode &n )
+{
+	return os << Node( n );
 }
 
+// -----------------------------------------------------------------------------
+
+std::ostream &
+rdf::operator << ( std::ostream &os, const BlankNode &n )
+{
+	return os << Node( n );
+}
+
+// -----------------------------------------------------------------------------
+
+#define NODE_EQUALITY( T ) \
+	bool rdf::operator == ( const T &a, const T &b ) { return Node( a ) == Node( b ); } \
+	bool rdf::operator == ( const T &a, const Node &b ) { return Node( a ) == b; } \
+	bool rdf::operator == ( const Node &a, const T &b ) { return a == Node( b ); } \
+	bool rdf::operator != ( const T &a, const T &b ) { return Node( a ) != Node( b ); } \
+	bool rdf::operator != ( const T &a, const Node &b ) { return Node( a ) != b; } \
+	bool rdf::operator != ( const Node &a, const T &b ) { return a != Node( b ); }
+
+NODE_EQUALITY( ResourceNode )
+NODE_EQUALITY( LiteralNode )
+NODE_EQUALITY( BlankNode )
+
+#undef NODE_EQUALITY
+
 // -----------------------------------------------------------------------------
 //	_ResourceNode
 // -----------------------------------------------------------------------------
@@ -577,22 +884,24 @@ _ResourceNode::toString(const Format &format) const
 	Prefixes &prefixes = world->prefixes();
 	if ( librdf_node_is_resource(node) )
 	{
-		URI uri = toURI();
+		size_t len;
+		const char *uri = (const char *)librdf_uri_as_counted_string(
+					librdf_node_get_uri( node ), &len );
 		if ( format.usePrefixes )
 		{
-			s = prefixes.prefixForm( uri );
+			prefixes.prefixForm( uri, len, s );
 		}
 		if ( s.empty())
 		{
 			if ( format.angleBrackets )
 			{
 				s += "<";
-				s += uri->toString();
+				s.append( uri, len );
 				s += ">";
 			}
 			else
 			{
-				s += uri->toString();
+				s.append( uri, len );
 			}
 
 		}
@@ -696,8 +1005,9 @@ _LiteralNode::toString(const Format & format) const
 		if ( dturi )
 		{
 			s += "^^";
-			URI uri( new _URI( dturi ));
-			s += world->prefixes().prefixForm( uri );
+			size_t len;
+			const char *uri = (const char *)librdf_uri_as_counted_string( dturi, &len );
+			world->prefixes().prefixForm( uri, len, s );
 		}
 	}
 	if ( s.empty() ) s = _NodeBase::toString();
@@ -733,9 +1043,9 @@ _LiteralNode::toLiteral() const
 	librdf_uri *dturi = librdf_node_get_literal_value_datatype_uri( node );
 	if ( dturi )
 	{
-		URI uri( new _URI( dturi ));
-		string s( world->prefixes().prefixForm( uri ));
-		L.dataType( Literal::toDataType( s ));
+		size_t len;
+		const char *uri = (const char *)librdf_uri_as_counted_string( dturi, &len );
+		L.dataType( Literal::fromURI( uri, len ));
 	}
 	else
 	{
@@ -792,6 +1102,66 @@ _BlankNode:: toURI() const
 }
 
 // -----------------------------------------------------------------------------
+//	_Skolemiser
+// -----------------------------------------------------------------------------
+
+namespace
+{
+
+// spread the last bytes hashed over the whole value
+uint64_t
+mix( uint64_t h )
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+appendHex( uint64_t v, std::string & out )
+{
+	static const char digits[] = "0123456789abcdef";
+	for ( int shift = 60; shift >= 0; shift -= 4 )
+		out += digits[ ( v >> shift ) & 0xf ];
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+const std::string &
+_Skolemiser::iri( const char *id, size_t len )
+{
+	auto res = seen.emplace( std::string( id, len ), std::string() );
+	if ( res.second )
+		ordinalIRI( prefix, source, seen.size(), res.first->second );
+	return res.first->second;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+void
+_Skolemiser::ordinalIRI( const std::string & prefix, const std::string & source,
+		size_t n, std::string & out )
+{
+	// two 64 bit hashes with different seeds make a 128 bit name, the
+	// nul after the source keeps it apart from the number
+	std::string ordinal = "#" + std::to_string( n );
+	uint64_t h1 = 0xcbf29ce484222325ull;
+	uint64_t h2 = 0x84222325cbf29ce4ull;
+	h1 = hashBytes( ordinal.data(), ordinal.size(), hashBytes( source.c_str(), source.size() + 1, h1 ));
+	h2 = hashBytes( ordinal.data(), ordinal.size(), hashBytes( source.c_str(), source.size() + 1, h2 ));
+
+	out += prefix;
+	appendHex( mix( h1 ), out );
+	appendHex( mix( h2 ), out );
+}
 
 // -----------------------------------------------------------------------------
 
@@ -0,0 +1,247 @@
+/* RDF C++ API 
+ *
+ * 			node_iterator.cpp
+ *
+ * 	Copyright 2017		Brenton Ross
+ *
+ * -----------------------------------------------------------------------------
+ * LICENSE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ * -----------------------------------------------------------------------------
+ */
+
+
+#include <rdfxx/except.h>
+#include <rdfxx/node_iterator.hpp>
+
+using namespace rdf;
+using namespace std;
+
+// -----------------------------------------------------------------------------
+//	_NodeIterator
+// -----------------------------------------------------------------------------
+
+_NodeIterator::_NodeIterator( World _w, librdf_iterator *_iter )
+	: world(_w), iter(_iter)
+{
+	if ( ! iter )
+		throw VX(Error) << "Parameter _iter is NULL pointer";
+}
+
+// -----------------------------------------------------------------------------
+
+_NodeIterator::~_NodeIterator()
+{
+	releaseViews();
+	if ( iter )
+		librdf_free_iterator( iter );
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_NodeIterator::end()
+{
+	int status = librdf_iterator_end( iter );
+
+	return (status != 0) ? true : false;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_NodeIterator::next()
+{
+	releaseViews();
+	int status = librdf_iterator_next( iter );
+
+	return (status == 0) ? true : false;
+}
+
+// -----------------------------------------------------------------------------
+
+Node
+_NodeIterator::current()
+{
+	librdf_node *x = (librdf_node*)librdf_iterator_get_object( iter );
+	if ( ! x )
+		throw VX(Error) << "Iterator has no current node";
+
+	return _NodeBase::make( world, librdf_new_node_from_node(x), true );
+}
+
+// -----------------------------------------------------------------------------
+
+Node
+_NodeIterator::view()
+{
+	librdf_node *x = (librdf_node*)librdf_iterator_get_object( iter );
+	if ( ! x )
+		throw VX(Error) << "Iterator has no current node";
+
+	int kind = librdf_node_is_resource(x) ? 0 : ( librdf_node_is_literal(x) ? 1 : 2 );
+	Node & v = views[kind];
+	if ( v )
+		_NodeBase::rebind( v, x );
+	else
+		v = _NodeBase::make( world, x, false );
+	return v;
+}
+
+// -----------------------------------------------------------------------------
+
+// A view that is still held outside takes its own copy of the node before
+// the iterator moves on, so that it neither changes nor dangles. A new view
+// is made for the next node.
+void
+_NodeIterator::releaseViews()
+{
+	for ( auto & v : views )
+	{
+		if ( v && v.use_count() > 1 )
+		{
+			_NodeBase::detach( v );
+			v.reset();
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+//	NodeRange
+// -----------------------------------------------------------------------------
+
+NodeRange::NodeRange( NodeIterator_ *_source )
+	: source( _source )
+{}
+
+// -----------------------------------------------------------------------------
+
+Node
+NodeRange::first()
+{
+	if ( source->end() )
+		return Node();
+	return source->current();
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+NodeRange::any()
+{
+	return ! source->end();
+}
+
+// -----------------------------------------------------------------------------
+
+long
+NodeRange::count()
+{
+	// no nodes are made, the iterator is just stepped to the end
+	long n = 0;
+	while ( ! source->end() )
+	{
+		n++;
+		source->next();
+	}
+	return n;
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange::iterator
+NodeRange::begin() const
+{
+	return iterator( source.get() );
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange::iterator
+NodeRange::end() const
+{
+	return iterator();
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange::iterator::iterator( NodeIterator_ *_source )
+	: source( _source )
+{
+	if ( source && source->end() )
+		source = nullptr;
+	if ( source )
+		node = source->view();
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange::iterator::iterator()
+	: source( nullptr )
+{}
+
+// -----------------------------------------------------------------------------
+
+const Node &
+NodeRange::iterator::operator *() const
+{
+	return node;
+}
+
+// -----------------------------------------------------------------------------
+
+Node_ *
+NodeRange::iterator::operator ->() const
+{
+	return node.get();
+}
+
+// -----------------------------------------------------------------------------
+
+NodeRange::iterator &
+NodeRange::iterator::operator ++ ()
+{
+	if ( source )
+	{
+		// let go of the view, so that only copies kept by the caller
+		// are detached
+		node.reset();
+		source->next();
+		if ( source->end() )
+			source = nullptr;
+		else
+			node = source->view();
+	}
+	return *this;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+NodeRange::iterator::operator == ( const iterator & other ) const
+{
+	return source == other.source;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+NodeRange::iterator::operator != ( const iterator & other ) const
+{
+	return source != other.source;
+}
+
+// ------------------------------- end -----------------------------------------
@@ -28,8 +28,10 @@
 
 #include <rdfxx/except.h>
 #include <rdfxx/parser.hpp>
+#include <rdfxx/node.hpp>
 #include <rdfxx/model.hpp>
 #include <rdfxx/world.hpp>
+#include <rdfxx/loader.hpp>
 
 using namespace rdf;
 using namespace std;
@@ -53,7 +55,7 @@ Parser::Parser( World w, const std::string & name, URI syntax_uri )
 // -----------------------------------------------------------------------------
 
 _Parser::_Parser( World _w, const std::string& _name, const std::string& _syntax_mime)
-	 : world(_w), parser(0)
+	 : world(_w), parser(0), name(_name), mime(_syntax_mime)
 {
     	librdf_world* world = DEREF( World, librdf_world, _w);
 
@@ -65,10 +67,12 @@ _Parser::_Parser( World _w, const std::string& _name, const std::string& _syntax
 // -----------------------------------------------------------------------------
 
 _Parser::_Parser( World _w, const std::string& _name, URI _syntax_uri)
-	 : world(_w), parser(0)
+	 : world(_w), parser(0), name(_name)
 {
     	librdf_world* world = DEREF( World, librdf_world, _w);
     librdf_uri *uri = DEREF( URI, librdf_uri, _syntax_uri );
+    if ( _syntax_uri )
+	syntax = _syntax_uri->toString();
 
     parser = librdf_new_parser(world, _name.c_str(), 0, uri);
     if(!parser)
@@ -83,7 +87,11 @@ _Parser::parseIntoModel( Model _model, URI _file, URI _base_uri)
 	_Model* m = static_cast< _Model * >( _model.get() );
 	_URI * u  = static_cast< _URI * >( _file.get());
 	_URI * bu = static_cast< _URI * >( _base_uri.get());
-	bool rc = (librdf_parser_parse_into_model(parser, *u, *bu, *m) == 0) ? true : false;
+	bool rc;
+	if ( skolem.empty() )
+		rc = (librdf_parser_parse_into_model(parser, *u, *bu, *m) == 0) ? true : false;
+	else
+		rc = skolemiseIntoModel( m, u, bu );
 
 	// 
 	// update the prefixes with those that were seen
@@ -113,6 +121,84 @@ _Parser::parseIntoModel( Model _model, URI _file, URI _base_uri)
 
 // -----------------------------------------------------------------------------
 
+bool
+_Parser::skolemiseIntoModel( _Model *m, _URI *u, _URI *bu )
+{
+	librdf_world *w = DEREF( World, librdf_world, world );
+	librdf_stream *strm = librdf_parser_parse_as_stream( parser, *u, *bu );
+	if ( ! strm )
+		return false;
+
+	_Skolemiser skolemiser( skolem, u->toString() );
+	bool rc = true;
+	while ( rc && ! librdf_stream_end( strm ))
+	{
+		librdf_statement *st = librdf_stream_get_object( strm );
+		librdf_node *nodes[3] = {
+			librdf_statement_get_subject( st ),
+			librdf_statement_get_predicate( st ),
+			librdf_statement_get_object( st ) };
+		for ( int i = 0; i < 3; i++ )
+		{
+			size_t len = 0;
+			unsigned char *id = librdf_node_is_blank( nodes[i] )
+				? librdf_node_get_counted_blank_identifier( nodes[i], &len )
+				: nullptr;
+			if ( id )
+				nodes[i] = librdf_new_node_from_uri_string( w,
+					(const unsigned char *)skolemiser.iri( (const char *)id, len ).c_str());
+			else
+				nodes[i] = librdf_new_node_from_node( nodes[i] );
+		}
+
+		// the statement takes the nodes
+		librdf_statement *added = librdf_new_statement_from_nodes( w, nodes[0], nodes[1], nodes[2] );
+		rc = added && librdf_model_add_statement( *m, added ) == 0;
+		if ( added )
+			librdf_free_statement( added );
+		librdf_stream_next( strm );
+	}
+	librdf_free_stream( strm );
+	return rc;
+}
+
+// -----------------------------------------------------------------------------
+
+AddCounts
+_Parser::parseIntoModelParallel( Model _model, URI _file, URI _base_uri, unsigned threads )
+{
+	_Model* m = static_cast< _Model * >( _model.get() );
+	if ( ! m || ! _file )
+		throw VX(Code) << "Parallel parse needs a model and a file";
+
+	if ( ! _ParallelLoader::lineBased( name, mime ))
+	{
+		// cannot be split, so parse it here
+		int before = m->size();
+		AddCounts counts;
+		counts.ok = parseIntoModel( _model, _file, _base_uri ? _base_uri : _file );
+		int after = m->size();
+		counts.inserted = ( before >= 0 && after >= 0 ) ? after - before : 0;
+		counts.offered = counts.inserted;
+		counts.duplicates = 0;
+		return counts;
+	}
+
+	if ( ! _file->isFileName() )
+		throw VX(Error) << "Parallel parse needs a file: URI, not " << _file->toString();
+
+	_ParallelLoader loader( world, name, mime, skolem );
+	AddCounts counts = loader.load( *m, _file->toFileName(), _file->toString(),
+			( _base_uri ? _base_uri : _file )->toString(), threads );
+
+	// line based syntaxes have no prefixes of their own
+	m->updatePrefixes();
+
+	return counts;
+}
+
+// -----------------------------------------------------------------------------
+
 _Parser::~_Parser()
 {
     if(parser)
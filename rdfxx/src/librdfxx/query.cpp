@@ -29,6 +29,11 @@
 #include <rdfxx/except.h>
 #include <rdfxx/query.hpp>
 #include <rdfxx/uri.hpp>
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <set>
 
 using namespace rdf;
 using namespace std;
@@ -52,19 +57,20 @@ Query::Query( World w, const std::string & query, URI base_uri, const std::strin
 // -----------------------------------------------------------------------------
 
 _Query::_Query(World _w, const string & _query_string, const std::string& _lang)
-	 : world(_w), query(0)
+	 : world(_w), query(0), text(_query_string), lang(_lang)
 {
     librdf_world* w = DEREF( World, librdf_world, _w );
     
     query = librdf_new_query(w, _lang.c_str(), 0, (unsigned char*) _query_string.c_str(), NULL);
     if(!query)
 	throw VX(Error) << "Failed to allocate query";
+    findParameters();
 }
 
 // -----------------------------------------------------------------------------
 
 _Query::_Query(World _w, const string & _query_string, URI _base_uri, const std::string& _lang)
-	 : world(_w), query(0)
+	 : world(_w), query(0), text(_query_string), lang(_lang), base(_base_uri)
 {
 	librdf_uri *bu = DEREF( URI, librdf_uri, _base_uri );
     librdf_world* w = DEREF( World, librdf_world, _w );
@@ -72,6 +78,7 @@ _Query::_Query(World _w, const string & _query_string, URI _base_uri, const std:
     query = librdf_new_query(w, _lang.c_str(), 0, (unsigned char*) _query_string.c_str(), bu );
     if(!query)
 	throw VX(Error) << "Failed to allocate query";
+    findParameters();
 }
 
 // -----------------------------------------------------------------------------
@@ -107,6 +114,9 @@ _Query::getLimit() const
 QueryResults
 _Query::execute( Model _model )
 {
+	if ( ! bound.empty() )
+		return execute( _model, bound );
+
 	if ( _model )
 	{
 		_Model *m = static_cast< _Model * >( _model.get());
@@ -138,6 +148,426 @@ _Query::execute( librdf_model* _model )
 }
 
 
+// -----------------------------------------------------------------------------
+//	parameters
+// -----------------------------------------------------------------------------
+
+namespace
+{
+
+bool
+nameChar( char c )
+{
+	return isalnum( (unsigned char)c ) || c == '_' || ( c & 0x80 );
+}
+
+//
+// Call found( at, len ) for each $name within the braces of the query,
+// skipping literals, IRIs and comments.
+//
+template < class F >
+void
+forEachParameter( const std::string & text, F found )
+{
+	const char *start = text.data();
+	const char *end = start + text.size();
+	const char *p = start;
+	int depth = 0;
+	while ( p < end )
+	{
+		char c = *p;
+		if ( c == '"' || c == '\'' )
+		{
+			// long literals end with three quotes
+			bool isLong = end - p >= 3 && p[1] == c && p[2] == c;
+			p += isLong ? 3 : 1;
+			while ( p < end )
+			{
+				if ( *p == '\\' && p + 1 < end )
+					p += 2;
+				else if ( *p != c )
+					p++;
+				else if ( ! isLong )
+				{
+					p++;
+					break;
+				}
+				else if ( end - p >= 3 && p[1] == c && p[2] == c )
+				{
+					p += 3;
+					break;
+				}
+				else
+					p++;
+			}
+		}
+		else if ( c == '#' )
+		{
+			while ( p < end && *p != '\n' ) p++;
+		}
+		else if ( c == '<' )
+		{
+			// an IRI has no spaces, otherwise it is a comparison
+			const char *q = p + 1;
+			while ( q < end && *q != '>' && *q != '<' && ! isspace( (unsigned char)*q )) q++;
+			p = ( q < end && *q == '>' ) ? q + 1 : p + 1;
+		}
+		else if ( c == '$' && depth > 0 )
+		{
+			const char *q = p + 1;
+			while ( q < end && nameChar( *q )) q++;
+			if ( q > p + 1 )
+				found( p - start, q - p );
+			p = q;
+		}
+		else
+		{
+			if ( c == '{' ) depth++;
+			if ( c == '}' ) depth--;
+			p++;
+		}
+	}
+}
+
+// a value must be a term that can be written in the query
+void
+checkValue( const std::string & name, const Node & value )
+{
+	if ( ! value )
+		throw VX(Code) << "No value for parameter $" << name;
+	if ( value->isBlank() )
+		throw VX(Code) << "Parameter $" << name << " cannot be a blank node";
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+void
+_Query::findParameters()
+{
+	forEachParameter( text, [this]( size_t at, size_t len )
+	{
+		std::string name( text, at + 1, len - 1 );
+		if ( std::find( params.begin(), params.end(), name ) == params.end() )
+			params.push_back( name );
+	} );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_Query::checkParameter( const std::string & name ) const
+{
+	if ( std::find( params.begin(), params.end(), name ) == params.end() )
+		throw VX(Code) << "The query has no parameter $" << name;
+}
+
+// -----------------------------------------------------------------------------
+
+// put the values in the pattern in place of their parameters, so that
+// they constrain the search
+void
+_Query::substitute( const Bindings & values, std::string & out ) const
+{
+	out.clear();
+	size_t from = 0;
+	forEachParameter( text, [&]( size_t at, size_t len )
+	{
+		auto I = values.find( std::string( text, at + 1, len - 1 ));
+		if ( I == values.end() )
+			return;
+		out.append( text, from, at - from );
+		I->second->appendTo( out );
+		from = at + len;
+	} );
+	out.append( text, from, std::string::npos );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_Query::appendValues( const std::vector< Bindings > & batch, std::string & out ) const
+{
+	std::vector< std::string > names;
+	for ( auto & values : batch )
+	{
+		for ( auto & v : values )
+		{
+			checkParameter( v.first );
+			checkValue( v.first, v.second );
+			if ( std::find( names.begin(), names.end(), v.first ) == names.end() )
+				names.push_back( v.first );
+		}
+	}
+
+	out += "\nVALUES (";
+	for ( auto & name : names )
+	{
+		out += " ?";
+		out += name;
+	}
+	out += " )\n{\n";
+	for ( auto & values : batch )
+	{
+		out += "(";
+		for ( auto & name : names )
+		{
+			out += ' ';
+			auto I = values.find( name );
+			if ( I == values.end() )
+				out += "UNDEF";
+			else
+				I->second->appendTo( out );
+		}
+		out += " )\n";
+	}
+	out += "}\n";
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_Query::bind( const std::string & name, Node value )
+{
+	checkParameter( name );
+	checkValue( name, value );
+	bound[ name ] = value;
+}
+
+// -----------------------------------------------------------------------------
+
+QueryResults
+_Query::execute( Model _model, const Bindings & values )
+{
+	if ( ! _model )
+		throw VX(Code) << "Model is null";
+	if ( values.empty() )
+	{
+		_Model *m = static_cast< _Model * >( _model.get());
+		return QueryResults( new _QueryResults(world, *this, *m ));
+	}
+
+	// the values go into the pattern, where they narrow the search, and
+	// into a VALUES row, so that a selected parameter still has its value
+	std::string bound_text;
+	substitute( values, bound_text );
+	appendValues( std::vector< Bindings >{ values }, bound_text );
+
+	// a few recent texts are kept here rather than in the world's cache,
+	// where a loop over many values would push out the prepared queries
+	auto I = boundQueries.begin();
+	while ( I != boundQueries.end() && I->first != bound_text )
+		++I;
+	if ( I != boundQueries.end() )
+		boundQueries.splice( boundQueries.begin(), boundQueries, I );
+	else
+	{
+		Query q = base ? Query( world, bound_text, base, lang )
+			       : Query( world, bound_text, lang );
+		boundQueries.emplace_front( bound_text, q );
+		if ( boundQueries.size() > BoundQueryCacheSize )
+			boundQueries.pop_back();
+	}
+	Query & q = boundQueries.front().second;
+	q->setLimit( getLimit() );
+	return q->execute( _model );
+}
+
+// -----------------------------------------------------------------------------
+
+QueryResults
+_Query::executeBatch( Model _model, const std::vector< Bindings > & batch )
+{
+	if ( ! _model )
+		throw VX(Code) << "Model is null";
+	if ( batch.empty() )
+		throw VX(Code) << "No values for the batch";
+
+	std::string batch_text( text );
+	appendValues( batch, batch_text );
+
+	// batches seldom repeat, so they are not cached
+	Query q = base ? Query( world, batch_text, base, lang )
+		       : Query( world, batch_text, lang );
+	return q->execute( _model );
+}
+
+// -----------------------------------------------------------------------------
+//	asynchronous queries
+// -----------------------------------------------------------------------------
+
+namespace
+{
+
+//
+// The threads that run asynchronous queries. A world must only be used by
+// one thread at a time, so a task waits while another for its world runs.
+//
+class QueryPool
+{
+private:
+	struct Task
+	{
+		World_ *world;
+		std::function< void () > run;
+	};
+
+	std::mutex lock;
+	std::condition_variable changed;
+	std::deque< Task > tasks;
+	std::set< World_ * > busy;
+	std::vector< std::thread > workers;
+	bool stopping;
+
+	void work();
+
+public:
+	QueryPool();
+	~QueryPool();
+
+	void submit( World_ *world, std::function< void () > run );
+
+	static QueryPool & instance();
+};
+
+// -----------------------------------------------------------------------------
+
+QueryPool::QueryPool()
+	: stopping( false )
+{
+	unsigned threads = std::max( 2u, std::thread::hardware_concurrency() );
+	for ( unsigned i = 0; i < threads; i++ )
+		workers.emplace_back( &QueryPool::work, this );
+}
+
+// -----------------------------------------------------------------------------
+
+QueryPool::~QueryPool()
+{
+	{
+		std::lock_guard< std::mutex > guard( lock );
+		stopping = true;
+
+		// the promises of tasks not started are broken
+		tasks.clear();
+	}
+	changed.notify_all();
+	for ( auto & w : workers )
+		w.join();
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+QueryPool &
+QueryPool::instance()
+{
+	static QueryPool pool;
+	return pool;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+QueryPool::submit( World_ *world, std::function< void () > run )
+{
+	{
+		std::lock_guard< std::mutex > guard( lock );
+		tasks.push_back( Task{ world, std::move( run ) } );
+	}
+	changed.notify_one();
+}
+
+// -----------------------------------------------------------------------------
+
+void
+QueryPool::work()
+{
+	std::unique_lock< std::mutex > guard( lock );
+	while ( true )
+	{
+		auto I = tasks.begin();
+		while ( I != tasks.end() && busy.count( I->world ))
+			++I;
+		if ( I == tasks.end() )
+		{
+			if ( stopping )
+				return;
+			changed.wait( guard );
+			continue;
+		}
+
+		Task task( std::move( *I ));
+		tasks.erase( I );
+		busy.insert( task.world );
+		guard.unlock();
+
+		task.run();
+		task.run = nullptr;
+
+		guard.lock();
+		busy.erase( task.world );
+
+		// a task for this world may be waiting
+		changed.notify_all();
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+void
+checkRunning( const CancelToken & token, Deadline deadline )
+{
+	if ( token.check() )
+		throw VX(Warning) << "The query was cancelled";
+	if ( deadline != Deadline::max() && std::chrono::steady_clock::now() >= deadline )
+		throw VX(Warning) << "The query passed its deadline";
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+std::future< ResultTable >
+_Query::executeAsync( Model _model, CancelToken token, Deadline deadline )
+{
+	if ( ! _model )
+		throw VX(Code) << "Model is null";
+
+	std::shared_ptr< _Query > self( shared_from_this() );
+	auto result = std::make_shared< std::promise< ResultTable > >();
+	std::future< ResultTable > future( result->get_future() );
+
+	QueryPool::instance().submit( world.get(), [self, _model, token, deadline, result]() mutable
+	{
+		// the query and model are let go before the future is ready, as
+		// the caller may then use the world again
+		try
+		{
+			auto check = [&token, deadline]() { checkRunning( token, deadline ); };
+			check();
+
+			ResultTable table;
+			{
+				// the results are freed as soon as the check throws
+				QueryResults qr = self->execute( _model );
+				table = static_cast< _QueryResults & >( *qr ).toTable( check );
+			}
+			self.reset();
+			_model.reset();
+			result->set_value( std::move( table ));
+		}
+		catch ( ... )
+		{
+			self.reset();
+			_model.reset();
+			result->set_exception( std::current_exception() );
+		}
+	});
+	return future;
+}
+
 // -----------------------------------------------------------------------------
 
 _Query::operator librdf_query*()
@@ -30,7 +30,11 @@
 #include <rdfxx/query_results.hpp>
 #include <rdfxx/node.hpp>
 #include <rdfxx/query.hpp>
+#include <rdfxx/stream.hpp>
 #include <rdfxx/rdfxx.h>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
 
 using namespace rdf;
 using namespace std;
@@ -171,6 +175,73 @@ _QueryResult::getBoundValue(const std::string & _name ) const
 }
 
 
+// -----------------------------------------------------------------------------
+
+_QueryResult::~_QueryResult()
+{
+	freeValues();
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_QueryResult::freeValues() const
+{
+	for ( librdf_node *n : values )
+		if ( n ) librdf_free_node( n );
+	values.clear();
+	fetched = false;
+}
+
+// -----------------------------------------------------------------------------
+
+// One call for the whole result; the vector keeps its capacity from one
+// result to the next.
+void
+_QueryResult::fetchValues() const
+{
+	if ( fetched ) return;
+	values.assign( count(), nullptr );
+	if ( ! values.empty() &&
+		librdf_query_results_get_bindings( query_results, NULL, values.data() ) != 0 )
+	{
+		values.clear();
+		throw VX(Error) << "Failed to get the bound values";
+	}
+	fetched = true;
+}
+
+// -----------------------------------------------------------------------------
+
+TermView
+_QueryResult::boundView( int _offset ) const
+{
+	if ( _offset < 0 || _offset >= count() )
+	{
+		throw VX(Error) << "Parameter out of range";
+	}
+	fetchValues();
+	return _NodeBase::view( values[_offset] );
+}
+
+// -----------------------------------------------------------------------------
+
+TermView
+_QueryResult::boundView( const std::string & _name ) const
+{
+	if ( _name.empty() )
+	{
+		throw VX(Error) << "No binding name supplied";
+	}
+	for ( int i = 0; i < count(); i++ )
+	{
+		const char *name = librdf_query_results_get_binding_name( query_results, i );
+		if ( name && _name == name )
+			return boundView( i );
+	}
+	return TermView();
+}
+
 // -----------------------------------------------------------------------------
 
 std::string
@@ -194,6 +265,7 @@ _QueryResult::getBoundName(int _offset) const
 void
 _QueryResult::reset()
 {
+	freeValues();
 	numberBound = -1;
     	int status = librdf_query_results_finished(query_results);
 	if ( status )
@@ -232,14 +304,15 @@ _QueryResult::toString() const
 // -----------------------------------------------------------------------------
 
 _QueryResults::_QueryResults(World w, _Query& _query, _Model& _model)
-	 : world(w), query_results(0)
+	 : world(w), query(_query.shared_from_this()), query_results(0)
 {
     query_results = librdf_query_execute(_query, _model);
     if(!query_results)
 	throw VX(Error) << "Failed to allocate query results";
 
+    // only bindings are read a result at a time
     int status = librdf_query_results_finished(query_results);
-    if ( status )
+    if ( status || ! librdf_query_results_is_bindings(query_results) )
     	currIter = QueryResult( new _QueryResult );
     else
     	currIter = QueryResult( new _QueryResult( world, query_results ));
@@ -248,14 +321,15 @@ _QueryResults::_QueryResults(World w, _Query& _query, _Model& _model)
 // -----------------------------------------------------------------------------
 
 _QueryResults::_QueryResults(World w, _Query& _query, librdf_model* _model)
-	 : world(w), query_results(0)
+	 : world(w), query(_query.shared_from_this()), query_results(0)
 {
     query_results = librdf_query_execute(_query, _model);
     if(!query_results)
 	throw VX(Error) << "Failed to allocate query results";
 
+    // only bindings are read a result at a time
     int status = librdf_query_results_finished(query_results);
-    if ( status )
+    if ( status || ! librdf_query_results_is_bindings(query_results) )
     	currIter = QueryResult( new _QueryResult );
     else
     	currIter = QueryResult( new _QueryResult( world, query_results ));
@@ -294,15 +368,17 @@ _QueryResults::toString(URI _syntax_uri, URI _base_uri)
 	librdf_uri* su = DEREF( URI, librdf_uri, _syntax_uri );
 	librdf_uri* bu = DEREF( URI, librdf_uri, _base_uri );
 
-    	const char*qr = (const char*) librdf_query_results_to_string2( query_results, 
+    	unsigned char *qr = librdf_query_results_to_string2( query_results, 
     				NULL, NULL, su, bu );
-	if ( qr )
-		return string(qr);
-	else
-		return string("query returned no results");
-	
+
 	// this function has consumed the results, so we cannot iterate over them
-    	currIter = QueryResult(nullptr);
+	currIter = QueryResult( new _QueryResult );
+
+	if ( ! qr )
+		return string("query returned no results");
+	string s( (const char *)qr );
+	librdf_free_memory( qr );
+	return s;
 }
 
 // -----------------------------------------------------------------------------
@@ -333,5 +409,561 @@ _QueryResults::success() const
     return (status != 0) ? false : true;
 }
 
+// -----------------------------------------------------------------------------
+
+ResultTable
+_QueryResults::toTable()
+{
+	return toTable( nullptr );
+}
+
+// -----------------------------------------------------------------------------
+
+ResultTable
+_QueryResults::toTable( const std::function< void () > & check )
+{
+	ResultTable table;
+	if ( ! query_results )
+		return table;
+	if ( ! librdf_query_results_is_bindings( query_results ))
+		throw VX(Code) << "Only variable bindings can be made into a table";
+
+	int n = librdf_query_results_get_bindings_count( query_results );
+	for ( int i = 0; i < n; i++ )
+	{
+		const char *name = librdf_query_results_get_binding_name( query_results, i );
+		table.names.push_back( name ? name : "" );
+	}
+	table.columns.resize( table.names.size() );
+
+	// the iterator may hold the values of the current result
+	if ( currIter && currIter->ptr() )
+		currIter->reset();
+
+	// the library gives us new nodes, which the table keeps
+	vector< librdf_node * > row( table.names.size() );
+	while ( ! librdf_query_results_finished( query_results ))
+	{
+		if ( check )
+			check();
+		if ( ! row.empty() &&
+			librdf_query_results_get_bindings( query_results, NULL, row.data() ) != 0 )
+			throw VX(Error) << "Failed to get the bound values";
+		for ( size_t i = 0; i < row.size(); i++ )
+			table.columns[i].push_back( _NodeBase::view( row[i] ));
+		table.nRows++;
+		librdf_query_results_next( query_results );
+	}
+
+	if ( currIter && currIter->ptr() )
+		currIter->reset();
+	return table;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_QueryResults::isBindings() const
+{
+	return query_results && librdf_query_results_is_bindings( query_results );
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_QueryResults::isGraph() const
+{
+	return query_results && librdf_query_results_is_graph( query_results );
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_QueryResults::isBoolean() const
+{
+	return query_results && librdf_query_results_is_boolean( query_results );
+}
+
+// -----------------------------------------------------------------------------
+
+Stream
+_QueryResults::asStream()
+{
+	if ( ! isGraph() )
+		throw VX(Code) << "The query results are not a graph";
+
+	librdf_stream *strm = librdf_query_results_as_stream( query_results );
+	if ( ! strm )
+		throw VX(Error) << "Failed to get the statements of the query results";
+	return Stream( new _Stream( world, strm, shared_from_this() ));
+}
+
+// -----------------------------------------------------------------------------
+
+AddCounts
+_QueryResults::intoModel( Model model )
+{
+	if ( ! model )
+		throw VX(Code) << "Model is null";
+	return model->addAll( asStream() );
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_QueryResults::asBoolean() const
+{
+	if ( ! isBoolean() )
+		throw VX(Code) << "The query result is not a boolean";
+
+	int value = librdf_query_results_get_boolean( query_results );
+	if ( value < 0 )
+		throw VX(Error) << "Failed to get the boolean result";
+	return value > 0;
+}
+
+// -----------------------------------------------------------------------------
+//	Writing results
+// -----------------------------------------------------------------------------
+
+namespace
+{
+
+// the results are written out in pieces of about this size
+const size_t WriteBuffer = 65536;
+
+void
+appendXML( std::string & out, StringRef s )
+{
+	for ( char c : s )
+	{
+		switch ( c )
+		{
+		case '&': out += "&amp;"; break;
+		case '<': out += "&lt;"; break;
+		case '>': out += "&gt;"; break;
+		case '"': out += "&quot;"; break;
+		default: out += c;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+void
+appendJSON( std::string & out, StringRef s )
+{
+	static const char hex[] = "0123456789abcdef";
+	out += '"';
+	for ( char c : s )
+	{
+		switch ( c )
+		{
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if ( (unsigned char)c < 0x20 )
+			{
+				out += "\\u00";
+				out += hex[ c >> 4 ];
+				out += hex[ c & 0xf ];
+			}
+			else
+				out += c;
+		}
+	}
+	out += '"';
+}
+
+// -----------------------------------------------------------------------------
+
+void
+appendCSV( std::string & out, StringRef s )
+{
+	bool quote = false;
+	for ( char c : s )
+		if ( c == '"' || c == ',' || c == '\n' || c == '\r' )
+			quote = true;
+	if ( ! quote )
+	{
+		out.append( s.data(), s.size() );
+		return;
+	}
+	out += '"';
+	for ( char c : s )
+	{
+		if ( c == '"' ) out += '"';
+		out += c;
+	}
+	out += '"';
+}
+
+// -----------------------------------------------------------------------------
+
+void
+writeHead( std::string & out, ResultFormat format, const std::vector< const char * > & names )
+{
+	switch ( format )
+	{
+	case ResultFormat::XML:
+		out += "<?xml version=\"1.0\"?>\n"
+		       "<sparql xmlns=\"http://www.w3.org/2005/sparql-results#\">\n"
+		       "  <head>\n";
+		for ( const char *name : names )
+		{
+			out += "    <variable name=\"";
+			appendXML( out, name );
+			out += "\"/>\n";
+		}
+		out += "  </head>\n";
+		break;
+
+	case ResultFormat::JSON:
+		out += "{ \"head\": { \"vars\": [";
+		for ( size_t i = 0; i < names.size(); i++ )
+		{
+			out += i ? ", " : " ";
+			appendJSON( out, names[i] );
+		}
+		out += " ] },\n";
+		break;
+
+	case ResultFormat::CSV:
+		for ( size_t i = 0; i < names.size(); i++ )
+		{
+			if ( i ) out += ',';
+			appendCSV( out, names[i] );
+		}
+		out += "\r\n";
+		break;
+
+	case ResultFormat::TSV:
+		for ( size_t i = 0; i < names.size(); i++ )
+		{
+			if ( i ) out += '\t';
+			out += '?';
+			out += names[i];
+		}
+		out += '\n';
+		break;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+void
+writeRow( std::string & out, ResultFormat format, const std::vector< const char * > & names,
+		const std::vector< librdf_node * > & row, bool first )
+{
+	switch ( format )
+	{
+	case ResultFormat::XML:
+		out += "    <result>\n";
+		for ( size_t i = 0; i < row.size(); i++ )
+		{
+			TermView v = _NodeBase::view( row[i] );
+			if ( ! v ) continue;
+			out += "      <binding name=\"";
+			appendXML( out, names[i] );
+			out += "\">";
+			if ( v.isResource() )
+			{
+				out += "<uri>";
+				appendXML( out, v.value() );
+				out += "</uri>";
+			}
+			else if ( v.isBlank() )
+			{
+				out += "<bnode>";
+				appendXML( out, v.value() );
+				out += "</bnode>";
+			}
+			else
+			{
+				out += "<literal";
+				if ( ! v.language().empty() )
+				{
+					out += " xml:lang=\"";
+					appendXML( out, v.language() );
+					out += '"';
+				}
+				if ( ! v.datatype().empty() )
+				{
+					out += " datatype=\"";
+					appendXML( out, v.datatype() );
+					out += '"';
+				}
+				out += '>';
+				appendXML( out, v.value() );
+				out += "</literal>";
+			}
+			out += "</binding>\n";
+		}
+		out += "    </result>\n";
+		break;
+
+	case ResultFormat::JSON:
+	{
+		out += first ? "    {" : ",\n    {";
+		bool any = false;
+		for ( size_t i = 0; i < row.size(); i++ )
+		{
+			TermView v = _NodeBase::view( row[i] );
+			if ( ! v ) continue;
+			out += any ? ", " : " ";
+			any = true;
+			appendJSON( out, names[i] );
+			out += ": { \"type\": ";
+			out += v.isResource() ? "\"uri\"" : v.isBlank() ? "\"bnode\"" : "\"literal\"";
+			out += ", \"value\": ";
+			appendJSON( out, v.value() );
+			if ( ! v.language().empty() )
+			{
+				out += ", \"xml:lang\": ";
+				appendJSON( out, v.language() );
+			}
+			if ( ! v.datatype().empty() )
+			{
+				out += ", \"datatype\": ";
+				appendJSON( out, v.datatype() );
+			}
+			out += " }";
+		}
+		out += " }";
+		break;
+	}
+
+	case ResultFormat::CSV:
+		for ( size_t i = 0; i < row.size(); i++ )
+		{
+			if ( i ) out += ',';
+			TermView v = _NodeBase::view( row[i] );
+			if ( v.isBlank() )
+				out += "_:";
+			if ( v )
+				appendCSV( out, v.value() );
+		}
+		out += "\r\n";
+		break;
+
+	case ResultFormat::TSV:
+		for ( size_t i = 0; i < row.size(); i++ )
+		{
+			if ( i ) out += '\t';
+			if ( row[i] )
+				_NodeBase::appendTo( row[i], out );
+		}
+		out += '\n';
+		break;
+	}
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+void
+_QueryResults::writeRows( ResultFormat format,
+		const std::function< void ( const std::string & ) > & write )
+{
+	std::string out;
+	out.reserve( WriteBuffer + WriteBuffer / 4 );
+
+	if ( query_results && librdf_query_results_is_boolean( query_results ))
+	{
+		bool value = librdf_query_results_get_boolean( query_results ) > 0;
+		if ( format == ResultFormat::XML )
+		{
+			writeHead( out, format, {} );
+			out += value ? "  <boolean>true</boolean>\n" : "  <boolean>false</boolean>\n";
+			out += "</sparql>\n";
+		}
+		else if ( format == ResultFormat::JSON )
+			out += value ? "{ \"head\": {}, \"boolean\": true }\n"
+				     : "{ \"head\": {}, \"boolean\": false }\n";
+		else
+			throw VX(Code) << "A boolean result can only be written as XML or JSON";
+		write( out );
+		return;
+	}
+	if ( query_results && ! librdf_query_results_is_bindings( query_results ))
+		throw VX(Code) << "Only variable bindings and booleans can be written";
+
+	std::vector< const char * > names;
+	int n = query_results ? librdf_query_results_get_bindings_count( query_results ) : 0;
+	for ( int i = 0; i < n; i++ )
+	{
+		const char *name = librdf_query_results_get_binding_name( query_results, i );
+		names.push_back( name ? name : "" );
+	}
+	writeHead( out, format, names );
+	if ( format == ResultFormat::XML )
+		out += "  <results>\n";
+	else if ( format == ResultFormat::JSON )
+		out += "  \"results\": { \"bindings\": [\n";
+
+	// the iterator may hold the values of the current result
+	if ( currIter && currIter->ptr() )
+		currIter->reset();
+
+	// the library gives us new nodes, freed after each result is written
+	std::vector< librdf_node * > row( names.size(), nullptr );
+	bool first = true;
+	try
+	{
+		while ( query_results && ! librdf_query_results_finished( query_results ))
+		{
+			if ( ! row.empty() &&
+				librdf_query_results_get_bindings( query_results, NULL, row.data() ) != 0 )
+				throw VX(Error) << "Failed to get the bound values";
+			writeRow( out, format, names, row, first );
+			first = false;
+			for ( auto & node : row )
+			{
+				if ( node ) librdf_free_node( node );
+				node = nullptr;
+			}
+			if ( out.size() >= WriteBuffer )
+			{
+				write( out );
+				out.clear();
+			}
+			librdf_query_results_next( query_results );
+		}
+	}
+	catch ( ... )
+	{
+		for ( auto node : row )
+			if ( node ) librdf_free_node( node );
+		throw;
+	}
+
+	if ( currIter && currIter->ptr() )
+		currIter->reset();
+
+	if ( format == ResultFormat::XML )
+		out += "  </results>\n</sparql>\n";
+	else if ( format == ResultFormat::JSON )
+		out += first ? "  ] }\n}\n" : "\n  ] }\n}\n";
+	write( out );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_QueryResults::writeTo( std::ostream & os, ResultFormat format )
+{
+	writeRows( format, [&os]( const std::string & out )
+	{
+		if ( ! os.write( out.data(), out.size() ))
+			throw VX(Error) << "Failed to write query results";
+	} );
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_QueryResults::writeTo( int fd, ResultFormat format )
+{
+	writeRows( format, [fd]( const std::string & out )
+	{
+		const char *p = out.data();
+		size_t left = out.size();
+		while ( left > 0 )
+		{
+			ssize_t n = ::write( fd, p, left );
+			if ( n < 0 && errno == EINTR )
+				continue;
+			if ( n <= 0 )
+				throw VX(Error) << "Failed to write query results: " << strerror( errno );
+			p += n;
+			left -= n;
+		}
+	} );
+}
+
+// -----------------------------------------------------------------------------
+//	ResultTable
+// -----------------------------------------------------------------------------
+
+ResultTable::~ResultTable()
+{
+	release();
+}
+
+// -----------------------------------------------------------------------------
+
+ResultTable::ResultTable( ResultTable && x )
+	: names( std::move( x.names )), columns( std::move( x.columns )),
+	  decoded( std::move( x.decoded )), nRows( x.nRows )
+{
+	x.columns.clear();
+	x.nRows = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+ResultTable &
+ResultTable::operator = ( ResultTable && x )
+{
+	if ( this != &x )
+	{
+		release();
+		names = std::move( x.names );
+		columns = std::move( x.columns );
+		decoded = std::move( x.decoded );
+		nRows = x.nRows;
+		x.columns.clear();
+		x.nRows = 0;
+	}
+	return *this;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+ResultTable::release()
+{
+	for ( auto & col : columns )
+		for ( auto & v : col )
+			if ( v ) librdf_free_node( static_cast< librdf_node * >( v.handle() ));
+	columns.clear();
+	decoded.clear();
+	nRows = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+int
+ResultTable::column( const std::string & name ) const
+{
+	for ( size_t i = 0; i < names.size(); i++ )
+		if ( names[i] == name )
+			return i;
+	return -1;
+}
+
+// -----------------------------------------------------------------------------
+
+const std::vector< TypedValue > &
+ResultTable::typedValues( size_t col ) const
+{
+	const std::vector< TermView > & col_values = columns.at( col );
+	if ( decoded.size() < columns.size() )
+		decoded.resize( columns.size() );
+	std::vector< TypedValue > & typed = decoded[ col ];
+	if ( typed.size() != col_values.size() )
+	{
+		typed.clear();
+		typed.reserve( col_values.size() );
+		for ( auto & v : col_values )
+			typed.push_back( v.typedValue() );
+	}
+	return typed;
+}
+
 // ----------------------------- end -------------------------------
 
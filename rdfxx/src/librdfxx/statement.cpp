@@ -56,6 +56,18 @@ Statement::Statement( World w, Node subject, Node predicate, Node object)
 
 // -----------------------------------------------------------------------------
 
+// static
+Statement
+Statement::build( World w, Node &&subject, Node &&predicate, Node &&object )
+{
+	librdf_node *s = _NodeBase::release( std::move( subject ));
+	librdf_node *p = _NodeBase::release( std::move( predicate ));
+	librdf_node *o = _NodeBase::release( std::move( object ));
+	return Statement( new _Statement( w, s, p, o ));
+}
+
+// -----------------------------------------------------------------------------
+
 Statement::Statement( Statement_* _statement )
 	: std::shared_ptr< Statement_ >( _statement )
 {}
@@ -94,7 +106,7 @@ _Statement::_Statement(World _w, Node _subject, Node _predicate, Node _object)
 	// librdf takes ownership of the nodes which may be confusing
 	// for the users of this library, so we make copies.
 	//
-	// Later we may provide a move interface to save making copies.
+	// Statement::build takes the nodes instead, to save making copies.
 	//
 
     statement = librdf_new_statement_from_nodes(w, 
@@ -107,6 +119,19 @@ _Statement::_Statement(World _w, Node _subject, Node _predicate, Node _object)
 
 // -----------------------------------------------------------------------------
 
+_Statement::_Statement(World _w, librdf_node *s, librdf_node *p, librdf_node *o)
+	 : world(_w), statement(0), free(true)
+{
+    librdf_world* w = DEREF( World, librdf_world, _w );
+
+    // librdf takes the nodes, and frees them if it fails
+    statement = librdf_new_statement_from_nodes(w, s, p, o);
+    if(!statement)
+	throw VX(Error) << "Failed to allocate statement";
+}
+
+// -----------------------------------------------------------------------------
+
 _Statement::_Statement( Statement _statement)
 	 : statement(0), free(true)
 {
@@ -126,6 +151,13 @@ _Statement::_Statement(World _w, librdf_statement* _statement, bool freeOnDelete
     	throw VX(Error) << "Parameter _statement is NULL pointer";
     }
 
+    // a statement that is not ours to free is used in place
+    if ( ! free )
+    {
+	statement = _statement;
+	return;
+    }
+
     statement = librdf_new_statement_from_statement( _statement );
     if(!statement)
 	throw VX(Error) << "Failed to allocate statement";
@@ -149,6 +181,41 @@ _Statement::copy() const
 
 // -----------------------------------------------------------------------------
 
+void
+_Statement::rebind( librdf_statement *_statement )
+{
+    subject_holder.reset();
+    predicate_holder.reset();
+    object_holder.reset();
+
+    if(statement && free)
+        librdf_free_statement(statement);
+
+    statement = _statement;
+    free = false;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_Statement::detach()
+{
+    if ( free || ! statement )
+	return;
+
+    // the held nodes are views into the statement being left
+    subject_holder.reset();
+    predicate_holder.reset();
+    object_holder.reset();
+
+    statement = librdf_new_statement_from_statement( statement );
+    if(!statement)
+	throw VX(Error) << "Failed to allocate statement";
+    free = true;
+}
+
+// -----------------------------------------------------------------------------
+
 NodeRef
 _Statement::subject() const
 {
@@ -169,17 +236,26 @@ _Statement::subject() const
 // -----------------------------------------------------------------------------
 
 void
-_Statement::subject(Node _node)
+_Statement::subject(const Node &_node)
 {
-    librdf_node* n = _NodeBase::derefNode( Node(_node) );
-    //
+    librdf_node* n = _NodeBase::derefNode( _node );
     // this call takes ownership, so we make a copy
-    librdf_statement_set_subject(statement, 
+    librdf_statement_set_subject(statement,
     		librdf_new_node_from_node(n) );
 }
 
 // -----------------------------------------------------------------------------
 
+void
+_Statement::subject(Node &&_node)
+{
+    // this call takes ownership, which the node gives up if it can
+    librdf_statement_set_subject(statement,
+    		_NodeBase::release( std::move( _node )) );
+}
+
+// -----------------------------------------------------------------------------
+
 NodeRef
 _Statement::predicate() const
 {
@@ -200,9 +276,9 @@ _Statement::predicate() const
 // -----------------------------------------------------------------------------
 
 void
-_Statement::predicate(Node _node)
+_Statement::predicate(const Node &_node)
 {
-    librdf_node* n = _NodeBase::derefNode( Node(_node) );
+    librdf_node* n = _NodeBase::derefNode( _node );
     // this call takes ownership, so we make a copy
     librdf_statement_set_predicate(statement,
     		librdf_new_node_from_node(n) );
@@ -210,6 +286,16 @@ _Statement::predicate(Node _node)
 
 // -----------------------------------------------------------------------------
 
+void
+_Statement::predicate(Node &&_node)
+{
+    // this call takes ownership, which the node gives up if it can
+    librdf_statement_set_predicate(statement,
+    		_NodeBase::release( std::move( _node )) );
+}
+
+// -----------------------------------------------------------------------------
+
 NodeRef
 _Statement::object() const
 {
@@ -230,9 +316,9 @@ _Statement::object() const
 // -----------------------------------------------------------------------------
 
 void
-_Statement::object(Node _node)
+_Statement::object(const Node &_node)
 {
-    librdf_node* n = _NodeBase::derefNode( Node(_node) );
+    librdf_node* n = _NodeBase::derefNode( _node );
     // this call takes ownership, so we make a copy
     librdf_statement_set_object(statement,
     		librdf_new_node_from_node(n) );
@@ -240,6 +326,16 @@ _Statement::object(Node _node)
 
 // -----------------------------------------------------------------------------
 
+void
+_Statement::object(Node &&_node)
+{
+    // this call takes ownership, which the node gives up if it can
+    librdf_statement_set_object(statement,
+    		_NodeBase::release( std::move( _node )) );
+}
+
+// -----------------------------------------------------------------------------
+
 bool
 _Statement::isComplete() const
 {
@@ -277,28 +373,45 @@ std::string
 _Statement::toString() const
 {
 	string s;
-	char *str = NULL;
-	size_t len = 2;
-	librdf_world* w = DEREF( World, librdf_world, world );
+	appendTo( s );
+	return s;
+}
 
-	raptor_world * rw = librdf_world_get_raptor(w);
-	if ( rw )
-	{
-		raptor_iostream *stream = raptor_new_iostream_to_string(rw, (void**)& str, &len, malloc );
-		librdf_statement_write( statement, stream );
-		raptor_free_iostream(stream);
-	}
-	else
-	{
-		cerr << "Failed to get raptor world" << endl;
-	}
-	if ( str ) s = str;
-	::free(str);
+// -----------------------------------------------------------------------------
 
-    // deprecated
-    // sstring = (const char*) librdf_statement_to_string(statement);
+// written as librdf_statement_write does, without going through raptor
+void
+_Statement::appendTo( std::string &s ) const
+{
+	_NodeBase::appendTo( librdf_statement_get_subject(statement), s );
+	s += ' ';
+	_NodeBase::appendTo( librdf_statement_get_predicate(statement), s );
+	s += ' ';
+	_NodeBase::appendTo( librdf_statement_get_object(statement), s );
+}
 
-    return s;
+// -----------------------------------------------------------------------------
+
+void
+_Statement::writeTo( std::ostream &os ) const
+{
+	// reused, so writing a statement does not allocate once it has grown
+	static thread_local string buffer;
+	buffer.clear();
+	appendTo( buffer );
+	os.write( buffer.data(), buffer.size() );
+}
+
+// -----------------------------------------------------------------------------
+
+std::ostream &
+rdf::operator << ( std::ostream &os, const Statement &s )
+{
+	if ( s )
+		s->writeTo( os );
+	else
+		os << "(null)";
+	return os;
 }
 
 // -----------------------------------------------------------------------------
@@ -327,6 +440,7 @@ _Statement::operator ==(Statement _statement) const
 
 // -----------------------------------------------------------------------------
 
+// two null statements are equal, as they sort and hash the same
 bool
 rdf::operator == ( Statement _a, Statement _b )
 {
@@ -336,7 +450,118 @@ rdf::operator == ( Statement _a, Statement _b )
 		return (*s) == _b;
 	}
 	else
-		return false;
+		return ! _b;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+rdf::operator != ( Statement a, Statement b )
+{
+	return ! ( a == b );
+}
+
+// -----------------------------------------------------------------------------
+
+// null statements sort first
+bool
+rdf::operator < ( Statement _a, Statement _b )
+{
+	librdf_statement *a = DEREF( Statement, librdf_statement, _a );
+	librdf_statement *b = DEREF( Statement, librdf_statement, _b );
+	if ( a == nullptr || b == nullptr )
+		return a == nullptr && b != nullptr;
+	return _Statement::compare( a, b ) < 0;
+}
+
+// -----------------------------------------------------------------------------
+
+size_t
+_Statement::hash() const
+{
+	size_t h = HashSeed;
+	librdf_node *nodes[] = {
+		librdf_statement_get_subject(statement),
+		librdf_statement_get_predicate(statement),
+		librdf_statement_get_object(statement) };
+	for ( librdf_node *n : nodes )
+	{
+		size_t nh = _NodeBase::hash( n );
+		h = hashBytes( &nh, sizeof(nh), h );
+	}
+	return h;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+TripleView
+_Statement::view( librdf_statement *s )
+{
+	if ( ! s )
+		return TripleView();
+	return TripleView( _NodeBase::view( librdf_statement_get_subject(s) ),
+			_NodeBase::view( librdf_statement_get_predicate(s) ),
+			_NodeBase::view( librdf_statement_get_object(s) ));
+}
+
+// -----------------------------------------------------------------------------
+//	TripleView
+// -----------------------------------------------------------------------------
+
+void
+TripleView::appendTo( std::string &str ) const
+{
+	s.appendTo( str );
+	str += ' ';
+	p.appendTo( str );
+	str += ' ';
+	o.appendTo( str );
+}
+
+// -----------------------------------------------------------------------------
+
+Statement
+TripleView::toStatement( World world ) const
+{
+	Statement st( world );
+	librdf_statement *ls = DEREF( Statement, librdf_statement, st );
+
+	// the statement takes ownership of the copies
+	if ( s ) librdf_statement_set_subject( ls,
+			librdf_new_node_from_node( static_cast< librdf_node * >( s.handle() )));
+	if ( p ) librdf_statement_set_predicate( ls,
+			librdf_new_node_from_node( static_cast< librdf_node * >( p.handle() )));
+	if ( o ) librdf_statement_set_object( ls,
+			librdf_new_node_from_node( static_cast< librdf_node * >( o.handle() )));
+	return st;
+}
+
+// -----------------------------------------------------------------------------
+
+std::ostream &
+rdf::operator << ( std::ostream &os, const TripleView &t )
+{
+	static thread_local string buffer;
+	buffer.clear();
+	t.appendTo( buffer );
+	return os.write( buffer.data(), buffer.size() );
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+int
+_Statement::compare( librdf_statement *a, librdf_statement *b )
+{
+	int c = _NodeBase::compare( librdf_statement_get_subject(a),
+				librdf_statement_get_subject(b) );
+	if ( c != 0 ) return c;
+	c = _NodeBase::compare( librdf_statement_get_predicate(a),
+				librdf_statement_get_predicate(b) );
+	if ( c != 0 ) return c;
+	return _NodeBase::compare( librdf_statement_get_object(a),
+				librdf_statement_get_object(b) );
 }
 
 // -----------------------------------------------------------------------------
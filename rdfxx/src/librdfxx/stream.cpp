@@ -97,8 +97,19 @@ _Stream::_Stream(World _w, librdf_stream* _stream) :
 
 // -----------------------------------------------------------------------------
 
+_Stream::_Stream(World _w, librdf_stream* _stream, QueryResults _results) :
+    world(_w),
+    stream(_stream),
+    currStatement(nullptr),
+    results(_results)
+{}
+
+// -----------------------------------------------------------------------------
+
 _Stream::~_Stream()
 {
+    releaseBatch();
+    releaseView();
     if(stream)
         librdf_free_stream(stream);
 }
@@ -116,7 +127,7 @@ _Stream::end()
 bool
 _Stream::next()
 {
-    currStatement.reset();
+    releaseView();
     int status = librdf_stream_next(stream);
 
     return (status == 0) ? true : false;
@@ -129,15 +140,218 @@ _Stream::current()
 {
 	// gets a shared pointer into librdf structures.
 	// only valid until next() or stream closed.
-        currStatement = Statement(new _Statement(world, librdf_stream_get_object(stream),false));
+        currStatement = currentView();
         return currStatement;
 }
 
 // -----------------------------------------------------------------------------
 
+Statement
+_Stream::currentView()
+{
+	librdf_statement *s = librdf_stream_get_object(stream);
+	if ( ! s )
+		throw VX(Error) << "Stream has no current statement";
+
+	if ( ! viewStatement )
+		viewStatement = Statement( new _Statement( world ));
+	static_cast< _Statement * >( viewStatement.get() )->rebind( s );
+	return viewStatement;
+}
+
+// -----------------------------------------------------------------------------
+
+// A view that is still held outside takes its own copy of the statement
+// before the stream moves on, so that it neither changes nor dangles. A new
+// view is made for the next statement.
+void
+_Stream::releaseView()
+{
+	currStatement.reset();
+	if ( viewStatement && viewStatement.use_count() > 1 )
+	{
+		static_cast< _Statement * >( viewStatement.get() )->detach();
+		viewStatement.reset();
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+TripleView
+_Stream::triple()
+{
+	return _Statement::view( librdf_stream_get_object(stream) );
+}
+
+// -----------------------------------------------------------------------------
+
+size_t
+_Stream::nextBatch( TripleView *buffer, size_t n )
+{
+	releaseBatch();
+	releaseView();
+
+	size_t count = 0;
+	while ( count < n && ! librdf_stream_end(stream) )
+	{
+		librdf_statement *s = librdf_stream_get_object(stream);
+		librdf_node *nodes[] =
+		{
+			librdf_statement_get_subject(s),
+			librdf_statement_get_predicate(s),
+			librdf_statement_get_object(s)
+		};
+
+		// the stream may free its statement when it moves on,
+		// so keep the nodes, which only counts a reference
+		for ( librdf_node *&node : nodes )
+		{
+			if ( node )
+			{
+				node = librdf_new_node_from_node(node);
+				batch.push_back( node );
+			}
+		}
+		buffer[ count++ ] = TripleView( _NodeBase::view( nodes[0] ),
+				_NodeBase::view( nodes[1] ), _NodeBase::view( nodes[2] ));
+		librdf_stream_next(stream);
+	}
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+
+void
+_Stream::releaseBatch()
+{
+	for ( librdf_node *node : batch )
+		librdf_free_node(node);
+	batch.clear();
+}
+
+// -----------------------------------------------------------------------------
+
 _Stream::operator librdf_stream*()
 {
     return stream;
 }
 
+// -----------------------------------------------------------------------------
+//	StatementRange
+// -----------------------------------------------------------------------------
+
+StatementRange::StatementRange( Stream _stream )
+	: stream( _stream )
+{}
+
+// -----------------------------------------------------------------------------
+
+StatementRange::iterator
+StatementRange::begin() const
+{
+	return iterator( stream.get() );
+}
+
+// -----------------------------------------------------------------------------
+
+StatementRange::iterator
+StatementRange::end() const
+{
+	return iterator();
+}
+
+// -----------------------------------------------------------------------------
+
+StatementRange::iterator::iterator( Stream_ *_stream )
+	: stream( _stream )
+{
+	if ( stream && stream->end() )
+		stream = nullptr;
+	if ( stream )
+		view = static_cast< _Stream * >( stream )->currentView();
+}
+
+// -----------------------------------------------------------------------------
+
+StatementRange::iterator::iterator()
+	: stream( nullptr )
+{}
+
+// -----------------------------------------------------------------------------
+
+const Statement &
+StatementRange::iterator::operator *() const
+{
+	return view;
+}
+
+// -----------------------------------------------------------------------------
+
+Statement_ *
+StatementRange::iterator::operator ->() const
+{
+	return view.get();
+}
+
+// -----------------------------------------------------------------------------
+
+TripleView
+StatementRange::iterator::triple() const
+{
+	if ( ! view )
+		return TripleView();
+	return static_cast< _Statement * >( view.get() )->view();
+}
+
+// -----------------------------------------------------------------------------
+
+StatementRange::iterator &
+StatementRange::iterator::operator ++ ()
+{
+	if ( stream )
+	{
+		// let go of the view, so that only copies kept by the caller
+		// are detached
+		view.reset();
+		stream->next();
+		if ( stream->end() )
+			stream = nullptr;
+		else
+			view = static_cast< _Stream * >( stream )->currentView();
+	}
+	return *this;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+StatementRange::iterator::operator == ( const iterator & other ) const
+{
+	return stream == other.stream;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+StatementRange::iterator::operator != ( const iterator & other ) const
+{
+	return stream != other.stream;
+}
+
+// -----------------------------------------------------------------------------
+
+StatementRange::iterator
+rdf::begin( const Stream & stream )
+{
+	return StatementRange::iterator( stream.get() );
+}
+
+// -----------------------------------------------------------------------------
+
+StatementRange::iterator
+rdf::end( const Stream & )
+{
+	return StatementRange::iterator();
+}
+
 // -------------------------------- end ----------------------------------------
@@ -26,6 +26,8 @@
  */
 
 
+#include <algorithm>
+#include <cstring>
 #include <rdfxx/except.h>
 #include <rdfxx/uri.hpp>
 #include <rdfxx/world.hpp>
@@ -212,18 +214,10 @@ _URI::copy() const
 URI
 _URI::trim( World w ) const
 {
-	string s( toString() );
-	string::size_type p = s.find_last_of('#');
-	if ( p == string::npos )
-	{
-		p = s.find_last_of('/');
-		if ( p == string::npos )
-			return copy();
-		else
-			return URI( w, s.substr(0,p+1));
-	}
-	else
-		return URI( w, s.substr(0,p+1));
+	StringRef ns = nameSpace();
+	if ( ns.size() == view().size() )
+		return copy();
+	return URI( w, ns.str() );
 }
 
 // -----------------------------------------------------------------------------
@@ -235,6 +229,8 @@ _URI::set_string(World _w, const char* _uri_string)
 	librdf_free_uri(uri);
 	uri = 0;
     }
+    hashed = false;
+    split = false;
     
     librdf_world* w = DEREF( World, librdf_world, _w);
 
@@ -248,16 +244,48 @@ _URI::set_string(World _w, const char* _uri_string)
 std::string
 _URI::toString() const
 {
-    string s( (const char*) librdf_uri_as_string(uri));
-
-    return s;
+    return view().str();
 }
 
 // -----------------------------------------------------------------------------
 
 _URI::operator const char*() const
 {
-    return toString().c_str();
+    return (const char *) librdf_uri_as_string(uri);
+}
+
+// -----------------------------------------------------------------------------
+
+StringRef
+_URI::view() const
+{
+	size_t len = 0;
+	const unsigned char *s = librdf_uri_as_counted_string( uri, &len );
+	return StringRef( reinterpret_cast< const char * >( s ), len );
+}
+
+// -----------------------------------------------------------------------------
+
+StringRef
+_URI::nameSpace() const
+{
+	StringRef s = view();
+	if ( ! split )
+	{
+		nsLength = namespaceLength( s.data(), s.size() );
+		split = true;
+	}
+	return StringRef( s.data(), nsLength );
+}
+
+// -----------------------------------------------------------------------------
+
+StringRef
+_URI::localName() const
+{
+	StringRef s = view();
+	size_t n = nameSpace().size();
+	return StringRef( s.data() + n, s.size() - n );
 }
 
 // -----------------------------------------------------------------------------
@@ -298,6 +326,7 @@ _URI::operator ==( URI _uri ) const
 
 // -----------------------------------------------------------------------------
 
+// two null URIs are equal, as they sort and hash the same
 bool
 rdf::operator == ( URI _a, URI _b )
 {
@@ -307,7 +336,82 @@ rdf::operator == ( URI _a, URI _b )
 		return ((*a) == _b);
 	}
 	else
-		return false;
+		return ! _b;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+_URI::operator <( URI _uri ) const
+{
+	librdf_uri *u = DEREF( URI, librdf_uri, _uri );
+	if ( ! u ) return false;
+	return compare( uri, u ) < 0;
+}
+
+// -----------------------------------------------------------------------------
+
+bool
+rdf::operator != ( URI _a, URI _b )
+{
+	return ! ( _a == _b );
+}
+
+// -----------------------------------------------------------------------------
+
+// null URIs sort first
+bool
+rdf::operator < ( URI _a, URI _b )
+{
+	_URI *a = static_cast< _URI * >( _a.get());
+	if ( a )
+		return (*a) < _b;
+	else
+		return static_cast< bool >( _b );
+}
+
+// -----------------------------------------------------------------------------
+
+size_t
+_URI::hash() const
+{
+	if ( ! hashed )
+	{
+		StringRef s = view();
+		hashValue = hashBytes( s.data(), s.size() );
+		hashed = true;
+	}
+	return hashValue;
+}
+
+// -----------------------------------------------------------------------------
+
+// static
+int
+_URI::compare( librdf_uri *a, librdf_uri *b )
+{
+	if ( a == b ) return 0;
+	size_t alen = 0, blen = 0;
+	const unsigned char *as = librdf_uri_as_counted_string( a, &alen );
+	const unsigned char *bs = librdf_uri_as_counted_string( b, &blen );
+	int c = memcmp( as, bs, std::min( alen, blen ));
+	if ( c != 0 ) return c;
+	return ( alen < blen ) ? -1 : ( alen > blen ? 1 : 0 );
+}
+
+// -----------------------------------------------------------------------------
+
+std::ostream &
+rdf::operator << ( std::ostream &os, const URI &u )
+{
+	if ( u )
+	{
+		StringRef s = u->view();
+		os.write( s.data(), s.size() );
+	}
+	else
+		os << "(null)";
+	return os;
 }
 
 // -----------------------------------------------------------------------------
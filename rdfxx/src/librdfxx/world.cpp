@@ -29,6 +29,13 @@
 #include <rdfxx/except.h>
 #include <rdfxx/world.hpp>
 #include <rdfxx/serializer.hpp>
+#include <rdfxx/columnar.hpp>
+#include <rdfxx/query.hpp>
+#include <rdfxx/uri.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstring>
 #include <iostream>
 
 using namespace rdf;
@@ -50,10 +57,11 @@ Universe::instance()
 World
 Universe::world( const std::string & name )
 {
+	std::lock_guard< std::mutex > guard( lock );
 	auto wi = worlds.find( name );
 	if ( wi == worlds.end() )
 	{
-		World w( new _World(name) );
+		World w( _World::make( name ));
 		worlds[name] = w;
 		return w;
 	}
@@ -61,11 +69,192 @@ Universe::world( const std::string & name )
 		return wi->second;
 }
 
+// ----------------------------------------------------------------------------
+
+WorldPool &
+Universe::pool( const std::string & name )
+{
+	std::lock_guard< std::mutex > guard( lock );
+	std::unique_ptr< WorldPool > & p = pools[ name ];
+	if ( ! p )
+		p.reset( new WorldPool( name ));
+	return *p;
+}
+
+// ----------------------------------------------------------------------------
+//	WorldPool
+// ----------------------------------------------------------------------------
+
+WorldPool::WorldPool( const std::string & name )
+	: pool_name( name ), made( 0 )
+{}
+
+// ----------------------------------------------------------------------------
+
+World
+WorldPool::world()
+{
+	// only the calling thread adds, changes or releases its own member, so
+	// the lock is held just to reach the map, not while librdf works
+	std::thread::id self = std::this_thread::get_id();
+	World w;
+	size_t applied = 0;
+	size_t number = 0;
+	std::vector< std::pair< std::string, std::string > > missing;
+	{
+		std::lock_guard< std::mutex > guard( lock );
+		auto mi = members.find( self );
+		if ( mi != members.end() )
+		{
+			w = mi->second.world;
+			applied = mi->second.applied;
+		}
+		else
+			number = ++made;
+		missing.assign( shared.begin() + applied, shared.end() );
+	}
+
+	if ( ! w )
+		w = _World::make( pool_name + "/" + std::to_string( number ));
+
+	// catch up with the prefixes shared since the world was last handed out
+	for ( auto & sp : missing )
+		w->prefixes().insert( sp.first, URI( w, sp.second ));
+
+	std::lock_guard< std::mutex > guard( lock );
+	Member & m = members[ self ];
+	m.world = w;
+	m.applied = applied + missing.size();
+	return w;
+}
+
+// ----------------------------------------------------------------------------
+
+void
+WorldPool::release()
+{
+	World w;	// dropped after the lock, as the world may close with it
+	std::lock_guard< std::mutex > guard( lock );
+	auto mi = members.find( std::this_thread::get_id() );
+	if ( mi != members.end() )
+	{
+		w = mi->second.world;
+		members.erase( mi );
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+void
+WorldPool::sharePrefix( const std::string & prefix, const std::string & ns )
+{
+	std::lock_guard< std::mutex > guard( lock );
+	shared.push_back( std::make_pair( prefix, ns ));
+}
+
+// ----------------------------------------------------------------------------
+
+void
+WorldPool::sharePrefixes( World w )
+{
+	// read the world before taking the lock, it may be one of ours
+	std::vector< std::pair< std::string, std::string > > found;
+	for ( auto & p : w->prefixes() )
+	{
+		if ( p.second )
+			found.push_back( std::make_pair( p.first, p.second->toString() ));
+	}
+
+	std::lock_guard< std::mutex > guard( lock );
+	shared.insert( shared.end(), found.begin(), found.end() );
+}
+
+// ----------------------------------------------------------------------------
+
+size_t
+WorldPool::size() const
+{
+	std::lock_guard< std::mutex > guard( lock );
+	return members.size();
+}
+
 // ----------------------------------------------------------------------------
 //	Prefixes
 // ----------------------------------------------------------------------------
+//
+// The conversions work on the characters of the URIs in place, so that
+// rendering a node makes no URI objects and calls nothing in librdf.
+//
+
+namespace
+{
 
-int Prefixes::anonCounter = 1;
+const char *
+uriChars( URI uri, size_t & len )
+{
+	librdf_uri *u = DEREF( URI, librdf_uri, uri );
+	return (const char *)librdf_uri_as_counted_string( u, &len );
+}
+
+int
+compare( const std::string & a, const char *b, size_t len )
+{
+	int c = memcmp( a.data(), b, std::min( a.size(), len ));
+	if ( c != 0 ) return c;
+	return ( a.size() < len ) ? -1 : ( a.size() > len ? 1 : 0 );
+}
+
+// the first entry of a sorted table whose key is not less than the one given
+template < class T >
+size_t
+position( const std::vector< T > & v, std::string T::*key, const char *s, size_t len )
+{
+	size_t lo = 0, hi = v.size();
+	while ( lo < hi )
+	{
+		size_t mid = ( lo + hi ) / 2;
+		if ( compare( v[mid].*key, s, len ) < 0 )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+template < class T >
+const T *
+search( const std::vector< T > & v, std::string T::*key, const char *s, size_t len )
+{
+	size_t i = position( v, key, s, len );
+	return ( i < v.size() && compare( v[i].*key, s, len ) == 0 ) ? &v[i] : nullptr;
+}
+
+template < class T >
+void
+place( std::vector< T > & v, std::string T::*key, const T & entry )
+{
+	const std::string & k = entry.*key;
+	size_t i = position( v, key, k.data(), k.size() );
+	if ( i < v.size() && v[i].*key == k )
+		v[i] = entry;
+	else
+		v.insert( v.begin() + i, entry );
+}
+
+template < class T >
+void
+erase( std::vector< T > & v, std::string T::*key, const std::string & k )
+{
+	size_t i = position( v, key, k.data(), k.size() );
+	if ( i < v.size() && v[i].*key == k )
+		v.erase( v.begin() + i );
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+std::atomic< int > Prefixes::anonCounter( 1 );
 
 // ----------------------------------------------------------------------------
 
@@ -123,20 +312,22 @@ Prefixes::base( const std::string & uri )
 
 // ----------------------------------------------------------------------------
 
+void
+Prefixes::base( URI uri )
+{
+	base_uri = uri;
+	base_string = uri ? uri->toString() : "";
+}
+
+// ----------------------------------------------------------------------------
+
 bool
 Prefixes::isBase( URI uri ) const
 {
-	string s( uri->toString() );
-	string::size_type p = s.find_last_of('#');
-	if ( p == string::npos )
-	{
-		return false;
-	}
-	else
-	{
-		URI u(World(world), s.substr(0,p+1));
-		return (u == base_uri);
-	}
+	size_t len;
+	const char *s = uriChars( uri, len );
+	size_t p = fragmentStart( s, len );
+	return p > 0 && base_uri && compare( base_string, s, p ) == 0;
 }
 
 // ----------------------------------------------------------------------------
@@ -144,16 +335,9 @@ Prefixes::isBase( URI uri ) const
 std::string
 Prefixes::removeBase( URI uri ) const
 {
-	string s( uri->toString() );
-	string::size_type p = s.find_last_of('#');
-	if ( p == string::npos )
-	{
-		return s;
-	}
-	else
-	{
-		return s.substr(p+1);
-	}
+	StringRef s = uri->view();
+	size_t p = fragmentStart( s.data(), s.size() );
+	return string( s.data() + p, s.size() - p );
 }
 
 // ----------------------------------------------------------------------------
@@ -184,9 +368,23 @@ Prefixes::insert( const std::string &prefix, URI _uri )
 	{
 		return;
 	}
-	
+
+	// a prefix given a new namespace no longer abbreviates the old one
+	const Namespace *old = findPrefix( prefix.data(), prefix.size() );
+	if ( old )
+	{
+		string oldNs( old->ns );
+		const Namespace *n = findNamespace( oldNs.data(), oldNs.size() );
+		if ( n && n->prefix == prefix )
+			erase( byNamespace, &Namespace::ns, oldNs );
+	}
+
+	Namespace entry;
+	entry.ns = _uri->toString();
+	entry.prefix = prefix;
 	uriForPrefix[ prefix ] = _uri;
-	prefixForURI[ _uri->toString() ] = prefix;
+	place( byNamespace, &Namespace::ns, entry );
+	place( byPrefix, &Namespace::prefix, entry );
 }
 
 // ----------------------------------------------------------------------------
@@ -203,9 +401,18 @@ Prefixes::update( const std::string &oldPrefix, const std::string &newPrefix, UR
 void
 Prefixes::remove( const std::string &prefix )
 {
-	URI uri = uriForPrefix[ prefix ];
-	uriForPrefix.erase( prefix );
-	prefixForURI.erase( uri->toString() );
+	if ( uriForPrefix.erase( prefix ) == 0 )
+		return;
+
+	const Namespace *p = findPrefix( prefix.data(), prefix.size() );
+	if ( p )
+	{
+		string ns( p->ns );
+		erase( byPrefix, &Namespace::prefix, prefix );
+		const Namespace *n = findNamespace( ns.data(), ns.size() );
+		if ( n && n->prefix == prefix )
+			erase( byNamespace, &Namespace::ns, ns );
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -213,14 +420,9 @@ Prefixes::remove( const std::string &prefix )
 std::string
 Prefixes::find( URI _uri )
 {
-	URI u = _uri->trim( World(world));
-	auto I = prefixForURI.find( u->toString() );
-	if ( I == prefixForURI.end() )
-	{
-		return "";
-	}
-	else
-		return I->second;
+	StringRef ns = _uri->nameSpace();
+	const Namespace *n = findNamespace( ns.data(), ns.size() );
+	return n ? n->prefix : "";
 }
 
 // ----------------------------------------------------------------------------
@@ -228,7 +430,24 @@ Prefixes::find( URI _uri )
 URI
 Prefixes::find( const std::string &prefix )
 {
-	return uriForPrefix[ prefix ];
+	auto I = uriForPrefix.find( prefix );
+	return ( I == uriForPrefix.end() ) ? URI() : I->second;
+}
+
+// ----------------------------------------------------------------------------
+
+const Prefixes::Namespace *
+Prefixes::findNamespace( const char *ns, size_t len ) const
+{
+	return search( byNamespace, &Namespace::ns, ns, len );
+}
+
+// ----------------------------------------------------------------------------
+
+const Prefixes::Namespace *
+Prefixes::findPrefix( const char *prefix, size_t len ) const
+{
+	return search( byPrefix, &Namespace::prefix, prefix, len );
 }
 
 // ----------------------------------------------------------------------------
@@ -236,24 +455,47 @@ Prefixes::find( const std::string &prefix )
 URI
 Prefixes::uriForm( const std::string &s )
 {
-	if ( s.empty() ) return nullptr;
-	if ( s[0] == '<' && s[s.length()-1] == '>' )
-		return URI(World(world), s.substr(1, s.length()-2));
-	string::size_type p = s.find(':');
-	if ( p == string::npos )
+	string u;
+	if ( ! uriForm( s.data(), s.size(), u ))
+		return nullptr;
+	return URI( World(world), u );
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+Prefixes::uriForm( const char *name, size_t len, std::string & out ) const
+{
+	if ( len == 0 ) return false;
+	if ( name[0] == '<' && name[len-1] == '>' && len >= 2 )
 	{
-		return URI( s, base() );
+		out.append( name + 1, len - 2 );
+		return true;
 	}
-	if ( s.length() > p+2 )
+
+	const char *colon = static_cast< const char * >( memchr( name, ':', len ));
+	if ( ! colon )
 	{
-		if ( s[p+1] == '/' && s[p+2] == '/' )
-			return URI(World(world), s );
+		// a local name in the base namespace
+		if ( ! base_uri ) return false;
+		out += base_string;
+		out.append( name, len );
+		return true;
 	}
-	URI uri = uriForPrefix[ s.substr(0,p)];
-	if ( uri )
-		return URI( s, URI(World(world), s.substr(0,p+1)), uri );
-	else
-		return nullptr;
+
+	size_t p = colon - name;
+	if ( len > p+2 && name[p+1] == '/' && name[p+2] == '/' )
+	{
+		// already a URI
+		out.append( name, len );
+		return true;
+	}
+
+	const Namespace *n = findPrefix( name, p );
+	if ( ! n ) return false;
+	out += n->ns;
+	out.append( colon + 1, len - p - 1 );
+	return true;
 }
 
 // ----------------------------------------------------------------------------
@@ -261,26 +503,37 @@ Prefixes::uriForm( const std::string &s )
 std::string
 Prefixes::prefixForm( URI uri )
 {
-	string s( uri->toString());
-	if ( isBase( uri ))
+	size_t len;
+	const char *s = uriChars( uri, len );
+	string out;
+	prefixForm( s, len, out );
+	return out;
+}
+
+// ----------------------------------------------------------------------------
+
+void
+Prefixes::prefixForm( const char *uri, size_t len, std::string & out ) const
+{
+	size_t frag = fragmentStart( uri, len );
+	if ( frag > 0 && base_uri && compare( base_string, uri, frag ) == 0 )
+	{
+		out.append( uri + frag, len - frag );
+		return;
+	}
+
+	size_t ns = namespaceLength( uri, len );
+	const Namespace *n = ( ns < len ) ? findNamespace( uri, ns ) : nullptr;
+	if ( n )
 	{
-		s = removeBase( uri );
+		out += n->prefix;
+		out += ':';
+		out.append( uri + ns, len - ns );
 	}
 	else
 	{
-		string prefix = find( uri );
-		if (! prefix.empty())
-		{
-			URI src = find( prefix );
-			if ( !( src == uri ) )
-			{
-				prefix.append(":");
-				URI res( uri->toString(), src, URI(World(world), prefix));
-				s = res->toString();
-			}
-		}
+		out.append( uri, len );
 	}
-	return s;
 }
 
 // ----------------------------------------------------------------------------
@@ -299,7 +552,9 @@ _World::~_World()
 
 _World::_World( const std::string &nm)
 	: world_name(nm), world_prefixes(nullptr), 
-	  forErrors(false), forWarnings(true)
+	  forErrors(false), forWarnings(true),
+	  internHits(0), internMisses(0),
+	  queryHits(0), queryMisses(0), queryParseSeconds(0), closed(false)
 {
 	world = librdf_new_world();
         if(!world)
@@ -307,10 +562,49 @@ _World::_World( const std::string &nm)
 	
 	librdf_world_set_warning( world, &forWarnings, errorHandler );
 	librdf_world_set_error( world, &forErrors, errorHandler);
+
+	// storage factories can only be added to an open world
+	librdf_world_open( world );
+	_ColumnarStore::registerFactory( world );
+}
+
+// ----------------------------------------------------------------------------
+
+// static
+World
+_World::make( const std::string & name )
+{
+	// the handle is made from the abstract class, so that it does not
+	// take over shared_from_this()
+	std::shared_ptr< _World > w( new _World( name ));
+	World_ *handle = w.get();
+	return World( handle, [w]( World_ * ) mutable
+	{
+		w->closeCaches();
+		w.reset();
+	});
 }
 
 // ----------------------------------------------------------------------------
 
+void
+_World::closeCaches()
+{
+	closed = true;
+	for ( auto & shard : internShards )
+	{
+		std::lock_guard< std::mutex > guard( shard.lock );
+		shard.nodes.clear();
+	}
+	{
+		std::lock_guard< std::mutex > guard( queryLock );
+		queryIndex.clear();
+		queries.clear();
+	}
+	defSerializer = nullptr;
+}
+// ----------------------------------------------------------------------------
+
 void 
 _World::registerErrorClient( ErrorClient *client, bool warnings, bool errors )
 {
@@ -348,9 +642,234 @@ _World::prefixes()
 
 // ----------------------------------------------------------------------------
 
+ResourceNode
+_World::intern( const std::string & iri )
+{
+	InternShard & shard = internShards[ std::hash< std::string >()( iri ) % InternShardCount ];
+	{
+		std::lock_guard< std::mutex > guard( shard.lock );
+		auto I = shard.nodes.find( iri );
+		if ( I != shard.nodes.end() )
+		{
+			internHits++;
+			return I->second;
+		}
+	}
+
+	World w = shared_from_this();
+	ResourceNode node( w, URI( w, iri ));
+
+	// once closed, nothing is kept that would hold the world
+	if ( closed )
+	{
+		internMisses++;
+		return node;
+	}
+
+	std::lock_guard< std::mutex > guard( shard.lock );
+	auto res = shard.nodes.emplace( iri, node );
+	if ( res.second )
+		internMisses++;
+	else
+		internHits++;
+	return res.first->second;
+}
+
+// ----------------------------------------------------------------------------
+
+InternStats
+_World::internStats() const
+{
+	InternStats stats;
+	stats.hits = internHits;
+	stats.misses = internMisses;
+	stats.size = 0;
+	for ( auto & shard : internShards )
+	{
+		std::lock_guard< std::mutex > guard( const_cast< std::mutex & >( shard.lock ));
+		stats.size += shard.nodes.size();
+	}
+	return stats;
+}
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// Blank node numbers are shared by all worlds. Each thread takes a block
+// of them at a time, so the counter is rarely touched.
+const unsigned long long BlankBlock = 4096;
+std::atomic< unsigned long long > blankCounter( 0 );
+
+struct BlankRange
+{
+	unsigned long long next;
+	unsigned long long end;
+};
+thread_local BlankRange blankRange = { 0, 0 };
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+BlankNode
+_World::newBlankNode()
+{
+	// librdf makes its ids from 'r' and digits, so an id of its with
+	// an '_' after it cannot be one librdf will make
+	if ( blankTag.empty() )
+	{
+		unsigned char *genid = librdf_world_get_genid( world );
+		if ( ! genid )
+			throw VX(Error) << "Failed to generate a blank node id";
+		blankTag = (const char *)genid;
+		blankTag += '_';
+		librdf_free_memory( genid );
+	}
+
+	BlankRange & range = blankRange;
+	if ( range.next == range.end )
+	{
+		range.next = blankCounter.fetch_add( BlankBlock, std::memory_order_relaxed );
+		range.end = range.next + BlankBlock;
+	}
+
+	return BlankNode( shared_from_this(), blankTag + std::to_string( range.next++ ));
+}
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+//
+// Append the text with each run of spaces collapsed to one, and those at
+// the ends dropped, except within string literals.
+//
+void
+normaliseQuery( const std::string & text, std::string & out )
+{
+	const char *p = text.data();
+	const char *end = p + text.size();
+	bool space = false;
+	bool started = false;
+	while ( p < end )
+	{
+		char c = *p;
+		if ( isspace( (unsigned char)c ))
+		{
+			space = true;
+			p++;
+			continue;
+		}
+		if ( space && started )
+			out += ' ';
+		space = false;
+		started = true;
+
+		if ( c != '"' && c != '\'' )
+		{
+			out += c;
+			p++;
+			continue;
+		}
+
+		// copy the literal as it is, long literals end with three quotes
+		bool isLong = end - p >= 3 && p[1] == c && p[2] == c;
+		const char *q = p + ( isLong ? 3 : 1 );
+		while ( q < end )
+		{
+			if ( *q == '\\' && q + 1 < end )
+				q += 2;
+			else if ( *q != c )
+				q++;
+			else if ( ! isLong )
+			{
+				q++;
+				break;
+			}
+			else if ( end - q >= 3 && q[1] == c && q[2] == c )
+			{
+				q += 3;
+				break;
+			}
+			else
+				q++;
+		}
+		out.append( p, q - p );
+		p = q;
+	}
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+Query
+_World::preparedQuery( const std::string & text, const std::string & lang )
+{
+	std::string key( lang );
+	key += '\n';
+	normaliseQuery( text, key );
+
+	{
+		std::lock_guard< std::mutex > guard( queryLock );
+		auto I = queryIndex.find( key );
+		// one that is in use could have its results replaced
+		if ( I != queryIndex.end() && I->second->query.use_count() == 1 )
+		{
+			queries.splice( queries.begin(), queries, I->second );
+			queryHits++;
+			// the last user may have bound its parameters
+			static_cast< _Query * >( queries.front().query.get() )->clearBindings();
+			return queries.front().query;
+		}
+	}
+
+	// parse outside the lock
+	auto start = std::chrono::steady_clock::now();
+	Query query( shared_from_this(), text, lang );
+	std::chrono::duration< double > took = std::chrono::steady_clock::now() - start;
+
+	std::lock_guard< std::mutex > guard( queryLock );
+	queryMisses++;
+	queryParseSeconds += took.count();
+	// once closed, nothing is kept that would hold the world
+	if ( ! closed && queryIndex.find( key ) == queryIndex.end() )
+	{
+		queries.push_front( PreparedQuery{ key, query } );
+		queryIndex[ key ] = queries.begin();
+		if ( queries.size() > QueryCacheSize )
+		{
+			queryIndex.erase( queries.back().key );
+			queries.pop_back();
+		}
+	}
+	return query;
+}
+
+// ----------------------------------------------------------------------------
+
+QueryCacheStats
+_World::queryCacheStats() const
+{
+	std::lock_guard< std::mutex > guard( queryLock );
+	QueryCacheStats stats;
+	stats.hits = queryHits;
+	stats.misses = queryMisses;
+	stats.size = queries.size();
+	stats.parseSeconds = queryParseSeconds;
+	return stats;
+}
+
+// ----------------------------------------------------------------------------
+
 Serializer
 _World::defaultSerializer()
 {
+	if ( closed )
+		return Serializer( new _Serializer( shared_from_this() ));
 	if ( defSerializer == nullptr )
 	{
 		World w = shared_from_this();
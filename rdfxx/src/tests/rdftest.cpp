@@ -24,9 +24,18 @@
 #include <cfi/xini.h>
 #include "rdfxx/except.h"
 #include "rdfxx/rdfxx.h"
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#include <fcntl.h>
 #include <unistd.h>
 
 using namespace std;
@@ -44,6 +53,17 @@ const string SASSY::cfi::XINI::config =
 		"$SASSY/share/sassy/sassy.xml:"
 		"$SASSY/sassy.xml";
 
+// ------------------------------------------------------------
+
+// static
+// A path in the temporary directory that is unique to this run.  Each
+// test removes the files it made once it is done with them.
+static string tempPath( const string & name )
+{
+	const char * dir = getenv( "TMPDIR" );
+	return string( dir && *dir ? dir : "/tmp" ) + "/rdftest-"
+		+ to_string( getpid() ) + "-" + name;
+}
 
 // ------------------------------------------------------------
 //	URITestCase
@@ -90,6 +110,8 @@ URITestCase::runTest()
 		rev_uri_map[uri] = 4;
 		rc = rc && test( uri_map[1] == uri, "uri 3.0.1");
 		rc = rc && test( rev_uri_map[uri] == 4, "uri 3.0.2");
+		rc = rc && test( rev_uri_map[uri2] == 4 && std::hash< URI >()( uri ) == uri2->hash(),
+					"uri 3.0.3");
 
 		// removal of fragment
 		URI uri_frag(world,"http://purl.org/dc/0.1/title#stuff");
@@ -133,6 +155,15 @@ URITestCase::runTest()
 		URI uri7( world, Concept::label );
 		rc = rc && test( prefixes.prefixForm( uri7) == "rdfs:label", "uri 13");
 
+		// views of the characters, and the namespace split
+		rc = rc && test( uri_frag->view() == "http://purl.org/dc/0.1/title#stuff", "uri 14");
+		rc = rc && test( uri_frag->nameSpace() == "http://purl.org/dc/0.1/title#"
+				&& uri_frag->localName() == "stuff", "uri 15");
+		rc = rc && test( uri3->nameSpace() == "http://purl.org/dc/0.1/"
+				&& uri3->localName() == "fruit", "uri 16");
+		rc = rc && test( uri->localName().empty() && prefixes.find( uri_frag ) == "cd",
+				"uri 17");
+
 
 		cout << "---------- end URI tests -------------" << endl;
 	}
@@ -187,6 +218,52 @@ PrefixTestCase::runTest()
 				== "http://www.w3.org/2001/XMLSchema#int", "prefix 3" );
 	rc = rc && test( prefixes.prefixForm( URI( world, "http://www.w3.org/2001/XMLSchema#float"))
 				== "xsd:float", "prefix 4");
+
+	// conversions on strings in place
+	string out;
+	string full( "http://purl.org/dc/elements/1.1/creator" );
+	prefixes.prefixForm( full.data(), full.size(), out );
+	rc = rc && test( out == "dc:creator", "prefix 4.1");
+	out.clear();
+	rc = rc && test( prefixes.uriForm( "dc:creator", 10, out ) && out == full, "prefix 4.2");
+	out.clear();
+	rc = rc && test( ! prefixes.uriForm( "nosuch:x", 8, out ) && out.empty(), "prefix 4.3");
+	string other( "http://example.com/unknown#thing" );
+	prefixes.prefixForm( other.data(), other.size(), out );
+	rc = rc && test( out == other, "prefix 4.4");
+	prefixes.insert( "dc2", URI( world, "http://purl.org/dc/elements/1.1/" ));
+	rc = rc && test( prefixes.prefixForm( URI( world, full )) == "dc2:creator", "prefix 4.5");
+	prefixes.remove( "dc2" );
+	prefixes.insert( "dc", URI( world, "http://purl.org/dc/elements/1.1/" ));
+	rc = rc && test( prefixes.prefixForm( URI( world, full )) == "dc:creator", "prefix 4.6");
+
+	// a pool gives each thread its own world with the shared prefixes
+	WorldPool & pool = Universe::instance().pool("test pool");
+	pool.sharePrefix( "ex", "http://example.org/ns#" );
+	World w1 = pool.world();
+	rc = rc && test( w1 == pool.world() && w1 != world, "prefix 5");
+	World w2;
+	std::thread t( [&pool, &w2]() { w2 = pool.world(); } );
+	t.join();
+	rc = rc && test( w2 && w2 != w1 && pool.size() == 2, "prefix 6");
+	rc = rc && test( w2->prefixes().prefixForm( URI( w2, "http://example.org/ns#a"))
+				== "ex:a", "prefix 7");
+	pool.sharePrefix( "ex2", "http://example.org/two#" );
+	rc = rc && test( pool.world()->prefixes().prefixForm( URI( w1, "http://example.org/two#b"))
+				== "ex2:b", "prefix 8");
+
+	// a thread that releases its world leaves the pool as it found it
+	size_t during = 0;
+	bool fresh = false;
+	std::thread t2( [&pool, &during, &fresh]() {
+		World w = pool.world();
+		during = pool.size();
+		pool.release();
+		fresh = pool.world() != w;
+		pool.release();
+	} );
+	t2.join();
+	rc = rc && test( during == 3 && fresh && pool.size() == 2, "prefix 9");
 	return rc;
 }
 
@@ -275,6 +352,88 @@ NodeTestCase::runTest()
 		ResourceNode nc1(world, Concept::type );
 		rc = rc && test( nc1->toString(format) == "rdf:type", "node 19");
 
+		// interning
+		InternStats before = world->internStats();
+		ResourceNode ni1 = world->intern( "http://purl.org/dc/0.1/title" );
+		ResourceNode ni2 = world->intern( "http://purl.org/dc/0.1/title" );
+		InternStats after = world->internStats();
+		rc = rc && test( ni1.get() == ni2.get(), "node 20");
+		rc = rc && test( after.hits + after.misses == before.hits + before.misses + 2
+					&& after.hits > before.hits, "node 21");
+		rc = rc && test( ni1->toURI() == n1->toURI(), "node 22");
+
+		// equality, ordering and hashing by value
+		Node v1 = n1, v2 = ni1, v3 = n3, v4 = n7, v5 = n2;
+		rc = rc && test( v1.get() != v2.get() && v1 == v2, "node 23");
+		rc = rc && test( std::hash< Node >()( v1 ) == std::hash< Node >()( v2 ), "node 24");
+		rc = rc && test( v3 != v1 && !( v1 < v2 ) && !( v2 < v1 ), "node 25");
+		rc = rc && test( v1 < v5 && v5 < v3, "node 26");
+		rc = rc && test( ( v3 < v4 ) != ( v4 < v3 ), "node 27");
+
+		unordered_set< Node > node_set;
+		node_set.insert( v1 );
+		node_set.insert( v2 );
+		node_set.insert( v3 );
+		node_set.insert( Node( LiteralNode( world, Literal("fred") )));
+		rc = rc && test( node_set.size() == 2, "node 28");
+		map< Node, int > node_order;
+		node_order[v3] = 3;
+		node_order[v1] = 1;
+		rc = rc && test( node_order.begin()->second == 1, "node 29");
+
+		// rendering into a reusable buffer and onto streams
+		string buffer;
+		n8->appendTo( buffer );
+		buffer += ' ';
+		n6->appendTo( buffer );
+		rc = rc && test( buffer == "<http://organise.org/ofw/0.4/categories/documents> \"fred\"@en",
+					"node 30");
+		ostringstream node_out;
+		node_out << n8 << ' ' << Node( n6 ) << ' ' << uri;
+		rc = rc && test( node_out.str() == buffer + " " + uri->toString(), "node 31");
+		LiteralNode n10(world, Literal("tab\there \"quoted\"\n"));
+		rc = rc && test( n10->toString().find( "\"tab\\there \\\"quoted\\\"\\n\"" ) == 0,
+					"node 32");
+
+		// blank nodes from the world's factory
+		BlankNode nb1 = world->newBlankNode();
+		BlankNode nb2 = world->newBlankNode();
+		rc = rc && test( nb1->isBlank() && nb1->toString() != nb2->toString(), "node 33");
+		string other;
+		std::thread bt( [&other]() {
+			World tw = Universe::instance().pool("test pool").world();
+			other = tw->newBlankNode()->toString();
+		} );
+		bt.join();
+		rc = rc && test( ! other.empty() && other != nb1->toString()
+					&& other != nb2->toString(), "node 34");
+
+		// a world's caches let go of it when the last handle goes
+		NodeRef interned;
+		std::weak_ptr< Query_ > prepared;
+		{
+			WorldPool pool( "intern test" );
+			World pw = pool.world();
+			interned = pw->intern( "http://example.org/interned" );
+			Query pq = pw->preparedQuery( "ASK { ?s ?p ?o }" );
+			prepared = pq;
+		}
+		rc = rc && test( interned.expired(), "node 35");
+		rc = rc && test( prepared.expired(), "node 36");
+
+		// typed handles compare by value, like Node
+		ResourceNode r1( world, URI( world, "http://example.org/same" ));
+		ResourceNode r2( world, URI( world, "http://example.org/same" ));
+		LiteralNode l1( world, Literal( "same" ));
+		LiteralNode l2( world, Literal( "same" ));
+		rc = rc && test( r1 == r2 && ! ( r1 != r2 ) && r1 == Node( r2 ) && Node( r1 ) == r2
+				&& l1 == l2 && l1 != LiteralNode( world, Literal( "other" )), "node 37");
+
+		// nulls are equal to each other and to nothing else, for every type
+		rc = rc && test( Node() == Node() && Node() != Node( r1 )
+				&& URI() == URI() && URI() != URI( world, "http://example.org/same" )
+				&& Statement() == Statement(), "node 38");
+
 		cout << "------------------ end nodes --------------" << endl;
 	}
 	catch( vx & e )
@@ -374,6 +533,34 @@ StmntTestCase::runTest()
 		map< int, Statement > stmnt_map;
 		stmnt_list.push_back(s2);
 		stmnt_map[3] = s3;
+
+		// by value, so a copy is the same key
+		rc = rc && test( s3.get() != s1.get() && s3->hash() == s1->hash(), "stmnt 13");
+		rc = rc && test( s2 != s1 && ( s2 < s1 ) != ( s1 < s2 ), "stmnt 14");
+		unordered_map< Statement, int > stmnt_counts;
+		stmnt_counts[s1]++;
+		stmnt_counts[s3]++;
+		rc = rc && test( stmnt_counts.size() == 1 && stmnt_counts[s1] == 2, "stmnt 15");
+
+		string line;
+		s1->appendTo( line );
+		ostringstream stmnt_out;
+		stmnt_out << s1;
+		rc = rc && test( line == s1->toString() && stmnt_out.str() == line, "stmnt 16");
+
+		// moving nodes into statements
+		Node ms( ResourceNode(world, uri) );
+		Node mp( n3 );
+		Node mo( LiteralNode(world, Literal("moron")) );
+		Statement s4 = Statement::build( world, std::move(ms), std::move(mp), std::move(mo) );
+		rc = rc && test( ! ms && ! mp && ! mo && s4->isComplete(), "stmnt 17");
+		rc = rc && test( s4 == s1 && n3->toString() == "<http://purl.org/dc/0.1/title>",
+					"stmnt 18");
+		Statement s5(world);
+		s5->subject( Node( ResourceNode(world, uri) ));
+		s5->predicate( n3 );
+		s5->object( Node( s1->object() ));
+		rc = rc && test( s5 == s1 && n3->isResource(), "stmnt 19");
 	}
 	catch( vx & e )
 	{
@@ -447,6 +634,116 @@ ModelTestCase::runTest()
 			x->next();
 		}
 
+		// bulk loading
+		Model m2(world,"memory");
+		vector< Triple > triples = { { n1, n2, n3 }, { n1, n2, n4 }, { n1, n2, n3 } };
+		AddCounts ac = m2->addAll( triples );
+		rc = rc && test( ac.ok && ac.offered == 3 && m2->size() == 2, "model 15");
+		rc = rc && test( ac.inserted == 2 && ac.duplicates == 1, "model 16");
+
+		ac = m2->addAll( m1->toStream() );
+		rc = rc && test( ac.ok && ac.offered == 2 && ac.duplicates == 2, "model 17");
+
+		vector< Statement > stmnts = { s1, s2 };
+		m2->remove( s2 );
+		ac = m2->addAll( stmnts.begin(), stmnts.end() );
+		rc = rc && test( ac.inserted == 1 && m2->contains( s2 ), "model 18");
+
+		// pattern matching
+		int count = 0;
+		for ( auto & st : m2->find( n1, nullptr, nullptr ))
+		{
+			rc = rc && test( m2->contains( st ), "model 19");
+			count++;
+		}
+		rc = rc && test( count == 2, "model 20");
+
+		count = 0;
+		for ( auto & st : m2->find( nullptr, nullptr, n4 ))
+		{
+			rc = rc && test( *st == s2, "model 21");
+			count++;
+		}
+		rc = rc && test( count == 1, "model 22");
+
+		// navigation ranges
+		rc = rc && test( m2->objectsRange( n1, n2 ).count() == 2, "model 23");
+		rc = rc && test( ! m2->subjectsRange( n2, n1 ).any(), "model 24");
+		Node pred = m2->arcsOutRange( n1 ).first();
+		rc = rc && test( pred && pred->toString() == n2->toString(), "model 25");
+		count = 0;
+		for ( auto & obj : m2->objectsRange( n1, n2 ))
+		{
+			rc = rc && test( obj->isLiteral(), "model 26");
+			count++;
+		}
+		rc = rc && test( count == 2, "model 27");
+
+		// term views, without making nodes
+		count = 0;
+		StatementRange found = m2->find( n1, nullptr, n4 );
+		for ( auto it = found.begin(); it != found.end(); ++it )
+		{
+			TripleView t = it.triple();
+			rc = rc && test( t.isComplete() && t.subject().isResource()
+					&& t.subject().value() == uri->toString()
+					&& t.object().isLiteral()
+					&& t.object().value() == "a different literal value", "model 28");
+			rc = rc && test( t.object().hash() == std::hash< Node >()( Node( n4 ))
+					&& t.toStatement( world ) == s2, "model 29");
+			count++;
+		}
+		rc = rc && test( count == 1, "model 30");
+
+		Stream sv = m2->toStream();
+		TripleView tv = sv->triple();
+		rc = rc && test( tv.predicate().iri() == "http://purl.org/dc/0.1/title"
+				&& tv.predicate().language().empty() && tv.object().iri().empty(),
+				"model 31");
+
+		// streams as ranges and in batches
+		count = 0;
+		for ( auto & st : m2->toStream() )
+		{
+			rc = rc && test( m2->contains( st ), "model 32");
+			count++;
+		}
+		rc = rc && test( count == 2, "model 33");
+
+		Stream sb = m2->toStream();
+		TripleView batch[4];
+		size_t n = sb->nextBatch( batch, 1 );
+		n += sb->nextBatch( batch + 1, 3 );
+		rc = rc && test( n == 2 && sb->end() && sb->nextBatch( batch, 4 ) == 0, "model 34");
+		sb = m2->toStream();
+		n = sb->nextBatch( batch, 4 );
+		rc = rc && test( n == 2 && m2->contains( batch[0].toStatement( world ))
+				&& m2->contains( batch[1].toStatement( world ))
+				&& !( batch[0] == batch[1] ), "model 35");
+
+		// copies kept from a range keep their values
+		vector< Statement > kept;
+		for ( auto & st : m2->toStream() )
+			kept.push_back( st );
+		rc = rc && test( kept.size() == 2 && kept[0] != kept[1]
+				&& m2->contains( kept[0] ) && m2->contains( kept[1] )
+				&& !( *kept[0] == kept[1] ), "model 36");
+		vector< Node > objs;
+		for ( auto & obj : m2->objectsRange( n1, n2 ))
+			objs.push_back( obj );
+		rc = rc && test( objs.size() == 2 && objs[0] != objs[1]
+				&& objs[0]->toString() != objs[1]->toString(), "model 37");
+
+		// an incomplete statement is refused from a source, as from a vector
+		bool refused = false;
+		int left = 1;
+		try
+		{
+			m2->addAll( StatementSource( [this, &left]() -> Statement
+				{ return left-- > 0 ? Statement( world ) : Statement(); } ));
+		}
+		catch ( vx & ) { refused = true; }
+		rc = rc && test( refused && m2->size() == 2, "model 38");
 
 	}
 	catch( vx & e )
@@ -482,6 +779,8 @@ bool
 StoreTestCase::runTest()
 {
 	bool rc = true;
+	const string snapFile = tempPath( "store.snap" );
+	const string badFile = tempPath( "store-bad.snap" );
 	
 	std::map< string, Model > models;
 
@@ -510,7 +809,114 @@ StoreTestCase::runTest()
 	// cout << "Found " << count << " statements" << endl;
 	rc = rc && test( count = 188, "store 2");
 
-	
+	// the native store should hold the same statements
+	try {
+		Model source( models.begin()->second );
+		Model col(world, "rdfxx-columnar");
+		AddCounts ac = col->addAll( source->toStream() );
+		rc = rc && test( ac.ok && col->size() == source->size(), "store 3");
+
+		bool all = true;
+		for ( auto & st : source->find( nullptr, nullptr, nullptr ))
+			all = all && col->contains( st );
+		rc = rc && test( all, "store 4");
+
+		Statement first = ( *col->find( nullptr, nullptr, nullptr ).begin() )->copy();
+		Node subj( first->subject() );
+		Node pred( first->predicate() );
+		int n = 0;
+		for ( auto & st : col->find( subj, pred, nullptr ))
+		{
+			rc = rc && test( source->contains( st ), "store 5");
+			n++;
+		}
+		rc = rc && test( n == col->objectsRange( subj, pred ).count(), "store 6");
+
+		int before = col->size();
+		rc = rc && test( col->remove( first ) && col->size() == before - 1, "store 7");
+		rc = rc && test( ! col->contains( first ), "store 8");
+		col->add( first );
+		rc = rc && test( col->size() == before, "store 9");
+
+		// removals are applied together, and must not leak back in
+		std::vector< Statement > gone;
+		size_t half = before / 2;
+		for ( auto & st : col->find( nullptr, nullptr, nullptr ))
+			if ( gone.size() < half )
+				gone.push_back( st->copy() );
+		bool removed = true;
+		for ( auto & st : gone )
+			removed = removed && col->remove( st );
+		all = removed && col->size() == before - (int)gone.size();
+		for ( auto & st : gone )
+			all = all && ! col->contains( st );
+		for ( auto & st : gone )
+			col->add( st );
+		rc = rc && test( all && col->size() == before, "store 10");
+
+		QueryString qs;
+		qs.setVariables("?s ?p ?o");
+		qs.addCondition("?s ?p ?o");
+		Query q( world, qs );
+		int rows = 0;
+		for ( auto &r : *q->execute( col ))
+		{
+			(void)r;
+			rows++;
+		}
+		rc = rc && test( rows == col->size(), "store 11");
+
+		// snapshots
+		source->saveSnapshot( snapFile );
+		Model snap = Model::openSnapshot( world, snapFile );
+		rc = rc && test( snap->size() == source->size(), "store 12");
+		all = true;
+		for ( auto & st : source->find( nullptr, nullptr, nullptr ))
+			all = all && snap->contains( st );
+		for ( auto & st : snap->find( nullptr, nullptr, nullptr ))
+			all = all && source->contains( st );
+		rc = rc && test( all, "store 13");
+		rc = rc && test( snap->objectsRange( subj, pred ).count() == n, "store 14");
+
+		// a header that points outside the file is refused, not mapped
+		{
+			std::ifstream in( snapFile, std::ios::binary );
+			std::ofstream out( badFile, std::ios::binary | std::ios::trunc );
+			out << in.rdbuf();
+			uint64_t terms = uint64_t(1) << 40;
+			out.seekp( 16 );	// after the magic, version and byte order
+			out.write( reinterpret_cast< const char * >( &terms ), sizeof( terms ));
+		}
+		bool refused = false;
+		try { Model::openSnapshot( world, badFile ); }
+		catch ( vx & ) { refused = true; }
+		rc = rc && test( refused, "store 15");
+
+		// as is one whose triples name a term that is not there
+		{
+			std::ifstream in( snapFile, std::ios::binary );
+			std::fstream out( badFile,
+					std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc );
+			out << in.rdbuf();
+			uint64_t spoAt = 0;
+			out.seekg( 48 );	// the offset of the SPO index in the header
+			out.read( reinterpret_cast< char * >( &spoAt ), sizeof( spoAt ));
+			uint32_t bad = 0xffffffff;
+			out.seekp( spoAt );
+			out.write( reinterpret_cast< const char * >( &bad ), sizeof( bad ));
+		}
+		refused = false;
+		try { Model::openSnapshot( world, badFile ); }
+		catch ( vx & ) { refused = true; }
+		rc = rc && test( refused, "store 16");
+	}
+	catch( vx & e )
+	{
+		rc = test( false, e.what());
+	}
+
+	::remove( snapFile.c_str() );
+	::remove( badFile.c_str() );
 	return rc;
 }
 
@@ -540,6 +946,11 @@ bool
 IOTestCase::runTest()
 {
 	bool rc = true;
+	const string rdfFile = tempPath( "io.rdf" );
+	const string ntFile = tempPath( "io.nt" );
+	const string bigFile = tempPath( "io-big.nt" );
+	const string skolemFile = tempPath( "skolem.nt" );
+	const string skolemFile2 = tempPath( "skolem2.nt" );
 
 	try {
 		string fn( rdfFiles.front() );
@@ -550,7 +961,7 @@ IOTestCase::runTest()
 		URI uri(world, string("file://") + fn + "#" );
 		ser->setNamespace( uri, "bross");
 		ser->setNamespace( world->prefixes().find("rdfs"), "rdfs");
-		bool res = ser->toFile( "/tmp/iotest.rdf", m1, uri );
+		bool res = ser->toFile( rdfFile, m1, uri );
 		rc = rc && test( res, "io 3");
 
 		cout << "Parser list" << endl;
@@ -563,7 +974,7 @@ IOTestCase::runTest()
 		Model m2(world,"memory" );
 		Parser p(world, "rdfxml" );
 		URI base(world, "file://tmp/");
-		URI local(world, "file:///tmp/iotest.rdf");
+		URI local(world, "file://" + rdfFile );
 		p->parseIntoModel(m2, local, base );
 		rc = rc && test( true, "io 5");
 
@@ -576,12 +987,130 @@ IOTestCase::runTest()
 			rc = rc && test( m2->contains( x->current()), "io 7");
 			x->next();
 		}
+
+		// parallel load of N-Triples
+		Serializer nts( world, "ntriples" );
+		res = nts->toFile( ntFile, m1 );
+		rc = rc && test( res, "io 8");
+
+		Model m3( world, "memory" );
+		Parser ntp( world, "ntriples" );
+		URI ntfile( world, "file://" + ntFile );
+		AddCounts counts = ntp->parseIntoModelParallel( m3, ntfile, base, 4 );
+		rc = rc && test( counts.ok, "io 9");
+		rc = rc && test( m3->size() == m1->size(), "io 10");
+		rc = rc && test( counts.inserted == m1->size(), "io 11");
+
+		Model m4( world, "memory" );
+		ntp->parseIntoModel( m4, ntfile, base );
+		rc = rc && test( m3->size() == m4->size(), "io 12");
+
+		// other syntaxes fall back to parsing on one thread
+		Model m5( world, "memory" );
+		counts = p->parseIntoModelParallel( m5, local, base, 4 );
+		rc = rc && test( counts.ok && m5->size() == m2->size(), "io 13");
+
+		// pipelined parse and insert
+		Model m6( world, "memory" );
+		IngestStats stats = m6->ingest( p, local, base );
+		rc = rc && test( stats.counts.ok, "io 14");
+		rc = rc && test( m6->size() == m2->size(), "io 15");
+		rc = rc && test( stats.counts.offered >= m6->size() && stats.batches > 0
+				&& stats.counts.inserted == m6->size()
+				&& stats.counts.inserted + stats.counts.duplicates == stats.counts.offered, "io 16");
+
+		// skolemised blank nodes are the same on every parse
+		{
+			ofstream out( skolemFile );
+			out << "_:a <http://example.org/knows> _:b .\n"
+			    << "_:b <http://example.org/knows> _:a .\n"
+			    << "_:a <http://example.org/name> \"a\" .\n";
+		}
+		auto blanks = []( Model m ) {
+			int n = 0;
+			for ( auto & st : m->toStream() )
+				if ( st->subject().lock()->isBlank() || st->object().lock()->isBlank() )
+					n++;
+			return n;
+		};
+		Parser sp( world, "ntriples" );
+		sp->skolemise( "http://example.org/.well-known/genid/" );
+		URI sfile( world, "file://" + skolemFile );
+		Model s1( world, "memory" );
+		Model s2( world, "memory" );
+		rc = rc && test( sp->parseIntoModel( s1, sfile, base )
+				&& sp->parseIntoModel( s2, sfile, base ), "io 17");
+		rc = rc && test( s1->size() == 3 && s2->size() == 3 && blanks( s1 ) == 0, "io 18");
+		for ( auto & st : s1->toStream() )
+			rc = rc && test( s2->contains( st ), "io 19");
+
+		Model s3( world, "memory" );
+		stats = s3->ingest( sp, sfile, base );
+		rc = rc && test( stats.counts.ok && s3->size() == 3 && blanks( s3 ) == 0, "io 20");
+		for ( auto & st : s1->toStream() )
+			rc = rc && test( s3->contains( st ), "io 21");
+
+		Model s4( world, "memory" );
+		counts = sp->parseIntoModelParallel( s4, sfile, base, 2 );
+		rc = rc && test( counts.ok && s4->size() == 3 && blanks( s4 ) == 0, "io 22");
+		bool same = true;
+		for ( auto & st : s1->toStream() )
+			same = same && s4->contains( st );
+		rc = rc && test( same, "io 23");
+
+		// another document with the same labels and base has its own nodes
+		{
+			ofstream out( skolemFile2 );
+			out << "_:a <http://example.org/knows> _:b .\n";
+		}
+		URI sfile2( world, "file://" + skolemFile2 );
+		rc = rc && test( sp->parseIntoModel( s1, sfile2, base ) && s1->size() == 4, "io 24");
+
+		// a file of many chunks, with blank nodes used on both sides of
+		// every chunk boundary
+		const int lines = 40000;
+		{
+			ofstream out( bigFile );
+			for ( int i = 0; i < lines; i++ )
+			{
+				out << "_:b" << i % 500 << " <http://example.org/value> \"value " << i << "\" .\n";
+				if ( i % 10 == 0 )
+					out << "_:hub <http://example.org/item> <http://example.org/item/" << i << "> .\n";
+			}
+			rc = rc && test( out.tellp() > 16 * 64 * 1024, "io 25");
+		}
+		auto subjects = []( Model m ) {
+			unordered_set< string > ids;
+			for ( auto & st : m->toStream() )
+				if ( st->subject().lock()->isBlank() )
+					ids.insert( st->subject().lock()->toString() );
+			return ids.size();
+		};
+		URI bigfile( world, "file://" + bigFile );
+		Model b1( world, "memory" );
+		Model b2( world, "memory" );
+		ntp->parseIntoModel( b1, bigfile, base );
+		counts = ntp->parseIntoModelParallel( b2, bigfile, base, 4 );
+		rc = rc && test( counts.ok && b2->size() == lines + lines / 10
+				&& b2->size() == b1->size(), "io 26");
+		rc = rc && test( subjects( b2 ) == 501 && subjects( b1 ) == 501, "io 27");
+
+		Model b3( world, "memory" );
+		Model b4( world, "memory" );
+		sp->parseIntoModel( b3, bigfile, base );
+		counts = sp->parseIntoModelParallel( b4, bigfile, base, 4 );
+		same = counts.ok && b4->size() == b3->size() && blanks( b4 ) == 0;
+		for ( auto & st : b3->toStream() )
+			same = same && b4->contains( st );
+		rc = rc && test( same, "io 28");
 	}
 	catch( vx & e )
 	{
 		rc = test( false, e.what());
 	}
 
+	for ( auto & f : { rdfFile, ntFile, bigFile, skolemFile, skolemFile2 } )
+		::remove( f.c_str() );
 	return rc;
 }
 
@@ -611,6 +1140,7 @@ bool
 QueryTestCase::runTest()
 {
 	bool rc = true;
+	const string tsvFile = tempPath( "results.tsv" );
 
 	try {
 		string fn( rdfFiles.front() );
@@ -660,12 +1190,203 @@ QueryTestCase::runTest()
 		}
 		rc = rc && test( count == 48, "query 2");
 
+		count = 0;
+		QueryResults qr2 = q->execute(m1);
+		for( auto &x : *qr2 )
+		{
+			TermView label = x.boundView( "label" );
+			if ( label && label.isLiteral() && label == x.boundView( 0 )
+					&& label.value() == LiteralNode( x.getBoundValue( 0 ))->toLiteral().asString() )
+				count++;
+		}
+		rc = rc && test( count == 48, "query 3");
+
+		// prepared queries are parsed once and reused when free
+		QueryCacheStats before = world->queryCacheStats();
+		Query_ *first = nullptr;
+		{
+			Query pq = world->preparedQuery( ts );
+			first = pq.get();
+			QueryResults pqr = pq->execute( m1 );
+			count = 0;
+			for( auto &x : *pqr )
+				if ( x.count() == 1 ) count++;
+			rc = rc && test( count == 48, "query 4");
+		}
+		Query pq2 = world->preparedQuery( "  " + ts + "\n" );
+		QueryCacheStats after = world->queryCacheStats();
+		rc = rc && test( pq2.get() == first && after.hits == before.hits + 1
+				&& after.misses == before.misses + 1, "query 5");
+		Query pq3 = world->preparedQuery( ts );
+		rc = rc && test( pq3.get() != first
+				&& world->queryCacheStats().misses == after.misses + 1, "query 6");
+		QueryResults pqr2 = pq2->execute( m1 );
+		count = 0;
+		for( auto &x : *pqr2 )
+			if ( x.count() == 1 ) count++;
+		rc = rc && test( count == 48 && after.size > 0 && after.hitRate() > 0, "query 7");
+
+		// parameters bound to values instead of spliced into the text
+		vector< Node > labelled;
+		QueryResults xr = Query( world, "PREFIX rdfs: <http://www.w3.org/2000/01/rdf-schema#>\n"
+				"SELECT DISTINCT ?x WHERE { ?x rdfs:label ?l }" )->execute( m1 );
+		for( auto &x : *xr )
+		{
+			Node xn = x.getBoundValue( "x" );
+			if ( xn->isResource() && labelled.size() < 2 )
+				labelled.push_back( xn );
+		}
+		QueryString ps;
+		ps.addPrefix("rdfs", "http://www.w3.org/2000/01/rdf-schema#");
+		ps.setVariables("?label $x");
+		ps.addCondition("$x rdfs:label ?label");
+		Query lq = world->preparedQuery( ps );
+		int counts[2] = { 0, 0 };
+		size_t cached = world->queryCacheStats().size;
+		for ( int i = 0; i < (int)labelled.size(); i++ )
+		{
+			lq->bind( "x", labelled[i] );
+			QueryResults lr = lq->execute( m1 );
+			for( auto &x : *lr )
+				if ( x.getBoundValue( "x" ) == labelled[i] ) counts[i]++;
+		}
+		// a repeated value reuses the query parsed for it
+		int again = 0;
+		if ( ! labelled.empty() )
+		{
+			lq->bind( "x", labelled[0] );
+			for( auto &x : *lq->execute( m1 ))
+				if ( x.getBoundValue( "x" ) == labelled[0] ) again++;
+		}
+		rc = rc && test( labelled.size() == 2 && counts[0] > 0 && counts[1] > 0
+				&& again == counts[0]
+				&& world->queryCacheStats().size == cached, "query 8");
+
+		bool thrown = false;
+		try { lq->bind( "nosuch", world->intern( "http://example.org/x" )); }
+		catch( vx & ) { thrown = true; }
+		rc = rc && test( thrown, "query 9");
+
+		// one query for a batch of values
+		lq->clearBindings();
+		count = -1;
+		if ( labelled.size() == 2 )
+		{
+			QueryResults br = lq->executeBatch( m1,
+				{ Bindings{ { "x", labelled[0] } }, Bindings{ { "x", labelled[1] } } } );
+			count = 0;
+			for( auto &x : *br )
+			{
+				Node xn = x.getBoundValue( "x" );
+				if ( xn == labelled[0] || xn == labelled[1] ) count++;
+			}
+		}
+		rc = rc && test( count == counts[0] + counts[1], "query 10");
+
+		// results drained into columns
+		QueryResults tr = Query( world, ts )->execute( m1 );
+		ResultTable table = tr->toTable();
+		int lc = table.column( "label" );
+		rc = rc && test( table.rows() == 48 && table.width() == 1 && lc == 0
+				&& table.column( "nosuch" ) == -1, "query 11");
+		count = 0;
+		for ( auto & v : table.values( lc ))
+			if ( v.isLiteral() ) count++;
+		rc = rc && test( count == 48 && tr->begin() == tr->end(), "query 12");
+		const vector< TypedValue > & typed = table.typedValues( lc );
+		rc = rc && test( typed.size() == 48 && typed[0].kind != TypedValue::Kind::Invalid,
+					"query 13");
+
+		// results written as they are read
+		auto lines = []( const string & text, const string & of ) {
+			int n = 0;
+			for ( size_t at = text.find( of ); at != string::npos; at = text.find( of, at + 1 ))
+				n++;
+			return n;
+		};
+		ostringstream xml_out, json_out, csv_out, tsv_out;
+		Query( world, ts )->execute( m1 )->writeTo( xml_out, ResultFormat::XML );
+		Query( world, ts )->execute( m1 )->writeTo( json_out, ResultFormat::JSON );
+		Query( world, ts )->execute( m1 )->writeTo( csv_out, ResultFormat::CSV );
+		Query( world, ts )->execute( m1 )->writeTo( tsv_out, ResultFormat::TSV );
+		rc = rc && test( lines( xml_out.str(), "<result>" ) == 48
+				&& lines( xml_out.str(), "<variable name=\"label\"/>" ) == 1, "query 14");
+		rc = rc && test( lines( json_out.str(), "\"type\": \"literal\"" ) == 48
+				&& json_out.str().find( "\"vars\": [ \"label\" ]" ) != string::npos, "query 15");
+		rc = rc && test( lines( csv_out.str(), "\r\n" ) == 49
+				&& csv_out.str().compare( 0, 7, "label\r\n" ) == 0, "query 16");
+		rc = rc && test( lines( tsv_out.str(), "\n" ) == 49
+				&& tsv_out.str().compare( 0, 7, "?label\n" ) == 0, "query 17");
+
+		int fd = open( tsvFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+		Query( world, ts )->execute( m1 )->writeTo( fd, ResultFormat::TSV );
+		close( fd );
+		ifstream tsv_in( tsvFile );
+		string tsv_file( ( istreambuf_iterator< char >( tsv_in )), istreambuf_iterator< char >() );
+		rc = rc && test( tsv_file == tsv_out.str(), "query 18");
+
+		// the results are used up by toString
+		QueryResults sr = Query( world, ts )->execute( m1 );
+		rc = rc && test( ! sr->toString().empty() && sr->begin() == sr->end(), "query 19");
+
+		// run on a library thread
+		std::future< ResultTable > af = Query( world, ts )->executeAsync( m1 );
+		ResultTable at = af.get();
+		rc = rc && test( at.rows() == 48 && at.column( "label" ) == 0, "query 20");
+
+		CancelToken token;
+		token.cancel();
+		std::future< ResultTable > cf = Query( world, ts )->executeAsync( m1, token );
+		thrown = false;
+		try { cf.get(); } catch ( vx & ) { thrown = true; }
+		rc = rc && test( thrown, "query 21");
+
+		std::future< ResultTable > df = Query( world, ts )->executeAsync( m1, CancelToken(),
+				std::chrono::steady_clock::now() - std::chrono::seconds( 1 ));
+		thrown = false;
+		try { df.get(); } catch ( vx & ) { thrown = true; }
+		rc = rc && test( thrown, "query 22");
+
+		// cancelled from another thread while a large result is drained
+		Model big( world, "memory" );
+		Node item = ResourceNode( world, URI( world, "http://example.org/item" ));
+		for ( int i = 0; i < 100; i++ )
+			big->add( ResourceNode( world, URI( world, "http://example.org/s/" + to_string( i ))),
+					item, LiteralNode( world, Literal( to_string( i ))));
+		// the worker waits at its 1000th check until the other thread
+		// has cancelled, so the cancel always lands mid-drain
+		CancelToken stop;
+		std::mutex stopLock;
+		std::condition_variable stopChanged;
+		bool reached = false;
+		stop.onCheck( [&]( unsigned long n ) {
+			if ( n != 1000 ) return;
+			std::unique_lock< std::mutex > guard( stopLock );
+			reached = true;
+			stopChanged.notify_all();
+			stopChanged.wait( guard, [&stop]() { return stop.cancelled(); } );
+		} );
+		std::thread canceller( [&]() {
+			std::unique_lock< std::mutex > guard( stopLock );
+			stopChanged.wait( guard, [&reached]() { return reached; } );
+			stop.cancel();
+			stopChanged.notify_all();
+		} );
+		std::future< ResultTable > bf = Query( world,
+				"SELECT ?a ?b WHERE { ?a <http://example.org/item> ?x . "
+				"?b <http://example.org/item> ?y }" )->executeAsync( big, stop );
+		thrown = false;
+		try { bf.get(); } catch ( vx & ) { thrown = true; }
+		canceller.join();
+		rc = rc && test( thrown && stop.checks() == 1000 && big->size() == 100, "query 23");
+
 	}
 	catch( vx & e )
 	{
 		rc = test( false, e.what());
 	}
 
+	::remove( tsvFile.c_str() );
 	return rc;
 }
 
@@ -741,6 +1462,58 @@ LiteralTestCase::runTest()
 		rc = rc && test( L5.dataTypeURI( world )->toString() 
 					== "http://www.w3.org/2001/XMLSchema#integer", "literal 27");
 
+		// typed values
+		rc = rc && test( Literal( 0.1, DataType::Double ).asString() == "0.1", "literal 28");
+		rc = rc && test( Literal( 1e22, DataType::Double ).asString() == "1.0E22", "literal 29");
+		rc = rc && test( Literal( 100.0, DataType::Decimal ).asString() == "100.0", "literal 30");
+		rc = rc && test( Literal( "300", DataType::Byte ).isValid() == false, "literal 31");
+		rc = rc && test( Literal( "18446744073709551615", DataType::UnsignedLong ).asUnsignedLong()
+					== 18446744073709551615ULL, "literal 32");
+		DecimalValue dv = Literal( " 12.500 ", DataType::Decimal ).asDecimal();
+		rc = rc && test( dv.digits == 125 && dv.scale == 1, "literal 33");
+		rc = rc && test( Literal( DecimalValue{ -5, 2 } ).asString() == "-0.05", "literal 34");
+
+		Literal L8( "2016-02-29T12:30:05.25+10:00", DataType::DateTime );
+		DateTimeValue dt = L8.asDateTime();
+		rc = rc && test( dt.day == 29 && dt.second == 5.25 && dt.timezone == 600, "literal 35");
+		rc = rc && test( Literal( dt, DataType::DateTime ).asString() == L8.asString(), "literal 36");
+		rc = rc && test( Literal( "2017-02-29", DataType::Data ).isValid() == false, "literal 37");
+		rc = rc && test( L8.compare( Literal( "2016-02-29T03:30:05.25+01:00",
+					DataType::DateTime )) == 0, "literal 38");
+
+		Literal L9( "P1Y2M3DT4H5M6.5S", DataType::Duration );
+		rc = rc && test( L9.asDuration().months == 14, "literal 39");
+		rc = rc && test( Literal( L9.asDuration(), DataType::Duration ).asString()
+					== L9.asString(), "literal 40");
+		rc = rc && test( Literal( "P1D", DataType::YearMonthDuration ).isValid() == false,
+					"literal 41");
+
+		rc = rc && test( Literal( "1", DataType::Integer ).compare(
+					Literal( 1.0, DataType::Double )) == 0, "literal 42");
+		rc = rc && test( Literal( "1.5", DataType::Decimal ).compare(
+					Literal( "2", DataType::Integer )) < 0, "literal 43");
+		rc = rc && test( Literal( "SGVsbG8=", DataType::Base64Binary ).asBinary() == "Hello",
+					"literal 44");
+		rc = rc && test( Literal::fromURI( "http://www.w3.org/2001/XMLSchema#unsignedInt", 44 )
+					== DataType::UnsignedInt, "literal 45");
+		rc = rc && test( Literal::toDataType( "rdf:HTML" ) == DataType::XHTML, "literal 46");
+		rc = rc && test( Literal::toDataType( "xsd:HTML" ) == DataType::UNDEF, "literal 47");
+		rc = rc && test( Literal::toXSD( DataType::NCName ) == "xsd:NCName", "literal 48");
+		rc = rc && test( Literal::asDataType( "day time duration" ) == DataType::DayTimeDuration,
+					"literal 49");
+		rc = rc && test( Literal( DateTimeValue{ 0, 0, 0, 12, 30, 5.1, false, 0 }, DataType::Time )
+					.asString() == "12:30:05.1", "literal 50");
+		Literal longDecimal( "123456789012345678901234.5678901234567890123", DataType::Decimal );
+		rc = rc && test( longDecimal.isValid()
+					&& longDecimal.asDouble() > 1.2345678e23, "literal 51");
+		rc = rc && test( Literal( 1e20, DataType::Decimal ).isValid()
+					&& ! Literal( "1.2.3", DataType::Decimal ).isValid(), "literal 52");
+		bool named = Literal::asDataType( "no such type" ) == DataType::UNDEF
+				&& Literal::asDataType( "" ) == DataType::UNDEF;
+		for ( auto & name : Literal::getDataTypeNames() )
+			named = named && Literal::toTypeName( Literal::asDataType( name )) == name;
+		rc = rc && test( named, "literal 53");
+
 		cout << "---------- end literal tests ---------- " << endl;
 	}
 	catch( vx & e )
@@ -863,6 +1636,31 @@ ConstructTestCase::runTest()
 		bool res = outModel->sync();
 		if ( ! res )
 			throw VX(rdf::Error) << "Failed to write model";
+
+		cout << "------------------ construct query --------------" << endl;
+		QueryResults cr = Query( world, "CONSTRUCT { ?s ?p ?o } WHERE { ?s ?p ?o }" )->execute( model );
+		rc = rc && test( cr->isGraph() && ! cr->isBindings(), "construct 1" );
+		Model copy( world, "memory" );
+		AddCounts counts = cr->intoModel( copy );
+		rc = rc && test( counts.ok && copy->size() == model->size(), "construct 2" );
+
+		QueryResults sr = Query( world, "CONSTRUCT { ?s ?p ?o } WHERE { ?s ?p ?o }" )->execute( model );
+		int n = 0;
+		for ( Stream cs = sr->asStream(); ! cs->end(); cs->next() )
+			++n;
+		rc = rc && test( n == model->size(), "construct 3" );
+
+		// the stream keeps the results, and they the query, so temporaries are safe
+		n = 0;
+		Stream ts = Query( world, "CONSTRUCT { ?s ?p ?o } WHERE { ?s ?p ?o }" )->execute( model )->asStream();
+		for ( ; ! ts->end(); ts->next() )
+			n += ts->current().expired() ? 0 : 1;
+		rc = rc && test( n == model->size(), "construct 6" );
+
+		QueryResults yes = Query( world, "ASK { ?s ?p ?o }" )->execute( model );
+		rc = rc && test( yes->isBoolean() && yes->asBoolean(), "construct 4" );
+		QueryResults no = Query( world, "ASK { ?s <http://example.org/none> ?o }" )->execute( model );
+		rc = rc && test( ! no->asBoolean(), "construct 5" );
 	}
 	catch( vx & xx )
 	{